@@ -0,0 +1,66 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "validation.h"
+
+#include <limits>
+#include <vector>
+
+// A full HEADERS message as received during header sync
+static const size_t HEADERS_COUNT = 2000;
+
+static std::vector<CBlockHeader> CreateHeaders()
+{
+    std::vector<CBlockHeader> headers(HEADERS_COUNT);
+    uint256 hashPrev = GetRandHash();
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nVersion = 0x20000000;
+        headers[i].hashPrevBlock = hashPrev;
+        headers[i].hashMerkleRoot = GetRandHash();
+        headers[i].nTime = 1550000000 + i * 150;
+        headers[i].nBits = 0x1a1e9f6d;
+        headers[i].nNonce = GetRand(std::numeric_limits<uint32_t>::max());
+        hashPrev = headers[i].GetHash();
+    }
+    return headers;
+}
+
+static void HeadersHash_Serial(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers = CreateHeaders();
+    while (state.KeepRunning()) {
+        for (const auto& header : headers) {
+            uint256 hash = header.GetHash();
+            (void)hash;
+        }
+    }
+}
+
+static void HeadersHash_Batch(benchmark::State& state)
+{
+    std::vector<CBlockHeader> headers = CreateHeaders();
+    while (state.KeepRunning()) {
+        std::vector<uint256> vHashes = CBlockHeader::GetHashes(headers);
+    }
+}
+
+static void HeadersHash_Parallel(benchmark::State& state)
+{
+    static bool fStarted = false;
+    if (!fStarted) {
+        StartHeaderHashThreads(4);
+        fStarted = true;
+    }
+    std::vector<CBlockHeader> headers = CreateHeaders();
+    while (state.KeepRunning()) {
+        std::vector<uint256> vHashes = HashBlockHeaders(headers);
+    }
+}
+
+BENCHMARK(HeadersHash_Serial);
+BENCHMARK(HeadersHash_Batch);
+BENCHMARK(HeadersHash_Parallel);
@@ -0,0 +1,89 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "arith_uint256.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "fs.h"
+#include "random.h"
+#include "txdb.h"
+#include "util.h"
+#include "validation.h"
+
+#include <vector>
+
+// Roughly a month of Dash blocks, enough to make the per-record cost dominate
+static const int NUM_BLOCK_INDEXES = 20000;
+
+static void BlockIndexLoad(benchmark::State& state, int nThreads)
+{
+    SelectParams(CBaseChainParams::MAIN);
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    // CBlockTreeDB derives its path from the datadir even when it lives in memory
+    fs::path pathTemp = fs::temp_directory_path() / strprintf("bench_dash_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000));
+    fs::create_directories(pathTemp);
+    ForceSetArg("-datadir", pathTemp.string());
+    ClearDatadirCache();
+
+    {
+        CBlockTreeDB blocktree(1 << 20, true);
+
+        // Build a chain of headers with stored hashes which pass the proof of work check
+        // at the minimum difficulty
+        unsigned int nBits = UintToArith256(consensusParams.powLimit).GetCompact();
+        std::vector<uint256> vHashes(NUM_BLOCK_INDEXES);
+        std::vector<CBlockIndex> vIndexes(NUM_BLOCK_INDEXES);
+        std::vector<const CBlockIndex*> vBlockInfo;
+        for (int i = 0; i < NUM_BLOCK_INDEXES; i++) {
+            vHashes[i] = GetRandHash();
+            *(vHashes[i].end() - 1) = 0;
+            *(vHashes[i].end() - 2) = 0;
+            *(vHashes[i].end() - 3) = 0;
+            CBlockIndex& index = vIndexes[i];
+            index.phashBlock = &vHashes[i];
+            index.pprev = i ? &vIndexes[i - 1] : NULL;
+            index.nHeight = i;
+            index.nTime = 1500000000 + i * 150;
+            index.nBits = nBits;
+            index.nTx = 1;
+            index.nStatus = BLOCK_VALID_TRANSACTIONS;
+            vBlockInfo.push_back(&index);
+        }
+        blocktree.WriteBatchSync(std::vector<std::pair<int, const CBlockFileInfo*> >(), 0, vBlockInfo);
+
+        while (state.KeepRunning()) {
+            BlockMap mapIndex;
+            auto insertBlockIndex = [&mapIndex](const uint256& hash) -> CBlockIndex* {
+                if (hash.IsNull())
+                    return NULL;
+                BlockMap::iterator mi = mapIndex.find(hash);
+                if (mi != mapIndex.end())
+                    return mi->second;
+                CBlockIndex* pindexNew = new CBlockIndex();
+                mi = mapIndex.insert(std::make_pair(hash, pindexNew)).first;
+                pindexNew->phashBlock = &mi->first;
+                return pindexNew;
+            };
+            bool ok = blocktree.LoadBlockIndexGuts(insertBlockIndex, nThreads, [&mapIndex](size_t nRecords) { mapIndex.reserve(nRecords + 1); });
+            assert(ok);
+            assert(mapIndex.size() == NUM_BLOCK_INDEXES);
+            for (auto& entry : mapIndex) {
+                delete entry.second;
+            }
+        }
+    }
+
+    ClearDatadirCache();
+    fs::remove_all(pathTemp);
+}
+
+static void BlockIndexLoad_1(benchmark::State& state) { BlockIndexLoad(state, 1); }
+static void BlockIndexLoad_4(benchmark::State& state) { BlockIndexLoad(state, 4); }
+static void BlockIndexLoad_16(benchmark::State& state) { BlockIndexLoad(state, 16); }
+
+BENCHMARK(BlockIndexLoad_1);
+BENCHMARK(BlockIndexLoad_4);
+BENCHMARK(BlockIndexLoad_16);
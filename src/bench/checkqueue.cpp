@@ -61,7 +61,7 @@ static void CCheckQueueSpeed(benchmark::State& state)
 // This Benchmark tests the CheckQueue with a slightly realistic workload,
 // where checks all contain a prevector that is indirect 50% of the time
 // and there is a little bit of work done between calls to Add.
-static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
+static void CCheckQueueSpeedPrevectorJobThreads(benchmark::State& state, int nThreads)
 {
     struct PrevectorJob {
         prevector<PREVECTOR_SIZE, uint8_t> p;
@@ -78,7 +78,7 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     };
     CCheckQueue<PrevectorJob> queue {QUEUE_BATCH_SIZE};
     boost::thread_group tg;
-    for (auto x = 0; x < std::max(MIN_CORES, GetNumCores()); ++x) {
+    for (auto x = 0; x < nThreads; ++x) {
        tg.create_thread([&]{queue.Thread();});
     }
     while (state.KeepRunning()) {
@@ -99,5 +99,26 @@ static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
     tg.interrupt_all();
     tg.join_all();
 }
+static void CCheckQueueSpeedPrevectorJob(benchmark::State& state)
+{
+    CCheckQueueSpeedPrevectorJobThreads(state, std::max(MIN_CORES, GetNumCores()));
+}
+
+// Scaling of the same workload with a fixed number of worker threads
+static void CCheckQueueSpeedPrevectorJob_1(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 1); }
+static void CCheckQueueSpeedPrevectorJob_2(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 2); }
+static void CCheckQueueSpeedPrevectorJob_4(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 4); }
+static void CCheckQueueSpeedPrevectorJob_8(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 8); }
+static void CCheckQueueSpeedPrevectorJob_16(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 16); }
+static void CCheckQueueSpeedPrevectorJob_32(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 32); }
+static void CCheckQueueSpeedPrevectorJob_64(benchmark::State& state) { CCheckQueueSpeedPrevectorJobThreads(state, 64); }
+
 BENCHMARK(CCheckQueueSpeed);
 BENCHMARK(CCheckQueueSpeedPrevectorJob);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_1);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_2);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_4);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_8);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_16);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_32);
+BENCHMARK(CCheckQueueSpeedPrevectorJob_64);
@@ -3,6 +3,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "bench.h"
+#include "privatesend/privatesend-client.h"
+#include "random.h"
+#include "wallet/coinindex.h"
 #include "wallet/wallet.h"
 
 #include <boost/foreach.hpp>
@@ -58,3 +61,112 @@ static void CoinSelection(benchmark::State& state)
 }
 
 BENCHMARK(CoinSelection);
+
+// A mixing wallet with hundreds of thousands of outputs, mostly denominations
+// spread over all PrivateSend rounds and a few hundred addresses
+static const int LARGE_WALLET_OUTPUTS = 200000;
+
+struct BenchCoin {
+    COutPoint outpoint;
+    CTxOut txout;
+    int nRounds;
+};
+
+static std::vector<BenchCoin> CreateLargeWallet()
+{
+    CPrivateSend::InitStandardDenominations();
+    std::vector<CAmount> vecDenoms = CPrivateSend::GetStandardDenominations();
+
+    std::vector<CScript> vecScripts;
+    for (int i = 0; i < 500; i++) {
+        uint256 hash = GetRandHash();
+        vecScripts.push_back(GetScriptForDestination(CKeyID(uint160(std::vector<unsigned char>(hash.begin(), hash.begin() + 20)))));
+    }
+
+    std::vector<BenchCoin> vecCoins;
+    for (int i = 0; i < LARGE_WALLET_OUTPUTS; i++) {
+        BenchCoin coin;
+        coin.outpoint = COutPoint(GetRandHash(), i % 10);
+        coin.txout.scriptPubKey = vecScripts[i % vecScripts.size()];
+        if (i % 20 == 0) {
+            coin.txout.nValue = GetRand(100 * COIN) + 1;
+            coin.nRounds = -2;
+        } else if (i % 20 == 1) {
+            coin.txout.nValue = CPrivateSend::GetCollateralAmount();
+            coin.nRounds = -3;
+        } else {
+            coin.txout.nValue = vecDenoms[i % vecDenoms.size()];
+            coin.nRounds = i % MAX_PRIVATESEND_ROUNDS;
+        }
+        vecCoins.push_back(coin);
+    }
+    return vecCoins;
+}
+
+// What AvailableCoins/SelectPrivateCoins did before the index: classify every output on every call
+static void CoinScan_Denominated_LargeWallet(benchmark::State& state)
+{
+    std::vector<BenchCoin> vecCoins = CreateLargeWallet();
+    while (state.KeepRunning()) {
+        size_t nFound = 0;
+        for (const auto& coin : vecCoins) {
+            if (!CPrivateSend::IsDenominatedAmount(coin.txout.nValue)) continue;
+            if (coin.nRounds < 2 || coin.nRounds > 3) continue;
+            nFound++;
+        }
+        assert(nFound > 0);
+    }
+}
+
+static void CoinIndex_Denominated_LargeWallet(benchmark::State& state)
+{
+    std::vector<BenchCoin> vecCoins = CreateLargeWallet();
+    CWalletCoinIndex coinIndex;
+    for (const auto& coin : vecCoins) {
+        coinIndex.Add(coin.outpoint, coin.txout, coin.nRounds);
+    }
+    while (state.KeepRunning()) {
+        size_t nFound = 0;
+        coinIndex.ForEachCoinInRounds(CWalletCoinIndex::COIN_TYPE_DENOMINATED, 2, 3, [&nFound](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+            nFound++;
+        });
+        assert(nFound > 0);
+    }
+}
+
+static void CoinIndex_Collateral_LargeWallet(benchmark::State& state)
+{
+    std::vector<BenchCoin> vecCoins = CreateLargeWallet();
+    CWalletCoinIndex coinIndex;
+    for (const auto& coin : vecCoins) {
+        coinIndex.Add(coin.outpoint, coin.txout, coin.nRounds);
+    }
+    while (state.KeepRunning()) {
+        size_t nFound = 0;
+        coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_COLLATERAL, [&nFound](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+            nFound++;
+        });
+        assert(nFound > 0);
+    }
+}
+
+// Keeping the index up to date as outputs get spent and created
+static void CoinIndex_Update_LargeWallet(benchmark::State& state)
+{
+    std::vector<BenchCoin> vecCoins = CreateLargeWallet();
+    CWalletCoinIndex coinIndex;
+    for (const auto& coin : vecCoins) {
+        coinIndex.Add(coin.outpoint, coin.txout, coin.nRounds);
+    }
+    size_t nPos = 0;
+    while (state.KeepRunning()) {
+        const BenchCoin& coin = vecCoins[nPos++ % vecCoins.size()];
+        coinIndex.Remove(coin.outpoint);
+        coinIndex.Add(coin.outpoint, coin.txout, coin.nRounds);
+    }
+}
+
+BENCHMARK(CoinScan_Denominated_LargeWallet);
+BENCHMARK(CoinIndex_Denominated_LargeWallet);
+BENCHMARK(CoinIndex_Collateral_LargeWallet);
+BENCHMARK(CoinIndex_Update_LargeWallet);
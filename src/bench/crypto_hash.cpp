@@ -186,6 +186,27 @@ static void HASH_X11_2048b_single(benchmark::State& state)
         hash = HashX11(in.begin(), in.end());
 }
 
+/* A full headers message worth of 80 byte headers */
+static const size_t HEADERS_BATCH_SIZE = 2000;
+
+static void HASH_X11_0080b_headers_loop(benchmark::State& state)
+{
+    std::vector<uint256> hashes(HEADERS_BATCH_SIZE);
+    std::vector<uint8_t> in(80 * HEADERS_BATCH_SIZE, 0);
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < HEADERS_BATCH_SIZE; i++)
+            hashes[i] = HashX11(in.begin() + i * 80, in.begin() + (i + 1) * 80);
+    }
+}
+
+static void HASH_X11_0080b_headers_many(benchmark::State& state)
+{
+    std::vector<uint256> hashes(HEADERS_BATCH_SIZE);
+    std::vector<uint8_t> in(80 * HEADERS_BATCH_SIZE, 0);
+    while (state.KeepRunning())
+        HashX11Many(in.data(), 80, HEADERS_BATCH_SIZE, hashes.data());
+}
+
 BENCHMARK(HASH_RIPEMD160);
 BENCHMARK(HASH_SHA1);
 BENCHMARK(HASH_SHA256);
@@ -209,3 +230,5 @@ BENCHMARK(HASH_X11_0128b_single);
 BENCHMARK(HASH_X11_0512b_single);
 BENCHMARK(HASH_X11_1024b_single);
 BENCHMARK(HASH_X11_2048b_single);
+BENCHMARK(HASH_X11_0080b_headers_loop);
+BENCHMARK(HASH_X11_0080b_headers_many);
@@ -0,0 +1,119 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "rpc/jsonstream.h"
+#include "tinyformat.h"
+
+#include <univalue.h>
+
+#include <functional>
+#include <stdio.h>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Roughly the shape of "getrawmempool true" with a busy mempool
+static const int JSON_ENTRIES = 20000;
+
+static UniValue MakeEntry(int i)
+{
+    UniValue entry(UniValue::VOBJ);
+    entry.push_back(Pair("size", 226 + i % 1000));
+    entry.push_back(Pair("fee", 0.00001000 + i * 0.00000001));
+    entry.push_back(Pair("modifiedfee", 0.00001000 + i * 0.00000001));
+    entry.push_back(Pair("time", (int64_t)1550000000 + i));
+    entry.push_back(Pair("height", 1000000 + i / 100));
+    entry.push_back(Pair("descendantcount", 1));
+    entry.push_back(Pair("descendantsize", 226 + i % 1000));
+    entry.push_back(Pair("ancestorcount", 1));
+    entry.push_back(Pair("ancestorsize", 226 + i % 1000));
+    UniValue depends(UniValue::VARR);
+    if (i % 3 == 0) {
+        depends.push_back(strprintf("%064x", i - 1));
+    }
+    entry.push_back(Pair("depends", depends));
+    entry.push_back(Pair("instantlock", i % 2 == 0));
+    return entry;
+}
+
+/**
+ * Run func once in a child process and report how much its peak resident set grew, on stderr to
+ * keep the CSV output intact. ru_maxrss is in KiB on Linux (bytes on macOS). Not available on Windows.
+ */
+static void PrintPeakRSS(const char* name, const std::function<void()>& func)
+{
+#ifndef WIN32
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // a forked child starts with the resident set of the parent as its peak
+        struct rusage before, after;
+        getrusage(RUSAGE_SELF, &before);
+        func();
+        getrusage(RUSAGE_SELF, &after);
+        fprintf(stderr, "# %s: peak RSS +%ld\n", name, (long)(after.ru_maxrss - before.ru_maxrss));
+        fflush(stderr);
+        _exit(0);
+    }
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+#endif
+}
+
+// Build the whole result as UniValue and serialize it at once, peak memory holds the
+// complete tree plus the complete string
+static size_t BuildUniValue()
+{
+    UniValue result(UniValue::VOBJ);
+    for (int i = 0; i < JSON_ENTRIES; i++) {
+        result.push_back(Pair(strprintf("%064x", i), MakeEntry(i)));
+    }
+    std::string strReply = result.write();
+    return strReply.size();
+}
+
+// Stream entry by entry, peak memory holds one entry plus one chunk
+static size_t StreamWriter()
+{
+    size_t nTotal = 0;
+    CJSONStreamWriter writer([&nTotal](const std::string& strChunk) {
+        nTotal += strChunk.size();
+    });
+    writer.BeginObject();
+    for (int i = 0; i < JSON_ENTRIES; i++) {
+        writer.Key(strprintf("%064x", i)).Value(MakeEntry(i));
+    }
+    writer.EndObject();
+    writer.Flush();
+    return nTotal;
+}
+
+static void JSONStream_UniValue(benchmark::State& state)
+{
+    PrintPeakRSS("JSONStream_UniValue", BuildUniValue);
+    size_t nTotal = 0;
+    while (state.KeepRunning()) {
+        nTotal += BuildUniValue();
+    }
+    assert(nTotal > 0);
+}
+
+static void JSONStream_Writer(benchmark::State& state)
+{
+    PrintPeakRSS("JSONStream_Writer", StreamWriter);
+    size_t nTotal = 0;
+    while (state.KeepRunning()) {
+        nTotal += StreamWriter();
+    }
+    assert(nTotal > 0);
+}
+
+BENCHMARK(JSONStream_UniValue);
+BENCHMARK(JSONStream_Writer);
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "checkqueue.h"
+#include "coins.h"
+#include "key.h"
+#include "keystore.h"
+#include "policy/policy.h"
+#include "script/sign.h"
+#include "script/standard.h"
+#include "util.h"
+#include "validation.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <vector>
+
+// Number of independent single-input P2PKH transactions per batch, roughly the size of
+// a busy PrivateSend/InstantSend burst
+static const size_t BATCH_TXS = 500;
+
+static std::vector<CTransactionRef> SetupBatch(CCoinsViewCache& coins)
+{
+    CBasicKeyStore keystore;
+    CKey key;
+    key.MakeNewKey(true);
+    keystore.AddKey(key);
+    CScript scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+
+    std::vector<CTransactionRef> vtx;
+    for (size_t i = 0; i < BATCH_TXS; i++) {
+        CMutableTransaction txFunding;
+        txFunding.vin.resize(1);
+        txFunding.vin[0].prevout.n = i;
+        txFunding.vout.resize(1);
+        txFunding.vout[0].nValue = COIN;
+        txFunding.vout[0].scriptPubKey = scriptPubKey;
+        AddCoins(coins, txFunding, 1);
+
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(txFunding.GetHash(), 0);
+        tx.vout.resize(1);
+        tx.vout[0].nValue = COIN - 1000;
+        tx.vout[0].scriptPubKey = scriptPubKey;
+        SignSignature(keystore, txFunding, tx, 0);
+        vtx.emplace_back(MakeTransactionRef(tx));
+    }
+    return vtx;
+}
+
+// Script verification part of AcceptToMemoryPoolMany, which is what limits tx/s admission
+// throughput. Signature caching is disabled so that every iteration does the full work.
+static void MempoolBatchScriptChecks(benchmark::State& state, CCheckQueue<CScriptCheck>* pqueue)
+{
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    std::vector<CTransactionRef> vtx = SetupBatch(coins);
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(&coins);
+        std::vector<CScriptCheck> vChecks;
+        GetBatchScriptChecks(vtx, view, STANDARD_SCRIPT_VERIFY_FLAGS, false, vChecks);
+        assert(vChecks.size() == BATCH_TXS);
+        bool fOk = RunScriptChecks(vChecks, pqueue);
+        assert(fOk);
+    }
+}
+
+static void MempoolBatchScriptChecksSerial(benchmark::State& state)
+{
+    MempoolBatchScriptChecks(state, NULL);
+}
+
+static void MempoolBatchScriptChecksParallel(benchmark::State& state)
+{
+    CCheckQueue<CScriptCheck> queue(128);
+    boost::thread_group tg;
+    for (int i = 0; i < std::max(2, GetNumCores()) - 1; i++) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+    MempoolBatchScriptChecks(state, &queue);
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+BENCHMARK(MempoolBatchScriptChecksSerial);
+BENCHMARK(MempoolBatchScriptChecksParallel);
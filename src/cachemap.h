@@ -7,6 +7,7 @@
 
 #include <map>
 #include <list>
+#include <vector>
 #include <cstddef>
 
 #include "serialize.h"
@@ -104,12 +105,22 @@ public:
     }
 
     bool Insert(const K& key, const V& value)
+    {
+        std::vector<item_t> vecPruned;
+        return Insert(key, value, vecPruned);
+    }
+
+    /**
+     * Same as Insert above, but items which had to be pruned to make room
+     * for the new one are appended to vecPruned
+     */
+    bool Insert(const K& key, const V& value, std::vector<item_t>& vecPruned)
     {
         if(mapIndex.find(key) != mapIndex.end()) {
             return false;
         }
         if(listItems.size() == nMaxSize) {
-            PruneLast();
+            PruneLast(vecPruned);
         }
         listItems.push_front(item_t(key, value));
         mapIndex.emplace(key, listItems.begin());
@@ -167,13 +178,14 @@ public:
     }
 
 private:
-    void PruneLast()
+    void PruneLast(std::vector<item_t>& vecPruned)
     {
         if(listItems.empty()) {
             return;
         }
         item_t& item = listItems.back();
         mapIndex.erase(item.key);
+        vecPruned.push_back(std::move(item));
         listItems.pop_back();
     }
 
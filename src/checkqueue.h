@@ -6,9 +6,11 @@
 #define BITCOIN_CHECKQUEUE_H
 
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <vector>
 
-#include <boost/foreach.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
@@ -25,12 +27,39 @@ class CCheckQueueControl;
   * onto the queue, where they are processed by N-1 worker threads. When
   * the master is done adding work, it temporarily joins the worker pool
   * as an N'th worker, until all jobs are done.
+  *
+  * Every thread owns a lane (a deque of checks with its own mutex). The
+  * master spreads added checks over all lanes, so workers start verifying
+  * as soon as the first checks are added. Threads take work from the back
+  * of their own lane and steal from the front of other lanes when they run
+  * dry, so no single lock is shared by all threads. Once a check failed,
+  * the remaining checks are only drained instead of executed.
   */
 template <typename T>
 class CCheckQueue
 {
 private:
-    //! Mutex to protect the inner state
+    //! Maximum number of lanes, lane 0 belongs to the master. Additional workers share lanes.
+    static const unsigned int MAX_LANES = 65;
+
+    struct Lane
+    {
+        boost::mutex mutex;
+        std::deque<T> checks;
+    };
+
+    std::vector<std::unique_ptr<Lane>> lanes;
+
+    //! Number of lanes in use (master + registered workers, capped at MAX_LANES)
+    std::atomic<unsigned int> nLanes;
+
+    //! Number of workers that ever registered, used to assign lanes
+    unsigned int nWorkers;
+
+    //! Lane which receives the next batch in Add()
+    unsigned int nNextLane;
+
+    //! Mutex used to sleep and wake up threads, it does not protect the checks themselves
     boost::mutex mutex;
 
     //! Worker threads block on this when out of work
@@ -39,90 +68,106 @@ private:
     //! Master thread blocks on this when out of work
     boost::condition_variable condMaster;
 
-    //! The queue of elements to be processed.
-    //! As the order of booleans doesn't matter, it is used as a LIFO (stack)
-    std::vector<T> queue;
-
-    //! The number of workers (including the master) that are idle.
-    int nIdle;
-
-    //! The total number of workers (including the master).
-    int nTotal;
-
-    //! The temporary evaluation result.
-    bool fAllOk;
+    //! Number of checks sitting in lanes which no thread took yet
+    std::atomic<unsigned int> nQueued;
 
     /**
      * Number of verifications that haven't completed yet.
-     * This includes elements that are no longer queued, but still in the
-     * worker's own batches.
+     * This includes elements that are no longer queued, but still in a
+     * thread's own batch.
      */
-    unsigned int nTodo;
+    std::atomic<unsigned int> nTodo;
 
-    //! Whether we're shutting down.
-    bool fQuit;
+    //! The temporary evaluation result.
+    std::atomic<bool> fAllOk;
 
     //! The maximum number of elements to be processed in one batch
     unsigned int nBatchSize;
 
+    unsigned int RegisterWorker()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        unsigned int nLane = 1 + (nWorkers++ % (MAX_LANES - 1));
+        if (nLane >= nLanes) {
+            nLanes = nLane + 1;
+        }
+        return nLane;
+    }
+
+    /** Move a batch of checks into vChecks, from our own lane if possible, otherwise stolen from another one */
+    bool TakeWork(unsigned int nLane, std::vector<T>& vChecks)
+    {
+        {
+            Lane& lane = *lanes[nLane];
+            boost::unique_lock<boost::mutex> lock(lane.mutex);
+            if (!lane.checks.empty()) {
+                size_t nNow = std::min((size_t)nBatchSize, lane.checks.size());
+                for (size_t i = 0; i < nNow; i++) {
+                    vChecks.emplace_back();
+                    vChecks.back().swap(lane.checks.back());
+                    lane.checks.pop_back();
+                }
+                nQueued -= nNow;
+                return true;
+            }
+        }
+        unsigned int nCount = nLanes;
+        for (unsigned int i = 1; i < nCount; i++) {
+            Lane& lane = *lanes[(nLane + i) % nCount];
+            boost::unique_lock<boost::mutex> lock(lane.mutex);
+            if (lane.checks.empty()) {
+                continue;
+            }
+            // steal at most half, the owner is probably busy with the rest already
+            size_t nNow = std::max((size_t)1, std::min((size_t)nBatchSize, lane.checks.size() / 2));
+            for (size_t j = 0; j < nNow; j++) {
+                vChecks.emplace_back();
+                vChecks.back().swap(lane.checks.front());
+                lane.checks.pop_front();
+            }
+            nQueued -= nNow;
+            return true;
+        }
+        return false;
+    }
+
     /** Internal function that does bulk of the verification work. */
     bool Loop(bool fMaster = false)
     {
-        boost::condition_variable& cond = fMaster ? condMaster : condWorker;
+        unsigned int nLane = fMaster ? 0 : RegisterWorker();
         std::vector<T> vChecks;
         vChecks.reserve(nBatchSize);
-        unsigned int nNow = 0;
-        bool fOk = true;
         do {
-            {
-                boost::unique_lock<boost::mutex> lock(mutex);
-                // first do the clean-up of the previous loop run (allowing us to do it in the same critsect)
-                if (nNow) {
-                    fAllOk &= fOk;
-                    nTodo -= nNow;
-                    if (nTodo == 0 && !fMaster)
-                        // We processed the last element; inform the master it can exit and return the result
-                        condMaster.notify_one();
-                } else {
-                    // first iteration
-                    nTotal++;
+            if (TakeWork(nLane, vChecks)) {
+                // once anything failed, the result is known and the remaining checks are only drained
+                bool fOk = fAllOk;
+                for (T& check : vChecks)
+                    if (fOk)
+                        fOk = check();
+                if (!fOk)
+                    fAllOk = false;
+                unsigned int nNow = vChecks.size();
+                // checks must be destroyed before they're reported as done
+                vChecks.clear();
+                if ((nTodo -= nNow) == 0 && !fMaster) {
+                    // We processed the last element; inform the master it can exit and return the result
+                    boost::unique_lock<boost::mutex> lock(mutex);
+                    condMaster.notify_one();
                 }
-                // logically, the do loop starts here
-                while (queue.empty()) {
-                    if ((fMaster || fQuit) && nTodo == 0) {
-                        nTotal--;
-                        bool fRet = fAllOk;
-                        // reset the status for new work later
-                        if (fMaster)
-                            fAllOk = true;
-                        // return the current status
-                        return fRet;
-                    }
-                    nIdle++;
-                    cond.wait(lock); // wait
-                    nIdle--;
-                }
-                // Decide how many work units to process now.
-                // * Do not try to do everything at once, but aim for increasingly smaller batches so
-                //   all workers finish approximately simultaneously.
-                // * Try to account for idle jobs which will instantly start helping.
-                // * Don't do batches smaller than 1 (duh), or larger than nBatchSize.
-                nNow = std::max(1U, std::min(nBatchSize, (unsigned int)queue.size() / (nTotal + nIdle + 1)));
-                vChecks.resize(nNow);
-                for (unsigned int i = 0; i < nNow; i++) {
-                    // We want the lock on the mutex to be as short as possible, so swap jobs from the global
-                    // queue to the local batch vector instead of copying.
-                    vChecks[i].swap(queue.back());
-                    queue.pop_back();
-                }
-                // Check whether we need to do work at all
-                fOk = fAllOk;
+                continue;
+            }
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            if (fMaster && nTodo == 0) {
+                bool fRet = fAllOk;
+                // reset the status for new work later
+                fAllOk = true;
+                // return the current status
+                return fRet;
+            }
+            if (nQueued == 0) {
+                (fMaster ? condMaster : condWorker).wait(lock);
             }
-            // execute work
-            BOOST_FOREACH (T& check, vChecks)
-                if (fOk)
-                    fOk = check();
-            vChecks.clear();
         } while (true);
     }
 
@@ -131,7 +176,13 @@ public:
     boost::mutex ControlMutex;
 
     //! Create a new check queue
-    CCheckQueue(unsigned int nBatchSizeIn) : nIdle(0), nTotal(0), fAllOk(true), nTodo(0), fQuit(false), nBatchSize(nBatchSizeIn) {}
+    CCheckQueue(unsigned int nBatchSizeIn) : nLanes(1), nWorkers(0), nNextLane(0), nQueued(0), nTodo(0), fAllOk(true), nBatchSize(nBatchSizeIn)
+    {
+        lanes.reserve(MAX_LANES);
+        for (unsigned int i = 0; i < MAX_LANES; i++) {
+            lanes.emplace_back(new Lane());
+        }
+    }
 
     //! Worker thread
     void Thread()
@@ -148,15 +199,34 @@ public:
     //! Add a batch of checks to the queue
     void Add(std::vector<T>& vChecks)
     {
-        boost::unique_lock<boost::mutex> lock(mutex);
-        BOOST_FOREACH (T& check, vChecks) {
-            queue.push_back(T());
-            check.swap(queue.back());
+        if (vChecks.empty()) {
+            return;
+        }
+        if (!fAllOk) {
+            // the result is known already, no need to queue anything
+            return;
         }
+
         nTodo += vChecks.size();
+
+        // spread the checks over all lanes, but don't split them up into tiny pieces
+        unsigned int nCount = nLanes;
+        size_t nChunk = std::max((size_t)1, std::min((size_t)nBatchSize, vChecks.size() / nCount));
+        for (size_t nPos = 0; nPos < vChecks.size(); ) {
+            size_t nEnd = std::min(vChecks.size(), nPos + nChunk);
+            Lane& lane = *lanes[nNextLane++ % nCount];
+            boost::unique_lock<boost::mutex> lock(lane.mutex);
+            nQueued += nEnd - nPos;
+            for (; nPos < nEnd; nPos++) {
+                lane.checks.emplace_back();
+                lane.checks.back().swap(vChecks[nPos]);
+            }
+        }
+
+        boost::unique_lock<boost::mutex> lock(mutex);
         if (vChecks.size() == 1)
             condWorker.notify_one();
-        else if (vChecks.size() > 1)
+        else
             condWorker.notify_all();
     }
 
@@ -206,6 +206,14 @@ bool CCoinsViewCache::Flush() {
     return fOk;
 }
 
+bool CCoinsViewCache::AddFetchedCoin(const COutPoint& outpoint, Coin&& coin) {
+    if (coin.IsSpent()) return false;
+    std::pair<CCoinsMap::iterator, bool> inserted = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(coin)));
+    if (!inserted.second) return false;
+    cachedCoinsUsage += inserted.first->second.coin.DynamicMemoryUsage();
+    return true;
+}
+
 void CCoinsViewCache::Uncache(const COutPoint& hash)
 {
     CCoinsMap::iterator it = cacheCoins.find(hash);
@@ -240,6 +240,14 @@ public:
      */
     void AddCoin(const COutPoint& outpoint, Coin&& coin, bool potential_overwrite);
 
+    /**
+     * Insert a coin that was read from this cache's backing view by someone
+     * else (e.g. the input prefetcher). The entry is added unmodified, as if
+     * FetchCoin had loaded it. Returns false and leaves the cache untouched if
+     * the outpoint is already cached or the coin is spent.
+     */
+    bool AddFetchedCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Spend a coin. Pass moveto in order to get the deleted data.
      * If no unspent output exists for the passed outpoint, this call
@@ -5,7 +5,9 @@
 #include "dbwrapper.h"
 
 #include "fs.h"
+#include "sync.h"
 #include "util.h"
+#include "utilstrencodings.h"
 #include "random.h"
 
 #include <leveldb/cache.h>
@@ -14,6 +16,11 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
+#include <set>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -73,14 +80,156 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+/** Block cache which counts how many lookups it could answer */
+class CDBCountingCache : public leveldb::Cache
+{
+private:
+    leveldb::Cache* pcache;
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+public:
+    explicit CDBCountingCache(size_t nCapacity) : pcache(leveldb::NewLRUCache(nCapacity)), nHits(0), nMisses(0) {}
+    ~CDBCountingCache() { delete pcache; }
+
+    Handle* Insert(const leveldb::Slice& key, void* value, size_t charge, void (*deleter)(const leveldb::Slice& key, void* value)) override
+    {
+        return pcache->Insert(key, value, charge, deleter);
+    }
+    Handle* Lookup(const leveldb::Slice& key) override
+    {
+        Handle* handle = pcache->Lookup(key);
+        (handle ? nHits : nMisses).fetch_add(1, std::memory_order_relaxed);
+        return handle;
+    }
+    void Release(Handle* handle) override { pcache->Release(handle); }
+    void* Value(Handle* handle) override { return pcache->Value(handle); }
+    void Erase(const leveldb::Slice& key) override { pcache->Erase(key); }
+    uint64_t NewId() override { return pcache->NewId(); }
+    void Prune() override { pcache->Prune(); }
+    size_t TotalCharge() const override { return pcache->TotalCharge(); }
+
+    uint64_t GetHits() const { return nHits.load(std::memory_order_relaxed); }
+    uint64_t GetMisses() const { return nMisses.load(std::memory_order_relaxed); }
+};
+
+CDBOptions CDBOptions::FromCacheSize(size_t nCacheSize)
+{
+    CDBOptions dbOptions;
+    dbOptions.nBlockCacheSize = nCacheSize / 2;
+    dbOptions.nWriteBufferSize = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
+    dbOptions.nBloomBits = 10;
+    dbOptions.nBlockSize = 4096;
+    dbOptions.fCompression = false;
+    dbOptions.nMaxOpenFiles = 64;
+    return dbOptions;
+}
+
+static bool IsDBProfileName(const std::string& strName)
+{
+    for (const char* pszName : DB_PROFILE_NAMES) {
+        if (strName == pszName) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Apply a single -dbprofile setting of the form <db>:<key>=<value>[,<key>=<value>...] to dbOptions
+ * if it is meant for strName. Settings are applied in order, so "cache" can be refined by the
+ * keys for the block cache and the write buffer after it.
+ */
+static bool ApplyDBProfile(const std::string& strProfile, const std::string& strName, CDBOptions& dbOptions, std::string& strError)
+{
+    size_t pos = strProfile.find(':');
+    std::string strDB = strProfile.substr(0, pos);
+    if (pos == std::string::npos || !IsDBProfileName(strDB)) {
+        strError = strprintf("Invalid -dbprofile specification: %s. Valid is <db>:<key>=<value>[,<key>=<value>...] with <db> one of %s.",
+                             strProfile, boost::algorithm::join(std::vector<std::string>(std::begin(DB_PROFILE_NAMES), std::end(DB_PROFILE_NAMES)), ", "));
+        return false;
+    }
+    bool fApply = strDB == strName;
+
+    std::vector<std::string> vSettings;
+    std::string strSettings = strProfile.substr(pos + 1);
+    boost::split(vSettings, strSettings, boost::is_any_of(","));
+    for (const std::string& strSetting : vSettings) {
+        size_t posValue = strSetting.find('=');
+        std::string strKey = strSetting.substr(0, posValue);
+        int32_t nValue;
+        if (posValue == std::string::npos || !ParseInt32(strSetting.substr(posValue + 1), &nValue) || nValue < 0) {
+            strError = strprintf("Invalid -dbprofile setting %s for %s, expected <key>=<non-negative number>.", strSetting, strDB);
+            return false;
+        }
+        CDBOptions opts = dbOptions;
+        if (strKey == "cache") {
+            CDBOptions optsCache = CDBOptions::FromCacheSize((size_t)nValue << 20);
+            opts.nBlockCacheSize = optsCache.nBlockCacheSize;
+            opts.nWriteBufferSize = optsCache.nWriteBufferSize;
+        } else if (strKey == "blockcache") {
+            opts.nBlockCacheSize = (size_t)nValue << 20;
+        } else if (strKey == "writebuffer") {
+            opts.nWriteBufferSize = (size_t)nValue << 20;
+        } else if (strKey == "bloombits") {
+            opts.nBloomBits = nValue;
+        } else if (strKey == "blocksize") {
+            opts.nBlockSize = (size_t)nValue << 10;
+        } else if (strKey == "compression") {
+            opts.fCompression = nValue != 0;
+        } else if (strKey == "maxopenfiles") {
+            opts.nMaxOpenFiles = nValue;
+        } else {
+            strError = strprintf("Unknown -dbprofile key %s for %s. Valid are cache, blockcache, writebuffer, bloombits, blocksize, compression and maxopenfiles.", strKey, strDB);
+            return false;
+        }
+        if (fApply) {
+            dbOptions = opts;
+        }
+    }
+    return true;
+}
+
+CDBOptions GetDBOptions(const std::string& strName, size_t nCacheSize)
+{
+    CDBOptions dbOptions = CDBOptions::FromCacheSize(nCacheSize);
+    if (strName.empty() || !mapMultiArgs.count("-dbprofile")) {
+        return dbOptions;
+    }
+    for (const std::string& strProfile : mapMultiArgs.at("-dbprofile")) {
+        std::string strError;
+        if (!ApplyDBProfile(strProfile, strName, dbOptions, strError)) {
+            // checked on startup already, see CheckDBProfiles
+            LogPrintf("%s\n", strError);
+        }
+    }
+    return dbOptions;
+}
+
+bool CheckDBProfiles(std::string& strError)
+{
+    if (!mapMultiArgs.count("-dbprofile")) {
+        return true;
+    }
+    for (const std::string& strProfile : mapMultiArgs.at("-dbprofile")) {
+        CDBOptions dbOptions = CDBOptions::FromCacheSize(0);
+        if (!ApplyDBProfile(strProfile, "", dbOptions, strError)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static leveldb::Options GetOptions(const CDBOptions& dbOptions, CDBCountingCache* pcache)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
-    options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
-    options.max_open_files = 64;
+    options.block_cache = pcache;
+    options.write_buffer_size = dbOptions.nWriteBufferSize;
+    options.filter_policy = dbOptions.nBloomBits > 0 ? leveldb::NewBloomFilterPolicy(dbOptions.nBloomBits) : nullptr;
+    options.block_size = dbOptions.nBlockSize;
+    // only has an effect if leveldb was built with snappy
+    options.compression = dbOptions.fCompression ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+    options.max_open_files = dbOptions.nMaxOpenFiles;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -90,14 +239,22 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+// named databases which are currently open, for getdbstats
+static CCriticalSection cs_openDBs;
+static std::set<const CDBWrapper*> setOpenDBs;
+
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const std::string& strNameIn) :
+    strName(strNameIn),
+    strPath(fMemory ? "" : path.string()),
+    dbOptions(GetDBOptions(strNameIn, nCacheSize))
 {
     penv = NULL;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    pcache = new CDBCountingCache(dbOptions.nBlockCacheSize);
+    options = GetOptions(dbOptions, pcache);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -139,10 +296,19 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+
+    if (!strName.empty()) {
+        LOCK(cs_openDBs);
+        setOpenDBs.insert(this);
+    }
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(cs_openDBs);
+        setOpenDBs.erase(this);
+    }
     delete pdb;
     pdb = NULL;
     delete options.filter_policy;
@@ -151,6 +317,7 @@ CDBWrapper::~CDBWrapper()
     options.info_log = NULL;
     delete options.block_cache;
     options.block_cache = NULL;
+    pcache = NULL;
     delete penv;
     options.env = NULL;
 }
@@ -189,10 +356,81 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
+CDBStats CDBWrapper::GetStats() const
+{
+    CDBStats stats;
+    stats.strName = strName;
+    stats.strPath = strPath;
+    stats.options = dbOptions;
+
+    // files of every level, e.g. " 17:123['a' .. 'd']" below "--- level 1 ---"
+    std::string strSSTables;
+    if (pdb->GetProperty("leveldb.sstables", &strSSTables)) {
+        std::istringstream ss(strSSTables);
+        std::string strLine;
+        while (std::getline(ss, strLine)) {
+            int nLevel;
+            if (sscanf(strLine.c_str(), "--- level %d ---", &nLevel) == 1) {
+                stats.vLevels.push_back(CDBLevelStats{nLevel, 0, 0, 0, 0, 0});
+                continue;
+            }
+            unsigned long long nNumber, nFileSize;
+            if (!stats.vLevels.empty() && sscanf(strLine.c_str(), " %llu:%llu[", &nNumber, &nFileSize) == 2) {
+                stats.vLevels.back().nFiles++;
+                stats.vLevels.back().nBytes += nFileSize;
+            }
+        }
+    }
+
+    // compaction table, "level files size(MB) time(sec) read(MB) write(MB)" after three header lines
+    std::string strCompactions;
+    if (pdb->GetProperty("leveldb.stats", &strCompactions)) {
+        std::istringstream ss(strCompactions);
+        std::string strLine;
+        while (std::getline(ss, strLine)) {
+            int nLevel, nFiles;
+            double dSize, dTime, dRead, dWrite;
+            if (sscanf(strLine.c_str(), "%d %d %lf %lf %lf %lf", &nLevel, &nFiles, &dSize, &dTime, &dRead, &dWrite) != 6) {
+                continue;
+            }
+            for (auto& level : stats.vLevels) {
+                if (level.nLevel == nLevel) {
+                    level.dCompactionTime = dTime;
+                    level.dCompactionReadMB = dRead;
+                    level.dCompactionWriteMB = dWrite;
+                }
+            }
+        }
+    }
+
+    std::string strMemoryUsage;
+    stats.nMemoryUsage = 0;
+    if (pdb->GetProperty("leveldb.approximate-memory-usage", &strMemoryUsage)) {
+        stats.nMemoryUsage = atoi64(strMemoryUsage);
+    }
+    stats.nBlockCacheUsage = pcache->TotalCharge();
+    stats.nBlockCacheHits = pcache->GetHits();
+    stats.nBlockCacheMisses = pcache->GetMisses();
+    return stats;
+}
+
+std::vector<CDBStats> GetDBStats()
+{
+    std::vector<CDBStats> vStats;
+    LOCK(cs_openDBs);
+    for (const CDBWrapper* pdbw : setOpenDBs) {
+        vStats.push_back(pdbw->GetStats());
+    }
+    std::sort(vStats.begin(), vStats.end(), [](const CDBStats& a, const CDBStats& b) { return a.strName < b.strName; });
+    return vStats;
+}
+
 CDBIterator::~CDBIterator() { delete piter; }
 bool CDBIterator::Valid() { return piter->Valid(); }
 void CDBIterator::SeekToFirst() { piter->SeekToFirst(); }
+void CDBIterator::SeekToLast() { piter->SeekToLast(); }
 void CDBIterator::Next() { piter->Next(); }
+void CDBIterator::Prev() { piter->Prev(); }
 
 namespace dbwrapper_private {
 
@@ -15,7 +15,9 @@
 
 #include <map>
 #include <memory>
+#include <string>
 #include <typeindex>
+#include <vector>
 
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
@@ -30,6 +32,61 @@ public:
 };
 
 class CDBWrapper;
+class CDBCountingCache;
+
+/** LevelDB tuning of a single database, see -dbprofile */
+struct CDBOptions
+{
+    size_t nBlockCacheSize;
+    size_t nWriteBufferSize;
+    int nBloomBits;
+    size_t nBlockSize;
+    bool fCompression;
+    int nMaxOpenFiles;
+
+    /** Half of nCacheSize for the block cache and a quarter for each of the two write buffers */
+    static CDBOptions FromCacheSize(size_t nCacheSize);
+    /** Memory the block cache and the write buffers may take up */
+    size_t CacheSize() const { return nBlockCacheSize + 2 * nWriteBufferSize; }
+};
+
+/** Databases which can be tuned with -dbprofile */
+static const char* const DB_PROFILE_NAMES[] = {"blockindex", "chainstate", "evodb", "llmq"};
+
+/**
+ * Options for the database strName with nCacheSize bytes of cache, adjusted by the -dbprofile
+ * settings for it. Databases without a name always use CDBOptions::FromCacheSize.
+ */
+CDBOptions GetDBOptions(const std::string& strName, size_t nCacheSize);
+
+/** Check all -dbprofile settings, returns false and sets strError if one is invalid */
+bool CheckDBProfiles(std::string& strError);
+
+struct CDBLevelStats
+{
+    int nLevel;
+    int nFiles;
+    uint64_t nBytes;
+    // totals of the compactions which wrote into this level, as reported by leveldb
+    double dCompactionTime;
+    double dCompactionReadMB;
+    double dCompactionWriteMB;
+};
+
+struct CDBStats
+{
+    std::string strName;
+    std::string strPath;
+    CDBOptions options;
+    std::vector<CDBLevelStats> vLevels;
+    uint64_t nMemoryUsage;
+    size_t nBlockCacheUsage;
+    uint64_t nBlockCacheHits;
+    uint64_t nBlockCacheMisses;
+};
+
+/** Statistics of all open databases which have a name */
+std::vector<CDBStats> GetDBStats();
 
 /** These should be considered an implementation detail of the specific database.
  */
@@ -144,6 +201,7 @@ public:
     bool Valid();
 
     void SeekToFirst();
+    void SeekToLast();
 
     template<typename K> void Seek(const K& key) {
         CDataStream ssKey(SER_DISK, CLIENT_VERSION);
@@ -158,6 +216,7 @@ public:
     }
 
     void Next();
+    void Prev();
 
     template<typename K> bool GetKey(K& key) {
         try {
@@ -221,6 +280,14 @@ private:
     //! the database itself
     leveldb::DB* pdb;
 
+    //! name for -dbprofile and getdbstats, empty for anonymous databases
+    std::string strName;
+    std::string strPath;
+    CDBOptions dbOptions;
+
+    //! options.block_cache, which counts hits and misses
+    CDBCountingCache* pcache;
+
     //! a key used for optional XOR-obfuscation of the database
     std::vector<unsigned char> obfuscate_key;
 
@@ -240,8 +307,10 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] strNameIn   Name of the database in DB_PROFILE_NAMES. Named databases apply
+     *                        the matching -dbprofile settings and are listed by getdbstats.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const std::string& strNameIn = "");
     ~CDBWrapper();
 
     template <typename K>
@@ -360,6 +429,8 @@ public:
      */
     bool IsEmpty();
 
+    CDBStats GetStats() const;
+
     template<typename K>
     size_t EstimateSize(const K& key_begin, const K& key_end) const
     {
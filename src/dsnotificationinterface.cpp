@@ -9,6 +9,7 @@
 #include "masternode/masternode-payments.h"
 #include "masternode/masternode-sync.h"
 #include "privatesend/privatesend.h"
+#include "rpc/responsecache.h"
 #ifdef ENABLE_WALLET
 #include "privatesend/privatesend-client.h"
 #endif // ENABLE_WALLET
@@ -107,6 +108,7 @@ void CDSNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBl
     llmq::quorumInstantSendManager->BlockDisconnected(pblock, pindexDisconnected);
     llmq::chainLocksHandler->BlockDisconnected(pblock, pindexDisconnected);
     CPrivateSend::BlockDisconnected(pblock, pindexDisconnected);
+    responseCache.EraseBlock(pindexDisconnected->GetBlockHash());
 
     for (const CTransactionRef& ptx : pblock->vtx) {
         instantsend.SyncTransaction(ptx, pindexDisconnected->pprev, -1);
@@ -42,35 +42,78 @@ private:
 
         int64_t nStart = GetTimeMillis();
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj.begin(), ssObj.end());
-        ssObj << hash;
-
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
+        CDataStream ssData(SER_DISK, CLIENT_VERSION);
+        ssData << objToSave;
+        if (!WriteSerialized(ssData))
+            return false;
+
+        LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToSave.ToString());
+
+        return true;
+    }
+
+    bool WriteSerialized(const CDataStream& ssData)
+    {
+        // checksum header and data, then append checksum
+        CDataStream ssHeader(SER_DISK, CLIENT_VERSION);
+        ssHeader << strMagicMessage; // specific magic message for this type of object
+        ssHeader << FLATDATA(Params().MessageStart()); // network specific magic number
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+        hasher.write(ssHeader.data(), ssHeader.size());
+        hasher.write(ssData.data(), ssData.size());
+        uint256 hash = hasher.GetHash();
+
+        // write to a temporary file and only replace the old one once everything is on disk,
+        // so a crash or a failed write never leaves a torn file behind
+        fs::path pathTmp = pathDB;
+        pathTmp += ".new";
+        FILE *file = fsbridge::fopen(pathTmp, "wb");
         CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
         if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            return error("%s: Failed to open file %s", __func__, pathTmp.string());
 
-        // Write and commit header, data
         try {
-            fileout << ssObj;
+            fileout << ssHeader << ssData << hash;
         }
         catch (std::exception &e) {
             return error("%s: Serialize or I/O error - %s", __func__, e.what());
         }
+        if (fflush(fileout.Get()) != 0)
+            return error("%s: Failed to flush file %s", __func__, pathTmp.string());
+        FileCommit(fileout.Get());
         fileout.fclose();
 
-        LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
-        LogPrintf("     %s\n", objToSave.ToString());
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Failed to rename %s to %s", __func__, pathTmp.string(), pathDB.string());
 
         return true;
     }
 
+    // don't overwrite a file in an unknown format
+    bool VerifyBeforeDump()
+    {
+        LogPrintf("Verifying %s format...\n", strFilename);
+        T tmpObjToLoad;
+        ReadResult readResult = Read(tmpObjToLoad, true);
+
+        // there was an error and it was not an error on file opening => do not proceed
+        if (readResult == FileError)
+            LogPrintf("Missing file %s, will try to recreate\n", strFilename);
+        else if (readResult != Ok)
+        {
+            LogPrintf("Error reading %s: ", strFilename);
+            if(readResult == IncorrectFormat)
+                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
+            else
+            {
+                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
+                return false;
+            }
+        }
+        return true;
+    }
+
     ReadResult Read(T& objToLoad, bool fDryRun = false)
     {
         //LOCK(objToLoad.cs);
@@ -196,30 +239,29 @@ public:
     {
         int64_t nStart = GetTimeMillis();
 
-        LogPrintf("Verifying %s format...\n", strFilename);
-        T tmpObjToLoad;
-        ReadResult readResult = Read(tmpObjToLoad, true);
+        if (!VerifyBeforeDump())
+            return false;
 
-        // there was an error and it was not an error on file opening => do not proceed
-        if (readResult == FileError)
-            LogPrintf("Missing file %s, will try to recreate\n", strFilename);
-        else if (readResult != Ok)
-        {
-            LogPrintf("Error reading %s: ", strFilename);
-            if(readResult == IncorrectFormat)
-                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
-            else
-            {
-                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
-                return false;
-            }
-        }
+        LogPrintf("Writing info to %s...\n", strFilename);
+        bool fResult = Write(objToSave);
+        LogPrintf("%s dump %s  %dms\n", strFilename, fResult ? "finished" : "failed", GetTimeMillis() - nStart);
+
+        return fResult;
+    }
+
+    /// Like Dump, for an object which was serialized into ssData beforehand (e.g. while holding its lock)
+    bool DumpSerialized(const CDataStream& ssData)
+    {
+        int64_t nStart = GetTimeMillis();
+
+        if (!VerifyBeforeDump())
+            return false;
 
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
-        LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
+        bool fResult = WriteSerialized(ssData);
+        LogPrintf("%s dump %s  %dms\n", strFilename, fResult ? "finished" : "failed", GetTimeMillis() - nStart);
 
-        return true;
+        return fResult;
     }
 
 };
@@ -0,0 +1,219 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "governance-journal.h"
+
+#include "crypto/common.h"
+#include "hash.h"
+#include "util.h"
+
+/** Size of the per-record header: type, payload size and payload checksum */
+static const size_t JOURNAL_RECORD_HEADER_SIZE = 9;
+/** Upper bound for a single record, anything larger is treated as corruption */
+static const uint32_t MAX_JOURNAL_RECORD_SIZE = 32 * 1024 * 1024;
+
+static uint32_t JournalChecksum(const char* pbegin, const char* pend)
+{
+    uint256 hash = Hash(pbegin, pend);
+    return ReadLE32(hash.begin());
+}
+
+CGovernanceJournal::CGovernanceJournal() :
+    pathJournal(),
+    file(nullptr),
+    nSize(0)
+{
+}
+
+CGovernanceJournal::~CGovernanceJournal()
+{
+    Close();
+}
+
+bool CGovernanceJournal::Open(const fs::path& pathIn, bool fWipe)
+{
+    Close();
+
+    pathJournal = pathIn;
+    if (fWipe) {
+        FILE* fileWipe = fsbridge::fopen(pathJournal, "wb");
+        if (fileWipe) {
+            fclose(fileWipe);
+        }
+    }
+
+    file = fsbridge::fopen(pathJournal, "a+b");
+    if (!file) {
+        return error("%s: Failed to open file %s", __func__, pathJournal.string());
+    }
+    fseek(file, 0, SEEK_END);
+    nSize = ftell(file);
+    return true;
+}
+
+void CGovernanceJournal::Close()
+{
+    if (file) {
+        Flush();
+        fclose(file);
+        file = nullptr;
+    }
+    nSize = 0;
+}
+
+bool CGovernanceJournal::AppendRecord(RecordType type, const CDataStream& ssPayload)
+{
+    unsigned char header[JOURNAL_RECORD_HEADER_SIZE];
+    header[0] = type;
+    WriteLE32(header + 1, ssPayload.size());
+    WriteLE32(header + 5, JournalChecksum(&ssPayload.begin()[0], &ssPayload.begin()[0] + ssPayload.size()));
+
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header) ||
+        fwrite(&ssPayload.begin()[0], 1, ssPayload.size(), file) != ssPayload.size()) {
+        return error("%s: Failed to write to %s", __func__, pathJournal.string());
+    }
+    nSize += sizeof(header) + ssPayload.size();
+    return true;
+}
+
+size_t CGovernanceJournal::Replay(const replay_func_t& func)
+{
+    if (!IsOpen()) {
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_SET);
+
+    uint64_t nGoodSize = 0;
+    size_t nRecords = 0;
+    bool fCorrupted = false;
+    std::vector<char> vchPayload;
+    while (true) {
+        unsigned char header[JOURNAL_RECORD_HEADER_SIZE];
+        size_t nRead = fread(header, 1, sizeof(header), file);
+        if (nRead == 0) {
+            break;
+        }
+        if (nRead != sizeof(header)) {
+            fCorrupted = true;
+            break;
+        }
+        RecordType type = RecordType(header[0]);
+        uint32_t nPayloadSize = ReadLE32(header + 1);
+        uint32_t nChecksum = ReadLE32(header + 5);
+        if (nPayloadSize > MAX_JOURNAL_RECORD_SIZE) {
+            fCorrupted = true;
+            break;
+        }
+        vchPayload.resize(nPayloadSize);
+        if (fread(vchPayload.data(), 1, nPayloadSize, file) != nPayloadSize ||
+            JournalChecksum(vchPayload.data(), vchPayload.data() + nPayloadSize) != nChecksum) {
+            fCorrupted = true;
+            break;
+        }
+
+        try {
+            CDataStream ssPayload(vchPayload, SER_DISK, CLIENT_VERSION);
+            func(type, ssPayload);
+        } catch (const std::exception& e) {
+            LogPrintf("CGovernanceJournal::%s -- Failed to replay record %d: %s\n", __func__, nRecords, e.what());
+            fCorrupted = true;
+            break;
+        }
+
+        nGoodSize += sizeof(header) + nPayloadSize;
+        nRecords++;
+    }
+
+    if (fCorrupted) {
+        LogPrintf("CGovernanceJournal::%s -- Dropping corrupted tail of %s after %d records (%d bytes)\n", __func__, pathJournal.string(), nRecords, nGoodSize);
+        if (!TruncateFile(file, nGoodSize)) {
+            LogPrintf("CGovernanceJournal::%s -- Failed to truncate %s\n", __func__, pathJournal.string());
+        }
+    }
+
+    fseek(file, 0, SEEK_END);
+    nSize = nGoodSize;
+    return nRecords;
+}
+
+bool CGovernanceJournal::Flush()
+{
+    if (!IsOpen()) {
+        return false;
+    }
+    if (fflush(file) != 0) {
+        return error("%s: Failed to flush %s", __func__, pathJournal.string());
+    }
+    FileCommit(file);
+    return true;
+}
+
+bool CGovernanceJournal::Reset()
+{
+    if (!IsOpen()) {
+        return false;
+    }
+    fflush(file);
+    if (!TruncateFile(file, 0)) {
+        return error("%s: Failed to truncate %s", __func__, pathJournal.string());
+    }
+    FileCommit(file);
+    fseek(file, 0, SEEK_END);
+    nSize = 0;
+    return true;
+}
+
+bool CGovernanceJournal::Discard(uint64_t nBytes)
+{
+    if (!IsOpen()) {
+        return false;
+    }
+    if (nBytes >= nSize) {
+        return Reset();
+    }
+    if (nBytes == 0) {
+        return true;
+    }
+
+    if (fflush(file) != 0) {
+        return error("%s: Failed to flush %s", __func__, pathJournal.string());
+    }
+    std::vector<char> vchTail(nSize - nBytes);
+    fseek(file, nBytes, SEEK_SET);
+    size_t nRead = fread(vchTail.data(), 1, vchTail.size(), file);
+    fseek(file, 0, SEEK_END);
+    if (nRead != vchTail.size()) {
+        return error("%s: Failed to read %s", __func__, pathJournal.string());
+    }
+
+    fs::path pathTmp = pathJournal;
+    pathTmp += ".new";
+    FILE* fileTmp = fsbridge::fopen(pathTmp, "wb");
+    if (!fileTmp) {
+        return error("%s: Failed to open file %s", __func__, pathTmp.string());
+    }
+    if (fwrite(vchTail.data(), 1, vchTail.size(), fileTmp) != vchTail.size() || fflush(fileTmp) != 0) {
+        fclose(fileTmp);
+        return error("%s: Failed to write to %s", __func__, pathTmp.string());
+    }
+    FileCommit(fileTmp);
+    fclose(fileTmp);
+
+    // the journal has to be closed to be replaced on all platforms
+    fclose(file);
+    file = nullptr;
+    bool fRenamed = RenameOver(pathTmp, pathJournal);
+    file = fsbridge::fopen(pathJournal, "a+b");
+    if (!file) {
+        nSize = 0;
+        return error("%s: Failed to reopen %s", __func__, pathJournal.string());
+    }
+    fseek(file, 0, SEEK_END);
+    nSize = ftell(file);
+    if (!fRenamed) {
+        return error("%s: Failed to replace %s", __func__, pathJournal.string());
+    }
+    return true;
+}
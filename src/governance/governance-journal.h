@@ -0,0 +1,85 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef GOVERNANCE_JOURNAL_H
+#define GOVERNANCE_JOURNAL_H
+
+#include "clientversion.h"
+#include "fs.h"
+#include "streams.h"
+
+#include <functional>
+
+/**
+ * Append-only log of governance changes made since governance.dat was last written.
+ *
+ * New objects, votes, vote removals and object deletions are appended as they happen, so the full
+ * governance.dat snapshot only has to be rewritten once the journal has grown large
+ * (compaction) instead of on every shutdown. Every record carries its own checksum;
+ * a torn or corrupted tail (e.g. after a crash) is cut off on replay.
+ *
+ * Record layout: type (1 byte), payload size (4 bytes), payload checksum (4 bytes), payload
+ */
+class CGovernanceJournal
+{
+public:
+    enum RecordType : uint8_t {
+        RECORD_OBJECT = 1,
+        RECORD_VOTE = 2,
+        RECORD_ERASE_OBJECT = 3,
+        RECORD_REMOVE_VOTES = 4,
+    };
+
+    typedef std::function<void(RecordType, CDataStream&)> replay_func_t;
+
+private:
+    fs::path pathJournal;
+    FILE* file;
+    uint64_t nSize;
+
+    bool AppendRecord(RecordType type, const CDataStream& ssPayload);
+
+public:
+    CGovernanceJournal();
+    ~CGovernanceJournal();
+
+    CGovernanceJournal(const CGovernanceJournal&) = delete;
+    CGovernanceJournal& operator=(const CGovernanceJournal&) = delete;
+
+    /// Open (and create if needed) the journal at pathIn, dropping its contents if fWipe is set
+    bool Open(const fs::path& pathIn, bool fWipe);
+    void Close();
+    bool IsOpen() const { return file != nullptr; }
+
+    /// Size of the journal in bytes
+    uint64_t GetSize() const { return nSize; }
+
+    template<typename T>
+    bool Append(RecordType type, const T& obj)
+    {
+        if (!IsOpen()) {
+            return false;
+        }
+        CDataStream ssPayload(SER_DISK, CLIENT_VERSION);
+        ssPayload << obj;
+        return AppendRecord(type, ssPayload);
+    }
+
+    /// Call func for every intact record in order, cutting off everything after the first bad one.
+    /// Returns the number of records replayed.
+    size_t Replay(const replay_func_t& func);
+
+    /// Make sure everything appended so far is on disk
+    bool Flush();
+
+    /// Drop all records
+    bool Reset();
+
+    /// Drop the first nBytes of records, called after a snapshot covering them was written.
+    /// Records appended after that are kept. The journal is rewritten to a temporary file
+    /// which then replaces it, so a crash leaves either the old or the new journal behind.
+    bool Discard(uint64_t nBytes);
+};
+
+#endif // GOVERNANCE_JOURNAL_H
@@ -42,6 +42,7 @@ CGovernanceObject::CGovernanceObject() :
     fExpired(false),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    arrVoteTally(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -69,6 +70,7 @@ CGovernanceObject::CGovernanceObject(const uint256& nHashParentIn, int nRevision
     fExpired(false),
     fUnparsable(false),
     mapCurrentMNVotes(),
+    arrVoteTally(),
     fileVotes()
 {
     // PARSE JSON DATA STORAGE (VCHDATA)
@@ -96,6 +98,7 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) :
     fExpired(other.fExpired),
     fUnparsable(other.fUnparsable),
     mapCurrentMNVotes(other.mapCurrentMNVotes),
+    arrVoteTally(other.arrVoteTally),
     fileVotes(other.fileVotes)
 {
 }
@@ -144,8 +147,11 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         exception = CGovernanceException(ostr.str(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR, 20);
         return false;
     }
-    vote_instance_m_it it2 = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t())).first;
-    vote_instance_t& voteInstanceRef = it2->second;
+    auto ret = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t()));
+    vote_instance_t& voteInstanceRef = ret.first->second;
+    if (ret.second) {
+        UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
+    }
 
     // Reject obsolete votes
     if (vote.GetTimestamp() < voteInstanceRef.nCreationTime) {
@@ -213,27 +219,64 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
         return false;
     }
 
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, -1);
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
+    fileVotes.AddVote(vote);
+    fDirtyCache = true;
+    return true;
+}
+
+bool CGovernanceObject::ApplyStoredVote(const CGovernanceVote& vote)
+{
+    LOCK(cs);
+
+    vote_signal_enum_t eSignal = vote.GetSignal();
+    if (eSignal == VOTE_SIGNAL_NONE || eSignal > MAX_SUPPORTED_VOTE_SIGNAL) {
+        return false;
+    }
+    if (fileVotes.HasVote(vote.GetHash())) {
+        return false;
+    }
+
+    vote_rec_t& voteRecordRef = mapCurrentMNVotes[vote.GetMasternodeOutpoint()];
+    auto ret = voteRecordRef.mapInstances.emplace(vote_instance_m_t::value_type(int(eSignal), vote_instance_t()));
+    vote_instance_t& voteInstanceRef = ret.first->second;
+    if (ret.second) {
+        UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
+    } else if (vote.GetTimestamp() < voteInstanceRef.nCreationTime) {
+        return false;
+    }
+
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, -1);
+    voteInstanceRef = vote_instance_t(vote.GetOutcome(), vote.GetTimestamp(), vote.GetTimestamp());
+    UpdateVoteTally(eSignal, voteInstanceRef.eOutcome, 1);
     fileVotes.AddVote(vote);
     fDirtyCache = true;
     return true;
 }
 
-void CGovernanceObject::ClearMasternodeVotes()
+std::map<COutPoint, std::set<uint256> > CGovernanceObject::ClearMasternodeVotes()
 {
     LOCK(cs);
 
     auto mnList = deterministicMNManager->GetListAtChainTip();
+    std::map<COutPoint, std::set<uint256> > mapRemoved;
 
     vote_m_it it = mapCurrentMNVotes.begin();
     while (it != mapCurrentMNVotes.end()) {
         if (!mnList.HasValidMNByCollateral(it->first)) {
-            fileVotes.RemoveVotesFromMasternode(it->first);
+            mapRemoved.emplace(it->first, fileVotes.RemoveVotesFromMasternode(it->first));
+            for (const auto& instancePair : it->second.mapInstances) {
+                UpdateVoteTally(instancePair.first, instancePair.second.eOutcome, -1);
+            }
             mapCurrentMNVotes.erase(it++);
+            fDirtyCache = true;
         } else {
             ++it;
         }
     }
+    return mapRemoved;
 }
 
 std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpoint)
@@ -252,18 +295,7 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
     }
 
     auto nParentHash = GetHash();
-    for (auto jt = it->second.mapInstances.begin(); jt != it->second.mapInstances.end(); ) {
-        CGovernanceVote tmpVote(mnOutpoint, nParentHash, (vote_signal_enum_t)jt->first, jt->second.eOutcome);
-        tmpVote.SetTime(jt->second.nCreationTime);
-        if (removedVotes.count(tmpVote.GetHash())) {
-            jt = it->second.mapInstances.erase(jt);
-        } else {
-            ++jt;
-        }
-    }
-    if (it->second.mapInstances.empty()) {
-        mapCurrentMNVotes.erase(it);
-    }
+    RemoveVoteInstances(it, removedVotes);
 
     if (!removedVotes.empty()) {
         std::string removedStr;
@@ -277,6 +309,40 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
     return removedVotes;
 }
 
+void CGovernanceObject::RemoveVotes(const COutPoint& mnOutpoint, const std::set<uint256>& setHashes)
+{
+    LOCK(cs);
+
+    if (fileVotes.RemoveVotes(setHashes) == 0) {
+        return;
+    }
+    auto it = mapCurrentMNVotes.find(mnOutpoint);
+    if (it != mapCurrentMNVotes.end()) {
+        RemoveVoteInstances(it, setHashes);
+    }
+    fDirtyCache = true;
+}
+
+void CGovernanceObject::RemoveVoteInstances(vote_m_it it, const std::set<uint256>& setRemoved)
+{
+    AssertLockHeld(cs);
+
+    auto nParentHash = GetHash();
+    for (auto jt = it->second.mapInstances.begin(); jt != it->second.mapInstances.end(); ) {
+        CGovernanceVote tmpVote(it->first, nParentHash, (vote_signal_enum_t)jt->first, jt->second.eOutcome);
+        tmpVote.SetTime(jt->second.nCreationTime);
+        if (setRemoved.count(tmpVote.GetHash())) {
+            UpdateVoteTally(jt->first, jt->second.eOutcome, -1);
+            jt = it->second.mapInstances.erase(jt);
+        } else {
+            ++jt;
+        }
+    }
+    if (it->second.mapInstances.empty()) {
+        mapCurrentMNVotes.erase(it);
+    }
+}
+
 std::string CGovernanceObject::GetSignatureMessage() const
 {
     LOCK(cs);
@@ -607,10 +673,37 @@ bool CGovernanceObject::IsCollateralValid(std::string& strError, bool& fMissingC
     return true;
 }
 
+void CGovernanceObject::UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta)
+{
+    AssertLockHeld(cs);
+
+    // out of range values can only come from a corrupted vote record, CountMatchingVotes counts those manually
+    if (nSignal < 0 || nSignal > MAX_SUPPORTED_VOTE_SIGNAL || eOutcome < VOTE_OUTCOME_NONE || eOutcome > VOTE_OUTCOME_ABSTAIN) {
+        return;
+    }
+    arrVoteTally[nSignal][eOutcome] += nDelta;
+}
+
+void CGovernanceObject::RebuildVoteTally()
+{
+    LOCK(cs);
+
+    arrVoteTally = {};
+    for (const auto& votepair : mapCurrentMNVotes) {
+        for (const auto& instancePair : votepair.second.mapInstances) {
+            UpdateVoteTally(instancePair.first, instancePair.second.eOutcome, 1);
+        }
+    }
+}
+
 int CGovernanceObject::CountMatchingVotes(vote_signal_enum_t eVoteSignalIn, vote_outcome_enum_t eVoteOutcomeIn) const
 {
     LOCK(cs);
 
+    if (eVoteSignalIn >= 0 && eVoteSignalIn <= MAX_SUPPORTED_VOTE_SIGNAL && eVoteOutcomeIn >= VOTE_OUTCOME_NONE && eVoteOutcomeIn <= VOTE_OUTCOME_ABSTAIN) {
+        return arrVoteTally[eVoteSignalIn][eVoteOutcomeIn];
+    }
+
     int nCount = 0;
     for (const auto& votepair : mapCurrentMNVotes) {
         const vote_rec_t& recVote = votepair.second;
@@ -18,6 +18,8 @@
 
 #include <univalue.h>
 
+#include <array>
+
 class CGovernanceManager;
 class CGovernanceTriggerManager;
 class CGovernanceObject;
@@ -180,6 +182,10 @@ private:
 
     vote_m_t mapCurrentMNVotes;
 
+    /// Number of vote instances in mapCurrentMNVotes per (signal, outcome), kept in sync with
+    /// mapCurrentMNVotes so that CountMatchingVotes doesn't have to walk all masternode votes
+    std::array<std::array<int, VOTE_OUTCOME_ABSTAIN + 1>, MAX_SUPPORTED_VOTE_SIGNAL + 1> arrVoteTally;
+
     CGovernanceObjectVoteFile fileVotes;
 
 public:
@@ -323,6 +329,9 @@ public:
             READWRITE(fExpired);
             READWRITE(mapCurrentMNVotes);
             READWRITE(fileVotes);
+            if (ser_action.ForRead()) {
+                RebuildVoteTally();
+            }
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp hash = %s, vote count = %d\n", GetHash().ToString(), fileVotes.GetVoteCount());
         }
 
@@ -332,6 +341,10 @@ public:
 private:
     // FUNCTIONS FOR DEALING WITH DATA STRING
     void LoadData();
+
+    // FUNCTIONS FOR KEEPING THE VOTE TALLY IN SYNC WITH mapCurrentMNVotes
+    void UpdateVoteTally(int nSignal, vote_outcome_enum_t eOutcome, int nDelta);
+    void RebuildVoteTally();
     void GetData(UniValue& objResult);
 
     bool ProcessVote(CNode* pfrom,
@@ -339,14 +352,26 @@ private:
         CGovernanceException& exception,
         CConnman& connman);
 
-    /// Called when MN's which have voted on this object have been removed
-    void ClearMasternodeVotes();
+    /// Re-apply a vote which was already validated before it was written to the governance journal.
+    /// Returns false if the vote is known or superseded.
+    bool ApplyStoredVote(const CGovernanceVote& vote);
+
+    /// Called when MN's which have voted on this object have been removed.
+    /// Returns the hashes of the removed votes by masternode.
+    std::map<COutPoint, std::set<uint256> > ClearMasternodeVotes();
 
     // Revalidate all votes from this MN and delete them if validation fails.
     // This is the case for DIP3 MNs that changed voting or operator keys and
     // also for MNs that were removed from the list completely.
     // Returns deleted vote hashes.
     std::set<uint256> RemoveInvalidVotes(const COutPoint& mnOutpoint);
+
+    /// Remove the given votes of a MN, used to replay vote removals from the governance journal
+    void RemoveVotes(const COutPoint& mnOutpoint, const std::set<uint256>& setHashes);
+
+private:
+    // Drop the vote instances of the MN at it whose votes are in setRemoved
+    void RemoveVoteInstances(vote_m_it it, const std::set<uint256>& setRemoved);
 };
 
 
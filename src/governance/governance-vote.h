@@ -68,7 +68,7 @@ private:
     std::vector<unsigned char> vchSig;
 
     /** Memory only. */
-    const uint256 hash;
+    uint256 hash;
     void UpdateHash() const;
 
 public:
@@ -4,19 +4,23 @@
 
 #include "governance-votedb.h"
 
+const uint64_t CGovernanceObjectVoteFile::CURSOR_BEGIN;
+const uint64_t CGovernanceObjectVoteFile::CURSOR_END;
+
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
     nMemoryVotes(0),
-    listVotes(),
-    mapVoteIndex()
+    vecVotes(),
+    mapVoteIndex(),
+    nNextSeq(1)
 {
 }
 
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
     nMemoryVotes(other.nMemoryVotes),
-    listVotes(other.listVotes),
-    mapVoteIndex()
+    vecVotes(other.vecVotes),
+    mapVoteIndex(other.mapVoteIndex),
+    nNextSeq(other.nNextSeq)
 {
-    RebuildIndex();
 }
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
@@ -25,8 +29,8 @@ void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
     // make sure to never add/update already known votes
     if (HasVote(nHash))
         return;
-    listVotes.push_front(vote);
-    mapVoteIndex.emplace(nHash, listVotes.begin());
+    mapVoteIndex.emplace(nHash, vecVotes.size());
+    vecVotes.push_back(vote_entry_t{nNextSeq++, vote});
     ++nMemoryVotes;
     RemoveOldVotes(vote);
 }
@@ -42,87 +46,86 @@ bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDat
     if (it == mapVoteIndex.end()) {
         return false;
     }
-    ss << *(it->second);
+    ss << vecVotes[it->second].vote;
     return true;
 }
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 {
     std::vector<CGovernanceVote> vecResult;
-    for (vote_l_cit it = listVotes.begin(); it != listVotes.end(); ++it) {
-        vecResult.push_back(*it);
+    vecResult.reserve(vecVotes.size());
+    for (vote_v_t::const_reverse_iterator it = vecVotes.rbegin(); it != vecVotes.rend(); ++it) {
+        vecResult.push_back(it->vote);
     }
     return vecResult;
 }
 
-void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
+std::set<uint256> CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
+    std::set<uint256> removedVotes;
+
+    RemoveVotesIf([&](const CGovernanceVote& vote) {
+        if (vote.GetMasternodeOutpoint() != outpointMasternode) {
+            return false;
         }
-    }
+        removedVotes.emplace(vote.GetHash());
+        return true;
+    });
+
+    return removedVotes;
+}
+
+size_t CGovernanceObjectVoteFile::RemoveVotes(const std::set<uint256>& setHashes)
+{
+    return RemoveVotesIf([&](const CGovernanceVote& vote) {
+        return setHashes.count(vote.GetHash()) != 0;
+    });
 }
 
 std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal)
 {
     std::set<uint256> removedVotes;
 
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
-            if (!it->IsValid(useVotingKey)) {
-                removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
-                continue;
-            }
+    RemoveVotesIf([&](const CGovernanceVote& vote) {
+        if (vote.GetMasternodeOutpoint() != outpointMasternode) {
+            return false;
         }
-        ++it;
-    }
+        bool useVotingKey = fProposal && (vote.GetSignal() == VOTE_SIGNAL_FUNDING);
+        if (vote.IsValid(useVotingKey)) {
+            return false;
+        }
+        removedVotes.emplace(vote.GetHash());
+        return true;
+    });
 
     return removedVotes;
 }
 
 void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
 {
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        if (it->GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
-            && it->GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
-            && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
-            && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
-        {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
-        } else {
-            ++it;
-        }
-    }
+    RemoveVotesIf([&](const CGovernanceVote& other) {
+        return other.GetMasternodeOutpoint() == vote.GetMasternodeOutpoint() // same masternode
+            && other.GetParentHash() == vote.GetParentHash() // same governance object (e.g. same proposal)
+            && other.GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
+            && other.GetTimestamp() < vote.GetTimestamp(); // older than new vote
+    });
 }
 
 void CGovernanceObjectVoteFile::RebuildIndex()
 {
     mapVoteIndex.clear();
+    mapVoteIndex.reserve(vecVotes.size());
     nMemoryVotes = 0;
-    vote_l_it it = listVotes.begin();
-    while (it != listVotes.end()) {
-        CGovernanceVote& vote = *it;
-        uint256 nHash = vote.GetHash();
-        if (mapVoteIndex.find(nHash) == mapVoteIndex.end()) {
-            mapVoteIndex[nHash] = it;
-            ++nMemoryVotes;
-            ++it;
-        } else {
-            listVotes.erase(it++);
+    size_t nPos = 0;
+    for (size_t i = 0; i < vecVotes.size(); ++i) {
+        uint256 nHash = vecVotes[i].vote.GetHash();
+        if (mapVoteIndex.emplace(nHash, nPos).second) {
+            if (nPos != i) {
+                vecVotes[nPos] = std::move(vecVotes[i]);
+            }
+            ++nPos;
         }
     }
+    vecVotes.erase(vecVotes.begin() + nPos, vecVotes.end());
+    nMemoryVotes = nPos;
 }
@@ -5,10 +5,15 @@
 #ifndef GOVERNANCE_VOTEDB_H
 #define GOVERNANCE_VOTEDB_H
 
-#include <list>
-#include <map>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include "governance-vote.h"
+#include "saltedhasher.h"
 #include "serialize.h"
 #include "streams.h"
 #include "uint256.h"
@@ -18,33 +23,53 @@
  * Recently received votes are held in memory until a maximum size is reached after
  * which older votes a flushed to a disk file.
  *
+ * Votes are kept in a contiguous vector in the order they were added, each tagged with
+ * an increasing sequence number. They are handed out newest first (the order of the old
+ * list based implementation) and can be walked in batches by sequence number (e.g. to
+ * sync them to a peer), so a cursor stays valid when votes are removed in between.
+ *
  * Note: This is a stub implementation that doesn't limit the number of votes held
  * in memory and doesn't flush to disk.
  */
 class CGovernanceObjectVoteFile
 {
 public: // Types
-    typedef std::list<CGovernanceVote> vote_l_t;
+    struct vote_entry_t {
+        uint64_t nSeq;
+        CGovernanceVote vote;
+    };
+
+    typedef std::vector<vote_entry_t> vote_v_t;
 
-    typedef vote_l_t::iterator vote_l_it;
+    typedef vote_v_t::iterator vote_v_it;
 
-    typedef vote_l_t::const_iterator vote_l_cit;
+    typedef vote_v_t::const_iterator vote_v_cit;
 
-    typedef std::map<uint256, vote_l_it> vote_m_t;
+    // vote hash -> position in vecVotes
+    typedef std::unordered_map<uint256, size_t, StaticSaltedHasher> vote_m_t;
 
     typedef vote_m_t::iterator vote_m_it;
 
     typedef vote_m_t::const_iterator vote_m_cit;
 
+    // Cursor to pass to ForEachVote() to start with the newest vote
+    static const uint64_t CURSOR_BEGIN = std::numeric_limits<uint64_t>::max();
+
+    // Cursor returned by ForEachVote() once all votes were visited
+    static const uint64_t CURSOR_END = 0;
+
 private:
     static const int MAX_MEMORY_VOTES = -1;
 
     int nMemoryVotes;
 
-    vote_l_t listVotes;
+    // oldest vote first, nSeq strictly increasing
+    vote_v_t vecVotes;
 
     vote_m_t mapVoteIndex;
 
+    uint64_t nNextSeq;
+
 public:
     CGovernanceObjectVoteFile();
 
@@ -65,32 +90,85 @@ public:
      */
     bool SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const;
 
-    int GetVoteCount()
+    int GetVoteCount() const
     {
         return nMemoryVotes;
     }
 
+    /**
+     * Return all votes, newest first
+     */
     std::vector<CGovernanceVote> GetVotes() const;
 
-    void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
+    /**
+     * Call func for up to nMaxCount votes, newest first, starting at nCursor (CURSOR_BEGIN
+     * for the newest vote). Returns the cursor to continue from, or CURSOR_END once all
+     * votes were visited. Votes added or removed in between calls don't make the walk
+     * skip or repeat any of the remaining older votes; votes added later are not visited.
+     */
+    template <typename Callable>
+    uint64_t ForEachVote(uint64_t nCursor, size_t nMaxCount, Callable&& func) const
+    {
+        // first vote which is newer than the cursor
+        vote_v_cit it = std::upper_bound(vecVotes.begin(), vecVotes.end(), nCursor,
+            [](uint64_t nSeq, const vote_entry_t& entry) { return nSeq < entry.nSeq; });
+        for (size_t nCount = 0; nCount < nMaxCount && it != vecVotes.begin(); ++nCount) {
+            --it;
+            func(it->vote);
+        }
+        if (it == vecVotes.begin()) {
+            return CURSOR_END;
+        }
+        return std::prev(it)->nSeq;
+    }
+
+    std::set<uint256> RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
     std::set<uint256> RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal);
+    size_t RemoveVotes(const std::set<uint256>& setHashes);
 
-    ADD_SERIALIZE_METHODS;
+    // Votes are serialized newest first, as a plain vector of votes
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << nMemoryVotes;
+        WriteCompactSize(s, vecVotes.size());
+        for (vote_v_t::const_reverse_iterator it = vecVotes.rbegin(); it != vecVotes.rend(); ++it) {
+            s << it->vote;
+        }
+    }
 
-    template <typename Stream, typename Operation>
-    inline void SerializationOp(Stream& s, Operation ser_action)
+    template <typename Stream>
+    void Unserialize(Stream& s)
     {
-        READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
-        if (ser_action.ForRead()) {
-            RebuildIndex();
+        std::vector<CGovernanceVote> vecVotesRead;
+        s >> nMemoryVotes;
+        s >> vecVotesRead;
+        vecVotes.clear();
+        vecVotes.reserve(vecVotesRead.size());
+        for (std::vector<CGovernanceVote>::reverse_iterator it = vecVotesRead.rbegin(); it != vecVotesRead.rend(); ++it) {
+            vecVotes.push_back(vote_entry_t{nNextSeq++, std::move(*it)});
         }
+        RebuildIndex();
     }
 
 private:
     // Drop older votes for the same gobject from the same masternode
     void RemoveOldVotes(const CGovernanceVote& vote);
 
+    // Remove all votes for which pred returns true, keeping the order of the remaining ones
+    template <typename Predicate>
+    size_t RemoveVotesIf(Predicate&& pred)
+    {
+        vote_v_it itEnd = std::remove_if(vecVotes.begin(), vecVotes.end(),
+            [&pred](const vote_entry_t& entry) { return pred(entry.vote); });
+        size_t nRemoved = vecVotes.end() - itEnd;
+        if (nRemoved != 0) {
+            vecVotes.erase(itEnd, vecVotes.end());
+            RebuildIndex();
+        }
+        return nRemoved;
+    }
+
     void RebuildIndex();
 };
 
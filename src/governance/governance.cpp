@@ -8,6 +8,7 @@
 #include "governance-object.h"
 #include "governance-validators.h"
 #include "governance-vote.h"
+#include "flat-database.h"
 #include "init.h"
 #include "masternode/masternode-meta.h"
 #include "masternode/masternode-sync.h"
@@ -39,6 +40,8 @@ CGovernanceManager::CGovernanceManager() :
     mapLastMasternodeObject(),
     setRequestedObjects(),
     fRateChecksEnabled(true),
+    fJournalCompactionNeeded(false),
+    fSnapshotLoaded(false),
     cs()
 {
 }
@@ -269,6 +272,8 @@ void CGovernanceManager::CheckOrphanVotes(CGovernanceObject& govobj, CGovernance
             fRemove = true;
         } else if (govobj.ProcessVote(nullptr, vote, exception, connman)) {
             vote.Relay(connman);
+            AddVoteToObjectRef(vote.GetHash(), &govobj);
+            journal.Append(CGovernanceJournal::RECORD_VOTE, vote);
             fRemove = true;
         }
         if (fRemove) {
@@ -307,6 +312,8 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
         return;
     }
 
+    journal.Append(CGovernanceJournal::RECORD_OBJECT, objpair.first->second);
+
     // SHOULD WE ADD THIS OBJECT TO ANY OTHER MANANGERS?
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::AddGovernanceObject -- Before trigger block, GetDataAsPlainString = %s, nObjectType = %d\n",
@@ -335,7 +342,7 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
     // WE MIGHT HAVE PENDING/ORPHAN VOTES FOR THIS OBJECT
 
     CGovernanceException exception;
-    CheckOrphanVotes(govobj, exception, connman);
+    CheckOrphanVotes(objpair.first->second, exception, connman);
 
     // SEND NOTIFICATION TO SCRIPT/ZMQ
     GetMainSignals().NotifyGovernanceObject(govobj);
@@ -354,7 +361,9 @@ void CGovernanceManager::UpdateCachesAndClean()
         if (it == mapObjects.end()) {
             continue;
         }
-        it->second.ClearMasternodeVotes();
+        for (const auto& removed : it->second.ClearMasternodeVotes()) {
+            journal.Append(CGovernanceJournal::RECORD_REMOVE_VOTES, std::make_pair(nHash, std::make_pair(removed.first, removed.second)));
+        }
         it->second.fDirtyCache = true;
     }
 
@@ -399,17 +408,7 @@ void CGovernanceManager::UpdateCachesAndClean()
             mmetaman.RemoveGovernanceObject(pObj->GetHash());
 
             // Remove vote references
-            const object_ref_cm_t::list_t& listItems = cmapVoteToObject.GetItemList();
-            object_ref_cm_t::list_cit lit = listItems.begin();
-            while (lit != listItems.end()) {
-                if (lit->value == pObj) {
-                    uint256 nKey = lit->key;
-                    ++lit;
-                    cmapVoteToObject.Erase(nKey);
-                } else {
-                    ++lit;
-                }
-            }
+            EraseObjectVoteRefs(nHash);
 
             int64_t nTimeExpired{0};
 
@@ -422,6 +421,7 @@ void CGovernanceManager::UpdateCachesAndClean()
             }
 
             mapErasedGovernanceObjects.insert(std::make_pair(nHash, nTimeExpired));
+            journal.Append(CGovernanceJournal::RECORD_ERASE_OBJECT, std::make_pair(nHash, nTimeExpired));
             mapObjects.erase(it++);
         } else {
             // NOTE: triggers are handled via triggerman
@@ -549,6 +549,12 @@ void CGovernanceManager::DoMaintenance(CConnman& connman)
     // CHECK AND REMOVE - REPROCESS GOVERNANCE OBJECTS
 
     UpdateCachesAndClean();
+
+    // MAKE SURE JOURNALED CHANGES SURVIVE A CRASH, REWRITE GOVERNANCE.DAT IF THE JOURNAL GREW TOO LARGE
+
+    if (journal.IsOpen()) {
+        CompactJournal();
+    }
 }
 
 bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
@@ -609,13 +615,11 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
     // do not provide any data until our node is synced
     if (!masternodeSync.IsSynced()) return;
 
-    int nVoteCount = 0;
-
     // SYNC GOVERNANCE OBJECTS WITH OTHER CLIENT
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- syncing single object to peer=%d, nProp = %s\n", __func__, pnode->id, nProp.ToString());
 
-    LOCK2(cs_main, cs);
+    LOCK(cs);
 
     // single valid object and its valid votes
     object_m_it it = mapObjects.find(nProp);
@@ -634,26 +638,11 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
         return;
     }
 
-    auto fileVotes = govobj.GetVoteFile();
-
-    for (const auto& vote : fileVotes.GetVotes()) {
-        uint256 nVoteHash = vote.GetHash();
-
-        bool onlyVotingKeyAllowed = govobj.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
-
-        if (filter.contains(nVoteHash) || !vote.IsValid(onlyVotingKeyAllowed)) {
-            continue;
-        }
-        pnode->PushInventory(CInv(MSG_GOVERNANCE_OBJECT_VOTE, nVoteHash));
-        ++nVoteCount;
-    }
-
-    CNetMsgMaker msgMaker(pnode->GetSendVersion());
-    connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, nVoteCount));
-    LogPrintf("CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, nVoteCount, pnode->id);
+    // votes are sent in batches from ProcessSyncCursors
+    AddSyncCursor(pnode, nProp, filter);
 }
 
-void CGovernanceManager::SyncObjects(CNode* pnode, CConnman& connman) const
+void CGovernanceManager::SyncObjects(CNode* pnode, CConnman& connman)
 {
     // do not provide any data until our node is synced
     if (!masternodeSync.IsSynced()) return;
@@ -667,37 +656,144 @@ void CGovernanceManager::SyncObjects(CNode* pnode, CConnman& connman) const
     }
     netfulfilledman.AddFulfilledRequest(pnode->addr, NetMsgType::MNGOVERNANCESYNC);
 
-    int nObjCount = 0;
-
     // SYNC GOVERNANCE OBJECTS WITH OTHER CLIENT
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- syncing all objects to peer=%d\n", __func__, pnode->id);
 
-    LOCK2(cs_main, cs);
+    LOCK(cs);
 
-    // all valid objects, no votes
-    for (const auto& objPair : mapObjects) {
-        uint256 nHash = objPair.first;
-        const CGovernanceObject& govobj = objPair.second;
-        std::string strHash = nHash.ToString();
+    // all valid objects, no votes, sent in batches from ProcessSyncCursors
+    CBloomFilter filter;
+    filter.clear();
+    AddSyncCursor(pnode, uint256(), filter);
+}
 
-        LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- attempting to sync govobj: %s, peer=%d\n", __func__, strHash, pnode->id);
+void CGovernanceManager::AddSyncCursor(CNode* pnode, const uint256& nProp, const CBloomFilter& filter)
+{
+    AssertLockHeld(cs);
 
-        if (govobj.IsSetCachedDelete() || govobj.IsSetExpired()) {
-            LogPrintf("CGovernanceManager::%s -- not syncing deleted/expired govobj: %s, peer=%d\n", __func__,
-                strHash, pnode->id);
-            continue;
+    auto& queue = mapSyncCursors[pnode->GetId()];
+    if (queue.size() >= GOVERNANCE_SYNC_MAX_CURSORS_PER_PEER) {
+        LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- too many pending sync requests, ignoring nProp = %s, peer=%d\n", __func__, nProp.ToString(), pnode->id);
+        return;
+    }
+    queue.emplace_back(nProp, filter);
+}
+
+void CGovernanceManager::ProcessSyncCursors(CConnman& connman)
+{
+    {
+        LOCK(cs);
+        if (mapSyncCursors.empty()) return;
+    }
+
+    std::set<NodeId> setConnected;
+    std::vector<CNode*> vNodesCopy = connman.CopyNodeVector(CConnman::FullyConnectedOnly);
+    for (CNode* pnode : vNodesCopy) {
+        setConnected.insert(pnode->GetId());
+        if (!pnode->fDisconnect) {
+            SendSyncBatch(pnode, connman);
         }
+    }
+    connman.ReleaseNodeVector(vNodesCopy);
 
-        // Push the inventory budget proposal message over to the other client
-        LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- syncing govobj: %s, peer=%d\n", __func__, strHash, pnode->id);
-        pnode->PushInventory(CInv(MSG_GOVERNANCE_OBJECT, nHash));
-        ++nObjCount;
+    // forget about peers which went away in the meantime
+    LOCK(cs);
+    auto it = mapSyncCursors.begin();
+    while (it != mapSyncCursors.end()) {
+        if (it->second.empty() || !setConnected.count(it->first)) {
+            mapSyncCursors.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CGovernanceManager::SendSyncBatch(CNode* pnode, CConnman& connman)
+{
+    // Only the scheduler thread advances cursors, so the front cursor can't
+    // change between the two locked sections below.
+
+    std::vector<CInv> vecInv;
+    std::vector<CGovernanceVote> vecVotes;
+    bool fObjects = false;
+    bool fProposal = false;
+    bool fDone = false;
+
+    // COLLECT THE NEXT BATCH
+
+    {
+        LOCK(cs);
+        auto itCursors = mapSyncCursors.find(pnode->GetId());
+        if (itCursors == mapSyncCursors.end() || itCursors->second.empty()) return;
+        CGovernanceSyncCursor& cursor = itCursors->second.front();
+
+        fObjects = cursor.nProp.IsNull();
+        if (fObjects) {
+            object_m_cit it = mapObjects.upper_bound(cursor.nLastObjectHash);
+            for (; it != mapObjects.end() && vecInv.size() < GOVERNANCE_SYNC_OBJECTS_PER_TICK; ++it) {
+                cursor.nLastObjectHash = it->first;
+                if (it->second.IsSetCachedDelete() || it->second.IsSetExpired()) {
+                    LogPrintf("CGovernanceManager::%s -- not syncing deleted/expired govobj: %s, peer=%d\n", __func__,
+                        it->first.ToString(), pnode->id);
+                    continue;
+                }
+                vecInv.emplace_back(MSG_GOVERNANCE_OBJECT, it->first);
+            }
+            fDone = it == mapObjects.end();
+        } else {
+            object_m_cit it = mapObjects.find(cursor.nProp);
+            if (it == mapObjects.end() || it->second.IsSetCachedDelete() || it->second.IsSetExpired()) {
+                // object went away while syncing, finish with what was sent so far
+                fDone = true;
+            } else {
+                fProposal = it->second.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL;
+                const CGovernanceObjectVoteFile& fileVotes = it->second.GetVoteFile();
+                cursor.nVoteCursor = fileVotes.ForEachVote(cursor.nVoteCursor, GOVERNANCE_SYNC_VOTES_PER_TICK, [&](const CGovernanceVote& vote) {
+                    if (!cursor.filter.contains(vote.GetHash())) {
+                        vecVotes.push_back(vote);
+                    }
+                });
+                fDone = cursor.nVoteCursor == CGovernanceObjectVoteFile::CURSOR_END;
+            }
+        }
+    }
+
+    // VERIFY VOTES WITHOUT HOLDING THE LOCK
+
+    for (const auto& vote : vecVotes) {
+        bool onlyVotingKeyAllowed = fProposal && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
+        if (vote.IsValid(onlyVotingKeyAllowed)) {
+            vecInv.emplace_back(MSG_GOVERNANCE_OBJECT_VOTE, vote.GetHash());
+        }
+    }
+
+    for (const auto& inv : vecInv) {
+        pnode->PushInventory(inv);
+    }
+
+    // ADVANCE THE CURSOR
+
+    int nCount = 0;
+    {
+        LOCK(cs);
+        auto itCursors = mapSyncCursors.find(pnode->GetId());
+        if (itCursors == mapSyncCursors.end() || itCursors->second.empty()) return;
+        CGovernanceSyncCursor& cursor = itCursors->second.front();
+        cursor.nCount += vecInv.size();
+        if (!fDone) return;
+        nCount = cursor.nCount;
+        itCursors->second.pop_front();
     }
 
     CNetMsgMaker msgMaker(pnode->GetSendVersion());
-    connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ, nObjCount));
-    LogPrintf("CGovernanceManager::%s -- sent %d objects to peer=%d\n", __func__, nObjCount, pnode->id);
+    if (fObjects) {
+        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ, nCount));
+        LogPrintf("CGovernanceManager::%s -- sent %d objects to peer=%d\n", __func__, nCount, pnode->id);
+    } else {
+        connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, nCount));
+        LogPrintf("CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, nCount, pnode->id);
+    }
 }
 
 void CGovernanceManager::MasternodeRateUpdate(const CGovernanceObject& govobj)
@@ -841,7 +937,10 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && AddVoteToObjectRef(nHashVote, &govobj);
+    if (fOk) {
+        journal.Append(CGovernanceJournal::RECORD_VOTE, vote);
+    }
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
@@ -936,11 +1035,11 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
 
         if (pObj) {
             filter = CBloomFilter(Params().GetConsensus().nGovernanceFilterElements, GOVERNANCE_FILTER_FP_RATE, GetRandInt(999999), BLOOM_UPDATE_ALL);
-            std::vector<CGovernanceVote> vecVotes = pObj->GetVoteFile().GetVotes();
-            nVoteCount = vecVotes.size();
-            for (const auto& vote : vecVotes) {
+            const CGovernanceObjectVoteFile& fileVotes = pObj->GetVoteFile();
+            nVoteCount = fileVotes.GetVoteCount();
+            fileVotes.ForEachVote(CGovernanceObjectVoteFile::CURSOR_BEGIN, nVoteCount, [&filter](const CGovernanceVote& vote) {
                 filter.insert(vote.GetHash());
-            }
+            });
         }
     }
 
@@ -1091,13 +1190,72 @@ void CGovernanceManager::RebuildIndexes()
     LOCK(cs);
 
     cmapVoteToObject.Clear();
+    mapObjectToVotes.clear();
     for (auto& objPair : mapObjects) {
         CGovernanceObject& govobj = objPair.second;
-        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
-        for (size_t i = 0; i < vecVotes.size(); ++i) {
-            cmapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
+        const CGovernanceObjectVoteFile& fileVotes = govobj.GetVoteFile();
+        fileVotes.ForEachVote(CGovernanceObjectVoteFile::CURSOR_BEGIN, fileVotes.GetVoteCount(), [&](const CGovernanceVote& vote) {
+            AddVoteToObjectRef(vote.GetHash(), &govobj);
+        });
+    }
+}
+
+bool CGovernanceManager::AddVoteToObjectRef(const uint256& nHashVote, CGovernanceObject* pGovobj)
+{
+    AssertLockHeld(cs);
+
+    std::vector<object_ref_cm_t::item_t> vecPruned;
+    if (!cmapVoteToObject.Insert(nHashVote, pGovobj, vecPruned)) {
+        return false;
+    }
+    mapObjectToVotes[pGovobj->GetHash()].insert(nHashVote);
+
+    // keep the reverse index in sync with whatever the cache limit evicted
+    for (const auto& item : vecPruned) {
+        auto it = mapObjectToVotes.find(item.value->GetHash());
+        if (it == mapObjectToVotes.end()) {
+            continue;
+        }
+        it->second.erase(item.key);
+        if (it->second.empty()) {
+            mapObjectToVotes.erase(it);
         }
     }
+    return true;
+}
+
+void CGovernanceManager::EraseVoteToObjectRef(const uint256& nHashVote)
+{
+    AssertLockHeld(cs);
+
+    CGovernanceObject* pGovobj = nullptr;
+    if (!cmapVoteToObject.Get(nHashVote, pGovobj)) {
+        return;
+    }
+    cmapVoteToObject.Erase(nHashVote);
+
+    auto it = mapObjectToVotes.find(pGovobj->GetHash());
+    if (it == mapObjectToVotes.end()) {
+        return;
+    }
+    it->second.erase(nHashVote);
+    if (it->second.empty()) {
+        mapObjectToVotes.erase(it);
+    }
+}
+
+void CGovernanceManager::EraseObjectVoteRefs(const uint256& nHashGovobj)
+{
+    AssertLockHeld(cs);
+
+    auto it = mapObjectToVotes.find(nHashGovobj);
+    if (it == mapObjectToVotes.end()) {
+        return;
+    }
+    for (const auto& nHashVote : it->second) {
+        cmapVoteToObject.Erase(nHashVote);
+    }
+    mapObjectToVotes.erase(it);
 }
 
 void CGovernanceManager::AddCachedTriggers()
@@ -1131,6 +1289,134 @@ void CGovernanceManager::InitOnLoad()
     LogPrintf("     %s\n", ToString());
 }
 
+bool CGovernanceManager::OpenJournal(const fs::path& pathJournal, bool fWipe)
+{
+    LOCK(cs);
+    if (fWipe) {
+        // governance.dat was not loaded, make sure it is rewritten on shutdown
+        fJournalCompactionNeeded = true;
+    }
+    return journal.Open(pathJournal, fWipe);
+}
+
+void CGovernanceManager::ReplayJournal()
+{
+    LOCK(cs);
+    if (!fSnapshotLoaded) {
+        // the journal describes changes to a state we don't have anymore
+        LogPrintf("governance.dat was not loaded, discarding %d bytes of governance journal\n", journal.GetSize());
+        journal.Reset();
+        fJournalCompactionNeeded = true;
+        return;
+    }
+    int64_t nStart = GetTimeMillis();
+    size_t nRecords = journal.Replay([this](CGovernanceJournal::RecordType type, CDataStream& ssRecord) {
+        ApplyJournalRecord(type, ssRecord);
+    });
+    LogPrintf("Replayed %d governance journal records (%d bytes)  %dms\n", nRecords, journal.GetSize(), GetTimeMillis() - nStart);
+}
+
+void CGovernanceManager::ApplyJournalRecord(CGovernanceJournal::RecordType type, CDataStream& ssRecord)
+{
+    AssertLockHeld(cs);
+
+    // Records may already be part of governance.dat if we crashed between writing
+    // it and discarding the journaled records it covers, so every record has to be
+    // safe to apply twice. Records are replayed in order, a vote removal undoes
+    // the votes journaled before it.
+    switch (type) {
+    case CGovernanceJournal::RECORD_OBJECT: {
+        CGovernanceObject govobj;
+        ssRecord >> govobj;
+        uint256 nHash = govobj.GetHash();
+        if (!mapErasedGovernanceObjects.count(nHash)) {
+            mapObjects.emplace(nHash, govobj);
+        }
+        break;
+    }
+    case CGovernanceJournal::RECORD_VOTE: {
+        CGovernanceVote vote;
+        ssRecord >> vote;
+        auto it = mapObjects.find(vote.GetParentHash());
+        if (it != mapObjects.end()) {
+            it->second.ApplyStoredVote(vote);
+        }
+        break;
+    }
+    case CGovernanceJournal::RECORD_REMOVE_VOTES: {
+        std::pair<uint256, std::pair<COutPoint, std::set<uint256> > > removed;
+        ssRecord >> removed;
+        auto it = mapObjects.find(removed.first);
+        if (it != mapObjects.end()) {
+            it->second.RemoveVotes(removed.second.first, removed.second.second);
+        }
+        break;
+    }
+    case CGovernanceJournal::RECORD_ERASE_OBJECT: {
+        std::pair<uint256, int64_t> erased;
+        ssRecord >> erased;
+        mapObjects.erase(erased.first);
+        mapErasedGovernanceObjects.insert(erased);
+        break;
+    }
+    default:
+        throw std::runtime_error(strprintf("unknown governance journal record type %d", type));
+    }
+}
+
+bool CGovernanceManager::IsFullDumpNeeded(uint64_t nSnapshotSize) const
+{
+    LOCK(cs);
+    if (!journal.IsOpen() || fJournalCompactionNeeded) {
+        return true;
+    }
+    return journal.GetSize() > std::max(GOVERNANCE_JOURNAL_MIN_COMPACT_SIZE, nSnapshotSize / GOVERNANCE_JOURNAL_COMPACT_RATIO);
+}
+
+void CGovernanceManager::FlushJournal()
+{
+    LOCK(cs);
+    journal.Flush();
+}
+
+void CGovernanceManager::CompactJournal()
+{
+    AssertLockNotHeld(cs);
+    // one compaction at a time, the journal size recorded below must stay valid until the end
+    LOCK(csJournalCompaction);
+
+    fs::path pathSnapshot = GetDataDir() / "governance.dat";
+    uint64_t nSnapshotSize = fs::exists(pathSnapshot) ? fs::file_size(pathSnapshot) : 0;
+
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    uint64_t nJournalSize;
+    {
+        LOCK(cs);
+        if (!IsFullDumpNeeded(nSnapshotSize)) {
+            journal.Flush();
+            return;
+        }
+        // everything journaled up to here is part of the snapshot, records appended while
+        // the snapshot is written are kept
+        ssSnapshot << *this;
+        nJournalSize = journal.GetSize();
+    }
+
+    // the snapshot replaces governance.dat atomically, the journal is only touched once it's on disk
+    CFlatDB<CGovernanceManager> flatdb("governance.dat", "magicGovernanceCache");
+    if (!flatdb.DumpSerialized(ssSnapshot)) {
+        LogPrintf("CGovernanceManager::%s -- Failed to write governance.dat, keeping the journal\n", __func__);
+        LOCK(cs);
+        journal.Flush();
+        return;
+    }
+
+    LOCK(cs);
+    if (journal.Discard(nJournalSize)) {
+        fJournalCompactionNeeded = false;
+    }
+}
+
 std::string CGovernanceManager::ToString() const
 {
     LOCK(cs);
@@ -1292,8 +1578,9 @@ void CGovernanceManager::RemoveInvalidVotes()
             if (removed.empty()) {
                 continue;
             }
+            journal.Append(CGovernanceJournal::RECORD_REMOVE_VOTES, std::make_pair(p.first, std::make_pair(outpoint, removed)));
             for (auto& voteHash : removed) {
-                cmapVoteToObject.Erase(voteHash);
+                EraseVoteToObjectRef(voteHash);
                 cmapInvalidVotes.Erase(voteHash);
                 cmmapOrphanVotes.Erase(voteHash);
                 setRequestedVotes.erase(voteHash);
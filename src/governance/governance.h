@@ -10,6 +10,7 @@
 #include "cachemultimap.h"
 #include "chain.h"
 #include "governance-exceptions.h"
+#include "governance-journal.h"
 #include "governance-object.h"
 #include "governance-vote.h"
 #include "net.h"
@@ -19,6 +20,8 @@
 
 #include "evo/deterministicmns.h"
 
+#include <deque>
+
 #include <univalue.h>
 
 class CGovernanceManager;
@@ -38,8 +41,40 @@ struct ExpirationInfo {
 
 typedef std::pair<CGovernanceObject, ExpirationInfo> object_info_pair_t;
 
+/**
+ * Progress of syncing either the list of governance objects (nProp is null) or
+ * the votes of a single object to a peer. The sync is sent in bounded batches
+ * and resumed from here on the next tick.
+ */
+struct CGovernanceSyncCursor {
+    uint256 nProp;
+    // votes the peer told us it already has
+    CBloomFilter filter;
+    // object list: hash of the last object looked at
+    uint256 nLastObjectHash;
+    // votes: where to continue in the object's vote file (see CGovernanceObjectVoteFile::ForEachVote)
+    uint64_t nVoteCursor;
+    // number of inventory items sent so far
+    int nCount;
+
+    CGovernanceSyncCursor(const uint256& nPropIn, const CBloomFilter& filterIn) :
+        nProp(nPropIn), filter(filterIn), nLastObjectHash(), nVoteCursor(CGovernanceObjectVoteFile::CURSOR_BEGIN), nCount(0) {}
+};
+
 static const int RATE_BUFFER_SIZE = 5;
 
+/** Maximum number of object inventories sent to a single peer per sync tick */
+static const size_t GOVERNANCE_SYNC_OBJECTS_PER_TICK = 500;
+/** Maximum number of votes looked at for a single peer per sync tick */
+static const size_t GOVERNANCE_SYNC_VOTES_PER_TICK = 1000;
+/** Maximum number of pending sync requests per peer, anything above is ignored */
+static const size_t GOVERNANCE_SYNC_MAX_CURSORS_PER_PEER = 8;
+
+/** The governance journal is compacted into governance.dat once it grows beyond this size... */
+static const uint64_t GOVERNANCE_JOURNAL_MIN_COMPACT_SIZE = 32 * 1024 * 1024;
+/** ...and beyond this fraction (1/n) of the size of governance.dat */
+static const uint64_t GOVERNANCE_JOURNAL_COMPACT_RATIO = 2;
+
 class CRateCheckBuffer
 {
 private:
@@ -246,6 +281,9 @@ private:
 
     object_ref_cm_t cmapVoteToObject;
 
+    // reverse index of cmapVoteToObject: governance object hash -> hashes of its votes in cmapVoteToObject
+    std::map<uint256, hash_s_t> mapObjectToVotes;
+
     vote_cm_t cmapInvalidVotes;
 
     vote_cmm_t cmmapOrphanVotes;
@@ -256,11 +294,26 @@ private:
 
     hash_s_t setRequestedVotes;
 
+    // pending incremental syncs, per peer in the order they were requested
+    std::map<NodeId, std::deque<CGovernanceSyncCursor> > mapSyncCursors;
+
     bool fRateChecksEnabled;
 
     // used to check for changed voting keys
     CDeterministicMNList lastMNListForVotingKeys;
 
+    // changes made since governance.dat was written
+    CGovernanceJournal journal;
+
+    // set when governance.dat has to be rewritten regardless of the journal size (e.g. it was not loaded)
+    bool fJournalCompactionNeeded;
+
+    // serializes CompactJournal calls from the maintenance thread and shutdown
+    CCriticalSection csJournalCompaction;
+
+    // set once governance.dat was read completely, the journal only applies on top of it
+    bool fSnapshotLoaded;
+
     class ScopedLockBool
     {
         bool& ref;
@@ -297,7 +350,10 @@ public:
     bool ConfirmInventoryRequest(const CInv& inv);
 
     void SyncSingleObjVotes(CNode* pnode, const uint256& nProp, const CBloomFilter& filter, CConnman& connman);
-    void SyncObjects(CNode* pnode, CConnman& connman) const;
+    void SyncObjects(CNode* pnode, CConnman& connman);
+
+    /// Send the next batch of every pending sync, called periodically from the scheduler
+    void ProcessSyncCursors(CConnman& connman);
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
@@ -323,9 +379,11 @@ public:
         mapObjects.clear();
         mapErasedGovernanceObjects.clear();
         cmapVoteToObject.Clear();
+        mapObjectToVotes.clear();
         cmapInvalidVotes.Clear();
         cmmapOrphanVotes.Clear();
         mapLastMasternodeObject.clear();
+        mapSyncCursors.clear();
     }
 
     std::string ToString() const;
@@ -355,6 +413,9 @@ public:
             Clear();
             return;
         }
+        if (ser_action.ForRead()) {
+            fSnapshotLoaded = true;
+        }
     }
 
     void UpdatedBlockTip(const CBlockIndex* pindex, CConnman& connman);
@@ -409,12 +470,27 @@ public:
 
     void InitOnLoad();
 
+    /// Open the governance journal, wiping it if fWipe is set (governance.dat was not loaded)
+    bool OpenJournal(const fs::path& pathJournal, bool fWipe);
+    /// Apply the changes from the journal on top of the loaded governance.dat. The journal is
+    /// discarded instead if governance.dat was missing, invalid or of an older version.
+    void ReplayJournal();
+    /// Whether governance.dat (of size nSnapshotSize) should be rewritten instead of only flushing the journal
+    bool IsFullDumpNeeded(uint64_t nSnapshotSize) const;
+    void FlushJournal();
+    /// Rewrite governance.dat from a snapshot and discard the journaled records it covers if
+    /// IsFullDumpNeeded, only flush the journal otherwise. Must not be called with cs held.
+    void CompactJournal();
+
     int RequestGovernanceObjectVotes(CNode* pnode, CConnman& connman);
     int RequestGovernanceObjectVotes(const std::vector<CNode*>& vNodesCopy, CConnman& connman);
 
 private:
     void RequestGovernanceObject(CNode* pfrom, const uint256& nHash, CConnman& connman, bool fUseFilter = false);
 
+    void AddSyncCursor(CNode* pnode, const uint256& nProp, const CBloomFilter& filter);
+    void SendSyncBatch(CNode* pnode, CConnman& connman);
+
     void AddInvalidVote(const CGovernanceVote& vote)
     {
         cmapInvalidVotes.Insert(vote.GetHash(), vote);
@@ -439,8 +515,19 @@ private:
 
     void RebuildIndexes();
 
+    /// Add a vote to cmapVoteToObject and the reverse index, returns false if the vote is already known
+    bool AddVoteToObjectRef(const uint256& nHashVote, CGovernanceObject* pGovobj);
+
+    /// Remove a vote from cmapVoteToObject and the reverse index
+    void EraseVoteToObjectRef(const uint256& nHashVote);
+
+    /// Remove all votes of a governance object from cmapVoteToObject and the reverse index
+    void EraseObjectVoteRefs(const uint256& nHashGovobj);
+
     void AddCachedTriggers();
 
+    void ApplyJournalRecord(CGovernanceJournal::RecordType type, CDataStream& ssRecord);
+
     void RequestOrphanObjects(CConnman& connman);
 
     void CleanOrphanObjects();
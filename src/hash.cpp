@@ -7,6 +7,8 @@
 #include "crypto/hmac_sha512.h"
 #include "pubkey.h"
 
+#include <algorithm>
+
 
 inline uint32_t ROTL32(uint32_t x, int8_t r)
 {
@@ -249,3 +251,53 @@ uint64_t SipHashUint256Extra(uint64_t k0, uint64_t k1, const uint256& val, uint3
     SIPROUND;
     return v0 ^ v1 ^ v2 ^ v3;
 }
+
+/** Number of messages HashX11Many pushes through one stage before moving on to the next */
+static const size_t X11_BATCH_LANES = 8;
+
+template <typename Context>
+static inline void HashX11Stage(void (*init)(void*), void (*update)(void*, const void*, size_t), void (*close)(void*, void*),
+                                const uint512* in, uint512* out, size_t nLanes)
+{
+    Context ctxInit;
+    init(&ctxInit);
+    for (size_t i = 0; i < nLanes; i++) {
+        Context ctx = ctxInit;
+        update(&ctx, &in[i], 64);
+        close(&ctx, &out[i]);
+    }
+}
+
+void HashX11Many(const unsigned char* pdata, size_t nLen, size_t nCount, uint256* pout)
+{
+    static unsigned char pblank[1];
+    uint512 a[X11_BATCH_LANES];
+    uint512 b[X11_BATCH_LANES];
+
+    sph_blake512_context ctxBlakeInit;
+    sph_blake512_init(&ctxBlakeInit);
+
+    for (size_t nBase = 0; nBase < nCount; nBase += X11_BATCH_LANES) {
+        size_t nLanes = std::min(X11_BATCH_LANES, nCount - nBase);
+
+        for (size_t i = 0; i < nLanes; i++) {
+            sph_blake512_context ctx = ctxBlakeInit;
+            sph_blake512(&ctx, nLen ? static_cast<const void*>(pdata + (nBase + i) * nLen) : pblank, nLen);
+            sph_blake512_close(&ctx, &a[i]);
+        }
+        HashX11Stage<sph_bmw512_context>(sph_bmw512_init, sph_bmw512, sph_bmw512_close, a, b, nLanes);
+        HashX11Stage<sph_groestl512_context>(sph_groestl512_init, sph_groestl512, sph_groestl512_close, b, a, nLanes);
+        HashX11Stage<sph_skein512_context>(sph_skein512_init, sph_skein512, sph_skein512_close, a, b, nLanes);
+        HashX11Stage<sph_jh512_context>(sph_jh512_init, sph_jh512, sph_jh512_close, b, a, nLanes);
+        HashX11Stage<sph_keccak512_context>(sph_keccak512_init, sph_keccak512, sph_keccak512_close, a, b, nLanes);
+        HashX11Stage<sph_luffa512_context>(sph_luffa512_init, sph_luffa512, sph_luffa512_close, b, a, nLanes);
+        HashX11Stage<sph_cubehash512_context>(sph_cubehash512_init, sph_cubehash512, sph_cubehash512_close, a, b, nLanes);
+        HashX11Stage<sph_shavite512_context>(sph_shavite512_init, sph_shavite512, sph_shavite512_close, b, a, nLanes);
+        HashX11Stage<sph_simd512_context>(sph_simd512_init, sph_simd512, sph_simd512_close, a, b, nLanes);
+        HashX11Stage<sph_echo512_context>(sph_echo512_init, sph_echo512, sph_echo512_close, b, a, nLanes);
+
+        for (size_t i = 0; i < nLanes; i++) {
+            pout[nBase + i] = a[i].trim256();
+        }
+    }
+}
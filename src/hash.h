@@ -378,4 +378,13 @@ inline uint256 HashX11(const T1 pbegin, const T1 pend)
     return hash[10].trim256();
 }
 
+/**
+ * Compute HashX11 of nCount messages of nLen bytes each, stored back to back at pdata
+ * (e.g. serialized block headers), writing the results to pout[0..nCount).
+ * The messages are run through the eleven stages in small groups, one stage at a time,
+ * which keeps the code and tables of each function hot instead of cycling through all
+ * of them for every single message.
+ */
+void HashX11Many(const unsigned char* pdata, size_t nLen, size_t nCount, uint256* pout);
+
 #endif // BITCOIN_HASH_H
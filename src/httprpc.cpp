@@ -7,8 +7,11 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "httpserver.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "rpc/server.h"
+#include "txmempool.h"
+#include "validation.h"
 #include "random.h"
 #include "sync.h"
 #include "util.h"
@@ -147,6 +150,24 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** Maximum size of JSON-RPC requests which are parsed on the HTTP event thread to route them by method */
+static const size_t MAX_ROUTED_REQUEST_SIZE = 4096;
+
+/** RPC method of a single small JSON-RPC request, so cheap calls can be routed to their own work queue */
+static std::string HTTPReq_JSONRPC_Method(HTTPRequest* req)
+{
+    if (req->GetRequestMethod() != HTTPRequest::POST)
+        return "";
+    UniValue valRequest;
+    if (!valRequest.read(req->PeekBody(MAX_ROUTED_REQUEST_SIZE)) || !valRequest.isObject())
+        return "";
+    const UniValue& method = find_value(valRequest, "method");
+    // only known methods, so clients can't make up endpoints for the statistics
+    if (!method.isStr() || !tableRPC[method.get_str()])
+        return "";
+    return method.get_str();
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -190,10 +211,49 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
-            UniValue result = tableRPC.execute(jreq);
+            // Handlers of large results may stream them. The reply switches to chunked transfer
+            // once the first chunk is full, smaller results are sent in one piece as usual.
+            CJSONStreamWriter writer([req](const std::string& strChunk) {
+                // handlers hold the writer while they hold these, see CJSONStreamHold
+                AssertLockNotHeld(cs_main);
+                AssertLockNotHeld(mempool.cs);
+                if (!req->IsReplyChunked()) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartReplyChunked(HTTP_OK);
+                    req->WriteReplyChunk("{\"result\":");
+                }
+                req->WriteReplyChunk(strChunk);
+            });
+            jreq.streamWriter = &writer;
+
+            UniValue result;
+            try {
+                result = tableRPC.execute(jreq);
+            } catch (...) {
+                if (req->IsReplyChunked()) {
+                    // Too late for an error reply. Close the connection before the terminating
+                    // chunk, so the client sees a broken transfer rather than truncated JSON.
+                    LogPrintf("%s: %s failed after part of the result was sent\n", __func__, SanitizeString(jreq.strMethod));
+                    req->AbortReplyChunked();
+                    return false;
+                }
+                throw;
+            }
+
+            std::string strTail = ",\"error\":null,\"id\":" + jreq.id.write() + "}\n";
+            if (req->IsReplyChunked()) {
+                writer.Flush();
+                req->WriteReplyChunk(strTail);
+                req->EndReplyChunked();
+                return true;
+            }
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            if (writer.GetBytesWritten() > 0) {
+                strReply = "{\"result\":" + writer.TakeBuffer() + strTail;
+            } else {
+                strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            }
 
         // array of requests
         } else if (valRequest.isArray())
@@ -237,7 +297,7 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPReq_JSONRPC_Method);
 
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
@@ -11,6 +11,9 @@
 #include "rpc/protocol.h" // For HTTP status codes
 #include "sync.h"
 #include "ui_interface.h"
+#include "utilstrencodings.h"
+#include "utiltime.h"
+#include "mpmcqueue.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -19,9 +22,15 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <condition_variable>
 #include <future>
+#include <map>
+#include <mutex>
+
+#include <boost/algorithm/string.hpp>
 
 #include <event2/event.h>
+#include <event2/bufferevent.h>
 #include <event2/http.h>
 #include <event2/thread.h>
 #include <event2/buffer.h>
@@ -38,39 +47,25 @@
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
 
-/** HTTP request work item */
-class HTTPWorkItem : public HTTPClosure
-{
-public:
-    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func):
-        req(std::move(_req)), path(_path), func(_func)
-    {
-    }
-    void operator()() override
-    {
-        func(req.get(), path);
-    }
-
-    std::unique_ptr<HTTPRequest> req;
-
-private:
-    std::string path;
-    HTTPRequestHandler func;
-};
-
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
+ *
+ * Items are passed to the workers through a lock-free queue, the mutex is only used
+ * to let idle workers sleep until there is something to do.
  */
 template <typename WorkItem>
 class WorkQueue
 {
 private:
-    /** Mutex protects entire object */
+    CMPMCQueue<WorkItem*> queue;
+    /** Number of queued items, admission is decided on this and not on the queue capacity */
+    std::atomic<size_t> depth;
+    std::atomic<bool> running;
+    size_t maxDepth;
+    /** Mutex protects numThreads and sleeping on cond */
     std::mutex cs;
     std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
-    size_t maxDepth;
+    std::atomic<int> numSleeping;
     int numThreads;
 
     /** RAII object to keep track of number of running worker threads */
@@ -92,8 +87,11 @@ private:
     };
 
 public:
-    WorkQueue(size_t _maxDepth) : running(true),
+    WorkQueue(size_t _maxDepth) : queue(_maxDepth),
+                                 depth(0),
+                                 running(true),
                                  maxDepth(_maxDepth),
+                                 numSleeping(0),
                                  numThreads(0)
     {
     }
@@ -102,16 +100,28 @@ public:
      */
     ~WorkQueue()
     {
+        WorkItem* item;
+        while (queue.Pop(item)) {
+            delete item;
+        }
     }
     /** Enqueue a work item */
     bool Enqueue(WorkItem* item)
     {
-        std::unique_lock<std::mutex> lock(cs);
-        if (queue.size() >= maxDepth) {
+        if (depth.fetch_add(1) >= maxDepth) {
+            depth.fetch_sub(1);
             return false;
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        // can't fail, the queue has room for at least maxDepth items
+        bool pushed = queue.Push(item);
+        assert(pushed);
+        // pairs with the fence in Run: either the worker going to sleep sees the item,
+        // or we see the worker and wake it up
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (numSleeping.load() > 0) {
+            std::lock_guard<std::mutex> lock(cs);
+            cond.notify_one();
+        }
         return true;
     }
     /** Thread function */
@@ -119,16 +129,19 @@ public:
     {
         ThreadCounter count(*this);
         while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
+            WorkItem* item = nullptr;
+            if (!queue.Pop(item)) {
                 std::unique_lock<std::mutex> lock(cs);
-                while (running && queue.empty())
+                numSleeping++;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                while (running && !queue.Pop(item))
                     cond.wait(lock);
-                if (!running)
-                    break;
-                i = std::move(queue.front());
-                queue.pop_front();
+                numSleeping--;
             }
+            std::unique_ptr<WorkItem> i(item);
+            if (!running)
+                break;
+            depth.fetch_sub(1);
             (*i)();
         }
     }
@@ -147,18 +160,58 @@ public:
             cond.wait(lock);
         }
     }
+    size_t Depth() const { return depth; }
+    size_t MaxDepth() const { return maxDepth; }
+};
+
+/** Work queue with its own worker threads, requests are routed to it by RPC method or
+ * URI prefix (see -rpcqueue and -rpcroute)
+ */
+struct HTTPWorkQueue
+{
+    HTTPWorkQueue(const std::string& _name, int _numThreads, size_t _maxDepth, int64_t _timeout):
+        name(_name), numThreads(_numThreads), maxDepth(_maxDepth), timeout(_timeout)
+    {
+    }
+    std::string name;
+    int numThreads;
+    size_t maxDepth;
+    int64_t timeout; // milliseconds, 0 if requests never time out
+    std::unique_ptr<WorkQueue<HTTPClosure>> queue;
+};
+
+/** HTTP request work item */
+class HTTPWorkItem : public HTTPClosure
+{
+public:
+    HTTPWorkItem(std::unique_ptr<HTTPRequest> _req, const std::string &_path, const HTTPRequestHandler& _func,
+                 const HTTPWorkQueue* _queue, const std::string& _endpoint):
+        req(std::move(_req)), path(_path), func(_func), queue(_queue), endpoint(_endpoint), enqueueTime(GetTimeMicros())
+    {
+    }
+    void operator()() override;
+
+    std::unique_ptr<HTTPRequest> req;
+
+private:
+    std::string path;
+    HTTPRequestHandler func;
+    const HTTPWorkQueue* queue;
+    std::string endpoint;
+    int64_t enqueueTime;
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
 };
 
 /** HTTP module state */
@@ -169,13 +222,174 @@ static struct event_base* eventBase = 0;
 struct evhttp* eventHTTP = 0;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = 0;
+//! Work queues for handling longer requests off the event loop thread, the first one is the default queue
+static std::vector<std::unique_ptr<HTTPWorkQueue>> workQueues;
+//! RPC methods handled by other than the default queue
+static std::map<std::string, HTTPWorkQueue*> mapMethodRoutes;
+//! URI prefixes handled by other than the default queue
+static std::vector<std::pair<std::string, HTTPWorkQueue*>> vPrefixRoutes;
+//! Cheap calls which are used for health checks and shouldn't wait behind slow ones
+static const char* const HTTP_FAST_METHODS[] = {"getbestblockhash", "getbestchainlock", "getblockcount", "uptime"};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
 std::vector<evhttp_bound_socket *> boundSockets;
 
+//! Protects the statistics below
+static std::mutex cs_httpStats;
+static std::map<std::string, HTTPWorkQueueStats> mapQueueStats;
+static std::map<std::string, HTTPEndpointStats> mapEndpointStats;
+
+static void RecordHTTPRequest(const HTTPWorkQueue* queue, const std::string& endpoint, bool rejected, bool timedOut, int64_t waitTime)
+{
+    std::lock_guard<std::mutex> lock(cs_httpStats);
+    HTTPWorkQueueStats& queueStats = mapQueueStats[queue->name];
+    HTTPEndpointStats& endpointStats = mapEndpointStats[endpoint];
+    endpointStats.queue = queue->name;
+    if (rejected) {
+        queueStats.nRejected++;
+        endpointStats.nRejected++;
+        return;
+    }
+    queueStats.nRequests++;
+    endpointStats.nRequests++;
+    if (timedOut) {
+        queueStats.nTimedOut++;
+        endpointStats.nTimedOut++;
+    }
+    queueStats.nTotalWaitTime += waitTime;
+    endpointStats.nTotalWaitTime += waitTime;
+    queueStats.nMaxWaitTime = std::max(queueStats.nMaxWaitTime, waitTime);
+    endpointStats.nMaxWaitTime = std::max(endpointStats.nMaxWaitTime, waitTime);
+}
+
+void HTTPWorkItem::operator()()
+{
+    int64_t waitTime = GetTimeMicros() - enqueueTime;
+    bool timedOut = queue->timeout > 0 && waitTime > queue->timeout * 1000;
+    RecordHTTPRequest(queue, endpoint, false, timedOut, waitTime);
+    if (timedOut) {
+        // the client has most likely given up already, don't waste a worker on it
+        LogPrint(BCLog::HTTP, "Dropping request for %s after %d ms in work queue %s\n", endpoint, waitTime / 1000, queue->name);
+        req->WriteReply(HTTP_SERVUNAVAIL, "Request timed out in work queue");
+        return;
+    }
+    func(req.get(), path);
+}
+
+void GetHTTPWorkQueueStats(std::vector<HTTPWorkQueueStats>& vQueueStats, std::vector<HTTPEndpointStats>& vEndpointStats)
+{
+    std::lock_guard<std::mutex> lock(cs_httpStats);
+    vQueueStats.clear();
+    for (const auto& queue : workQueues) {
+        HTTPWorkQueueStats stats = mapQueueStats[queue->name];
+        stats.name = queue->name;
+        stats.nThreads = queue->numThreads;
+        stats.nDepth = queue->queue ? queue->queue->Depth() : 0;
+        stats.nMaxDepth = queue->maxDepth;
+        stats.nTimeout = queue->timeout;
+        vQueueStats.push_back(stats);
+    }
+    vEndpointStats.clear();
+    for (const auto& p : mapEndpointStats) {
+        vEndpointStats.push_back(p.second);
+        vEndpointStats.back().endpoint = p.first;
+    }
+}
+
+static HTTPWorkQueue* FindHTTPWorkQueue(const std::string& name)
+{
+    for (const auto& queue : workQueues) {
+        if (queue->name == name)
+            return queue.get();
+    }
+    return nullptr;
+}
+
+/** Set up the work queues and routes from -rpcthreads, -rpcworkqueue, -rpcqueue and -rpcroute */
+static bool InitHTTPWorkQueues()
+{
+    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
+    int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
+    int64_t queueTimeout = std::max(GetArg("-rpcqueuetimeout", DEFAULT_HTTP_QUEUE_TIMEOUT), (int64_t)0);
+
+    workQueues.emplace_back(new HTTPWorkQueue("default", rpcThreads, workQueueDepth, queueTimeout));
+    workQueues.emplace_back(new HTTPWorkQueue("fast", DEFAULT_HTTP_FAST_THREADS, workQueueDepth, queueTimeout));
+    for (const char* method : HTTP_FAST_METHODS) {
+        mapMethodRoutes[method] = workQueues.back().get();
+    }
+
+    if (mapMultiArgs.count("-rpcqueue")) {
+        for (const std::string& strQueue : mapMultiArgs.at("-rpcqueue")) {
+            std::vector<std::string> vParts;
+            boost::split(vParts, strQueue, boost::is_any_of(":"));
+            int32_t numThreads, maxDepth;
+            int64_t timeout = queueTimeout;
+            if (vParts.size() < 3 || vParts.size() > 4 || vParts[0].empty() ||
+                !ParseInt32(vParts[1], &numThreads) || numThreads < 1 ||
+                !ParseInt32(vParts[2], &maxDepth) || maxDepth < 1 ||
+                (vParts.size() == 4 && (!ParseInt64(vParts[3], &timeout) || timeout < 0))) {
+                uiInterface.ThreadSafeMessageBox(
+                    strprintf("Invalid -rpcqueue specification: %s. Valid is <name>:<threads>:<depth>[:<timeout>].", strQueue),
+                    "", CClientUIInterface::MSG_ERROR);
+                return false;
+            }
+            HTTPWorkQueue* queue = FindHTTPWorkQueue(vParts[0]);
+            if (!queue) {
+                workQueues.emplace_back(new HTTPWorkQueue(vParts[0], numThreads, maxDepth, timeout));
+            } else {
+                queue->numThreads = numThreads;
+                queue->maxDepth = maxDepth;
+                queue->timeout = timeout;
+            }
+        }
+    }
+
+    if (mapMultiArgs.count("-rpcroute")) {
+        for (const std::string& strRoute : mapMultiArgs.at("-rpcroute")) {
+            size_t pos = strRoute.find(':');
+            HTTPWorkQueue* queue = pos == std::string::npos ? nullptr : FindHTTPWorkQueue(strRoute.substr(0, pos));
+            if (!queue || pos + 1 == strRoute.size()) {
+                uiInterface.ThreadSafeMessageBox(
+                    strprintf("Invalid -rpcroute specification: %s. Valid is <queue>:<method> or <queue>:<uri prefix>, with a queue defined by -rpcqueue.", strRoute),
+                    "", CClientUIInterface::MSG_ERROR);
+                return false;
+            }
+            std::string target = strRoute.substr(pos + 1);
+            if (target[0] == '/') {
+                vPrefixRoutes.emplace_back(target, queue);
+            } else {
+                mapMethodRoutes[target] = queue;
+            }
+        }
+    }
+
+    for (auto& queue : workQueues) {
+        LogPrintf("HTTP: creating work queue %s of depth %d\n", queue->name, queue->maxDepth);
+        queue->queue.reset(new WorkQueue<HTTPClosure>(queue->maxDepth));
+    }
+    return true;
+}
+
+/** Work queue for a request for strURI, endpoint is the RPC method if known */
+static HTTPWorkQueue* RouteHTTPRequest(const std::string& strURI, const std::string& endpoint)
+{
+    if (!endpoint.empty()) {
+        auto it = mapMethodRoutes.find(endpoint);
+        if (it != mapMethodRoutes.end())
+            return it->second;
+    }
+    HTTPWorkQueue* queue = workQueues.front().get();
+    size_t matchLength = 0;
+    for (const auto& route : vPrefixRoutes) {
+        if (route.first.size() > matchLength && strURI.compare(0, route.first.size(), route.first) == 0) {
+            queue = route.second;
+            matchLength = route.first.size();
+        }
+    }
+    return queue;
+}
+
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
 {
@@ -278,12 +492,20 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
 
     // Dispatch to worker thread
     if (i != iend) {
-        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
-        assert(workQueue);
-        if (workQueue->Enqueue(item.get()))
+        std::string endpoint;
+        if (i->classifier)
+            endpoint = i->classifier(hreq.get());
+        HTTPWorkQueue* queue = RouteHTTPRequest(strURI, endpoint);
+        if (endpoint.empty())
+            endpoint = i->prefix;
+
+        std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler, queue, endpoint));
+        assert(queue->queue);
+        if (queue->queue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            RecordHTTPRequest(queue, endpoint, true, false, 0);
+            LogPrintf("WARNING: request rejected because http work queue %s depth exceeded, it can be increased with the -rpcworkqueue= or -rpcqueue= setting\n", queue->name);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -428,10 +650,15 @@ bool InitHTTPServer()
     }
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
-    int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
+    if (!InitHTTPWorkQueues()) {
+        workQueues.clear();
+        mapMethodRoutes.clear();
+        vPrefixRoutes.clear();
+        evhttp_free(http);
+        event_base_free(base);
+        return false;
+    }
 
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
     eventBase = base;
     eventHTTP = http;
     return true;
@@ -443,15 +670,16 @@ std::future<bool> threadResult;
 bool StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
-    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        std::thread rpc_worker(HTTPWorkQueueRun, workQueue);
-        rpc_worker.detach();
+    for (const auto& queue : workQueues) {
+        LogPrintf("HTTP: starting %d worker threads for work queue %s\n", queue->numThreads, queue->name);
+        for (int i = 0; i < queue->numThreads; i++) {
+            std::thread rpc_worker(HTTPWorkQueueRun, queue->queue.get());
+            rpc_worker.detach();
+        }
     }
     return true;
 }
@@ -467,23 +695,26 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, NULL);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (const auto& queue : workQueues)
+        queue->queue->Interrupt();
 }
 
 void StopHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Stopping HTTP server\n");
-    if (workQueue) {
+    if (!workQueues.empty()) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP worker threads to exit\n");
 #ifndef WIN32
         // ToDo: Disabling WaitExit() for Windows platforms is an ugly workaround for the wallet not
         // closing during a repair-restart. It doesn't hurt, though, because threadHTTP.timed_join
         // below takes care of this and sends a loopbreak.
-        workQueue->WaitExit();
+        for (const auto& queue : workQueues)
+            queue->queue->WaitExit();
 #endif
-        delete workQueue;
-        workQueue = nullptr;
+        std::lock_guard<std::mutex> lock(cs_httpStats);
+        mapMethodRoutes.clear();
+        vPrefixRoutes.clear();
+        workQueues.clear();
     }
     if (eventBase) {
         LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
@@ -541,13 +772,55 @@ void HTTPEvent::trigger(struct timeval* tv)
     else
         evtimer_add(ev, tv); // trigger after timeval passed
 }
+/** Flow control of a chunked reply */
+struct HTTPChunkedReplyState
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    // bytes of chunks which were queued but not handed to the connection yet
+    size_t nQueued{0};
+    // bytes in the output buffer of the connection
+    size_t nBuffered{0};
+    // the client disconnected
+    bool fClosed{false};
+
+    // only used in the main http thread
+    struct evbuffer* output{nullptr};
+    struct evbuffer_cb_entry* outputCb{nullptr};
+};
+
+/** Called when the output buffer of a connection with a chunked reply in progress changes */
+static void http_chunked_output_cb(struct evbuffer* buf, const struct evbuffer_cb_info* info, void* arg)
+{
+    HTTPChunkedReplyState* state = (HTTPChunkedReplyState*)arg;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->nBuffered = evbuffer_get_length(buf);
+    state->cond.notify_all();
+}
+
+/** Called when a connection with a chunked reply in progress is closed */
+static void http_chunked_close_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPChunkedReplyState* state = (HTTPChunkedReplyState*)arg;
+    // the output buffer is freed with the connection
+    state->output = nullptr;
+    state->outputCb = nullptr;
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->fClosed = true;
+    state->cond.notify_all();
+}
+
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyChunked(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyChunked && !replySent) {
+        LogPrintf("%s: Unfinished chunked reply\n", __func__);
+        AbortReplyChunked();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -586,6 +859,20 @@ std::string HTTPRequest::ReadBody()
     return rv;
 }
 
+std::string HTTPRequest::PeekBody(size_t nMaxSize)
+{
+    struct evbuffer* buf = evhttp_request_get_input_buffer(req);
+    if (!buf)
+        return "";
+    size_t size = evbuffer_get_length(buf);
+    if (size == 0 || size > nMaxSize)
+        return "";
+    std::string rv(size, '\0');
+    if (evbuffer_copyout(buf, &rv[0], size) != (ev_ssize_t)size)
+        return "";
+    return rv;
+}
+
 void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
 {
     struct evkeyvalq* headers = evhttp_request_get_output_headers(req);
@@ -600,7 +887,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !replyChunked && req);
     // Send event to main http thread to send reply message
     struct evbuffer* evb = evhttp_request_get_output_buffer(req);
     assert(evb);
@@ -612,6 +899,117 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+void HTTPRequest::StartReplyChunked(int nStatus)
+{
+    assert(!replySent && !replyChunked && req);
+    // Like WriteReply, everything touching the connection happens in the main http thread.
+    // Events are run in the order they were triggered, so the chunks arrive in order.
+    chunkState = std::make_shared<HTTPChunkedReplyState>();
+    struct evhttp_request* reqStart = req;
+    std::shared_ptr<HTTPChunkedReplyState> state = chunkState;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStart, nStatus, state]() {
+        evhttp_send_reply_start(reqStart, nStatus, (const char*)NULL);
+        // watch the output buffer to throttle WriteReplyChunk, and the connection to stop it
+        struct evhttp_connection* conn = evhttp_request_get_connection(reqStart);
+        struct bufferevent* bev = conn ? evhttp_connection_get_bufferevent(conn) : NULL;
+        if (!bev) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->fClosed = true;
+            state->cond.notify_all();
+            return;
+        }
+        evhttp_connection_set_closecb(conn, http_chunked_close_cb, state.get());
+        state->output = bufferevent_get_output(bev);
+        state->outputCb = evbuffer_add_cb(state->output, http_chunked_output_cb, state.get());
+    });
+    ev->trigger(0);
+    replyChunked = true;
+}
+
+void HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(replyChunked && !replySent && req);
+    if (strChunk.empty()) {
+        // an empty chunk would end the reply
+        return;
+    }
+    std::shared_ptr<HTTPChunkedReplyState> state = chunkState;
+    const size_t nSize = strChunk.size();
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cond.wait(lock, [&state]() {
+            return state->fClosed || state->nQueued + state->nBuffered < HTTP_CHUNKED_REPLY_WATERMARK;
+        });
+        if (state->fClosed) {
+            return;
+        }
+        state->nQueued += nSize;
+    }
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), nSize);
+    struct evhttp_request* reqChunk = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqChunk, evb, state, nSize]() {
+        // a request whose client disconnected has no connection anymore, sending to it is a no-op
+        bool fConnected = evhttp_request_get_connection(reqChunk) != NULL;
+        evhttp_send_reply_chunk(reqChunk, evb);
+        evbuffer_free(evb);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->nQueued -= nSize;
+        state->fClosed |= !fConnected;
+        state->cond.notify_all();
+    });
+    ev->trigger(0);
+}
+
+void HTTPRequest::EndReplyChunked()
+{
+    assert(replyChunked && !replySent && req);
+    struct evhttp_request* reqEnd = req;
+    std::shared_ptr<HTTPChunkedReplyState> state = chunkState;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqEnd, state]() {
+        // detach from the connection first, it may be reused or freed by evhttp_send_reply_end
+        if (state->outputCb) {
+            evbuffer_remove_cb_entry(state->output, state->outputCb);
+            state->outputCb = nullptr;
+        }
+        struct evhttp_connection* conn = evhttp_request_get_connection(reqEnd);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, NULL, NULL);
+        }
+        evhttp_send_reply_end(reqEnd);
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
+void HTTPRequest::AbortReplyChunked()
+{
+    assert(replyChunked && !replySent && req);
+    struct evhttp_request* reqAbort = req;
+    std::shared_ptr<HTTPChunkedReplyState> state = chunkState;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqAbort, state]() {
+        if (state->outputCb) {
+            evbuffer_remove_cb_entry(state->output, state->outputCb);
+            state->outputCb = nullptr;
+        }
+        struct evhttp_connection* conn = evhttp_request_get_connection(reqAbort);
+        if (!conn) {
+            // the client is gone already, the request was detached from the connection and
+            // evhttp_send_reply_end only frees it
+            evhttp_send_reply_end(reqAbort);
+            return;
+        }
+        evhttp_connection_set_closecb(conn, NULL, NULL);
+        // closing the connection in the middle of the body also frees the request
+        evhttp_connection_free(conn);
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -652,10 +1050,10 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier)
 {
     LogPrint(BCLog::HTTP, "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
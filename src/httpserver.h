@@ -8,15 +8,24 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+/** Default for -rpcqueuetimeout, in milliseconds */
+static const int DEFAULT_HTTP_QUEUE_TIMEOUT=30000;
+/** Worker threads of the built-in "fast" queue for cheap health check calls */
+static const int DEFAULT_HTTP_FAST_THREADS=1;
+/** Chunks of a chunked reply are only queued while less than this many bytes wait to be sent */
+static const size_t HTTP_CHUNKED_REPLY_WATERMARK=256 * 1024;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReplyState;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -34,14 +43,48 @@ void StopHTTPServer();
 
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Name of the endpoint a request is for, like the RPC method, or an empty string to use the
+ * handler's prefix. Called on the HTTP event thread to route the request to a work queue,
+ * so it must be cheap and must not consume the request body.
+ */
+typedef std::function<std::string(HTTPRequest* req)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
  * be invoked.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler, const HTTPRequestClassifier &classifier = nullptr);
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Work queue statistics, see -rpcqueue */
+struct HTTPWorkQueueStats
+{
+    std::string name;
+    int nThreads;
+    size_t nDepth;
+    size_t nMaxDepth;
+    int64_t nTimeout; // milliseconds, 0 if requests never time out
+    uint64_t nRequests;
+    uint64_t nRejected;
+    uint64_t nTimedOut;
+    int64_t nTotalWaitTime; // microseconds
+    int64_t nMaxWaitTime; // microseconds
+};
+
+/** Statistics of the requests for one endpoint (RPC method or URI prefix) */
+struct HTTPEndpointStats
+{
+    std::string endpoint;
+    std::string queue;
+    uint64_t nRequests;
+    uint64_t nRejected;
+    uint64_t nTimedOut;
+    int64_t nTotalWaitTime; // microseconds
+    int64_t nMaxWaitTime; // microseconds
+};
+
+void GetHTTPWorkQueueStats(std::vector<HTTPWorkQueueStats>& vQueueStats, std::vector<HTTPEndpointStats>& vEndpointStats);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -55,6 +98,9 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyChunked;
+    /** Flow control of a chunked reply, shared with the events sending the chunks */
+    std::shared_ptr<HTTPChunkedReplyState> chunkState;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -94,6 +140,11 @@ public:
      */
     std::string ReadBody();
 
+    /**
+     * Request body without consuming it, or an empty string if it's larger than nMaxSize.
+     */
+    std::string PeekBody(size_t nMaxSize);
+
     /**
      * Write output header.
      *
@@ -110,6 +161,36 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply with chunked transfer encoding, for bodies which are produced
+     * incrementally. The body is sent with WriteReplyChunk and finished with EndReplyChunked.
+     *
+     * @note Headers must be written before. WriteReply can't be used anymore afterwards.
+     */
+    void StartReplyChunked(int nStatus);
+    /**
+     * Queue a chunk of a chunked reply. Blocks while HTTP_CHUNKED_REPLY_WATERMARK or more bytes
+     * still wait to be sent to the client, so a slow client can't make us buffer the whole body.
+     * Chunks are dropped once the client disconnected.
+     *
+     * @note This can block for as long as the client keeps reading slowly, so it must not be
+     * called while holding locks other threads need, see CJSONStreamHold.
+     */
+    void WriteReplyChunk(const std::string& strChunk);
+    /**
+     * Finish a chunked reply. Like WriteReply, this gives the request back to the
+     * main thread.
+     */
+    void EndReplyChunked();
+    /**
+     * Give up on a chunked reply which can't be completed, e.g. because producing the body failed.
+     * The connection is closed without the terminating chunk, so the client sees an incomplete
+     * transfer instead of a well-formed but truncated body. Like EndReplyChunked, this gives the
+     * request back to the main thread.
+     */
+    void AbortReplyChunked();
+    bool IsReplyChunked() const { return replyChunked; }
 };
 
 /** Event handler closure.
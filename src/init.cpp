@@ -32,6 +32,7 @@
 #include "rpc/server.h"
 #include "rpc/register.h"
 #include "rpc/blockchain.h"
+#include "rpc/responsecache.h"
 #include "script/standard.h"
 #include "script/sigcache.h"
 #include "scheduler.h"
@@ -72,6 +73,7 @@
 #include "evo/users.h"
 
 #include "llmq/quorums_init.h"
+#include "llmq/quorums_signing.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -164,6 +166,14 @@ std::atomic<bool> fRequestShutdown(false);
 std::atomic<bool> fRequestRestart(false);
 std::atomic<bool> fDumpMempoolLater(false);
 
+static void PeriodicDumpMempool()
+{
+    // mempool.dat must not be overwritten before LoadMempool() is done with it
+    if (fDumpMempoolLater) {
+        DumpMempool(true);
+    }
+}
+
 void StartShutdown()
 {
     fRequestShutdown = true;
@@ -237,6 +247,11 @@ void PrepareShutdown()
     StopREST();
     StopRPC();
     StopHTTPServer();
+#if ENABLE_ZMQ
+    if (pzmqNotificationInterface && llmq::quorumSigningManager) {
+        llmq::quorumSigningManager->UnregisterRecoveredSigsListener(pzmqNotificationInterface);
+    }
+#endif
     llmq::StopLLMQSystem();
 
     // fRPCInWarmup should be `false` if we completed the loading sequence
@@ -266,8 +281,9 @@ void PrepareShutdown()
         // STORE DATA CACHES INTO SERIALIZED DAT FILES
         CFlatDB<CMasternodeMetaMan> flatdb1("mncache.dat", "magicMasternodeCache");
         flatdb1.Dump(mmetaman);
-        CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
-        flatdb3.Dump(governance);
+        // governance.dat is only rewritten when the journal grew too large, otherwise
+        // the changes since the last full dump are already in governance.log
+        governance.CompactJournal();
         CFlatDB<CNetFulfilledRequestManager> flatdb4("netfulfilled.dat", "magicFulfilledCache");
         flatdb4.Dump(netfulfilledman);
         if(fEnableInstantSend)
@@ -294,6 +310,9 @@ void PrepareShutdown()
         fFeeEstimatesInitialized = false;
     }
 
+    StopInputPrefetch();
+    StopHeaderHashThreads();
+
     {
         LOCK(cs_main);
         if (pcoinsTip != NULL) {
@@ -373,6 +392,7 @@ void Shutdown()
     globalVerifyHandle.reset();
     ECC_Stop();
     LogPrintf("%s: done\n", __func__);
+    StopAsyncLogging();
 }
 
 /**
@@ -458,11 +478,18 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    if (showDebug)
+        strUsage += HelpMessageOpt("-dbprofile=<db>:<key>=<value>[,...]", "Tune the LevelDB database <db> (blockindex, chainstate, evodb or llmq). Keys are cache, blockcache and writebuffer in MiB, "
+            "bloombits (0 = no bloom filter), blocksize in KiB, compression (0 or 1, needs LevelDB with Snappy) and maxopenfiles. Cache set for blockindex or chainstate is taken from -dbcache. "
+            "This option can be specified multiple times");
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file on startup"));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
+    strUsage += HelpMessageOpt("-mempooldumpinterval=<n>", strprintf(_("Dump the mempool to disk every <n> seconds if it changed, 0 to only dump at shutdown (default: %u)"), DEFAULT_MEMPOOL_DUMP_INTERVAL));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
+    if (showDebug)
+        strUsage += HelpMessageOpt("-inputprefetchthreads=<n>", strprintf("Set the number of threads loading block inputs from the coins database ahead of block connection (0 to %d, 0 = disabled, default: %d)", MAX_INPUT_PREFETCH_THREADS, DEFAULT_INPUT_PREFETCH_THREADS));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
@@ -479,6 +506,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
 
     strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
+    strUsage += HelpMessageOpt("-addresssummaryindex", strprintf(_("Maintain the balance, amount received, transaction count and first/last seen height of every address, used by getaddressbalance and getaddresssummary. Requires -addressindex and is built from it when first enabled (default: %u)"), DEFAULT_ADDRESSSUMMARYINDEX));
     strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
     strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
 
@@ -532,15 +560,22 @@ std::string HelpMessage(HelpMessageMode mode)
 #if ENABLE_ZMQ
     strUsage += HelpMessageGroup(_("ZeroMQ notification options:"));
     strUsage += HelpMessageOpt("-zmqpubhashblock=<address>", _("Enable publish hash block in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubhashchainlock=<address>", _("Enable publish hash block (locked via ChainLocks) in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashtx=<address>", _("Enable publish hash transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashtxlock=<address>", _("Enable publish hash transaction (locked via InstantSend) in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashgovernancevote=<address>", _("Enable publish hash of governance votes in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashgovernanceobject=<address>", _("Enable publish hash of governance objects (like proposals) in <address>"));
     strUsage += HelpMessageOpt("-zmqpubhashinstantsenddoublespend=<address>", _("Enable publish transaction hashes of attempted InstantSend double spend in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawblock=<address>", _("Enable publish raw block in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawchainlock=<address>", _("Enable publish raw block (locked via ChainLocks) in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawchainlocksig=<address>", _("Enable publish raw block (locked via ChainLocks) and its ChainLock signature in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtxlock=<address>", _("Enable publish raw transaction (locked via InstantSend) in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawtxlocksig=<address>", _("Enable publish raw transaction (locked via InstantSend) and its InstantSend lock in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawinstantsenddoublespend=<address>", _("Enable publish raw transactions of attempted InstantSend double spend in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawrecoveredsig=<address>", _("Enable publish raw LLMQ recovered signatures in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubrawmnlistdiff=<address>", _("Enable publish raw masternode list diffs in <address>"));
+    strUsage += HelpMessageOpt("-zmqpubqueuesize=<n>", strprintf(_("Maximum number of messages waiting to be published, further ones are dropped (default: %u)"), DEFAULT_ZMQ_PUBLISH_QUEUE_SIZE));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -576,6 +611,9 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-logtimemicros", strprintf("Add microsecond precision to debug timestamps (default: %u)", DEFAULT_LOGTIMEMICROS));
         strUsage += HelpMessageOpt("-logthreadnames", strprintf("Add thread names to debug messages (default: %u)", DEFAULT_LOGTHREADNAMES));
+        strUsage += HelpMessageOpt("-logasync", strprintf("Write debug output from a background thread (default: %u)", DEFAULT_LOGASYNC));
+        strUsage += HelpMessageOpt("-logbuffersize=<n>", strprintf("Number of debug messages buffered for the background thread (default: %u)", DEFAULT_LOGBUFFERSIZE));
+        strUsage += HelpMessageOpt("-logoverflow=<mode>", strprintf("What to do with debug messages when the buffer is full, 'block' to wait for room or 'drop' to drop and count them (default: %s)", DEFAULT_LOGOVERFLOW));
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
@@ -646,8 +684,14 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-rpcport=<port>", strprintf(_("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)"), BaseParams(CBaseChainParams::MAIN).RPCPort(), BaseParams(CBaseChainParams::TESTNET).RPCPort()));
     strUsage += HelpMessageOpt("-rpcallowip=<ip>", _("Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
     strUsage += HelpMessageOpt("-rpcthreads=<n>", strprintf(_("Set the number of threads to service RPC calls (default: %d)"), DEFAULT_HTTP_THREADS));
+    strUsage += HelpMessageOpt("-rpcbatchthreads=<n>", strprintf(_("Set the number of threads running read-only elements of JSON-RPC batches in parallel, 0 to run batches sequentially (default: %d)"), DEFAULT_RPC_BATCH_THREADS));
+    strUsage += HelpMessageOpt("-rpcbatchconcurrency=<n>", strprintf(_("Maximum number of elements of a single JSON-RPC batch running at the same time (default: %d)"), DEFAULT_RPC_BATCH_CONCURRENCY));
+    strUsage += HelpMessageOpt("-rpccachesize=<n>", strprintf(_("Maximum memory for cached RPC and REST responses about blocks in MiB, 0 to disable (default: %d)"), DEFAULT_RPC_RESPONSE_CACHE_SIZE));
     if (showDebug) {
         strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
+        strUsage += HelpMessageOpt("-rpcqueuetimeout=<n>", strprintf("Drop RPC calls which waited longer than <n> milliseconds in a work queue, 0 to wait forever (default: %d)", DEFAULT_HTTP_QUEUE_TIMEOUT));
+        strUsage += HelpMessageOpt("-rpcqueue=<name>:<threads>:<depth>[:<timeout>]", strprintf("Add a work queue with its own worker threads, or change the built-in \"default\" queue or the \"fast\" queue for health check calls (%d thread by default). This option can be specified multiple times", DEFAULT_HTTP_FAST_THREADS));
+        strUsage += HelpMessageOpt("-rpcroute=<queue>:<method|/prefix>", "Handle the given RPC method, or the requests whose URI starts with the given prefix, in the given work queue. This option can be specified multiple times");
         strUsage += HelpMessageOpt("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT));
     }
 
@@ -1104,6 +1148,9 @@ bool AppInitParameterInteraction()
             return InitError(_("Prune mode is incompatible with -txindex."));
     }
 
+    if (GetBoolArg("-addresssummaryindex", DEFAULT_ADDRESSSUMMARYINDEX) && !GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX))
+        return InitError(_("-addresssummaryindex requires -addressindex."));
+
     if (IsArgSet("-devnet")) {
         // Require setting of ports when running devnet
         if (GetArg("-listen", DEFAULT_LISTEN) && !IsArgSet("-port"))
@@ -1163,6 +1210,14 @@ bool AppInitParameterInteraction()
         }
     }
 
+    std::string strDBProfileError;
+    if (!CheckDBProfiles(strDBProfileError))
+        return InitError(strDBProfileError);
+
+    std::string strLogOverflow = GetArg("-logoverflow", DEFAULT_LOGOVERFLOW);
+    if (strLogOverflow != "block" && strLogOverflow != "drop")
+        return InitError(strprintf(_("Invalid -logoverflow mode '%s', valid are 'block' and 'drop'"), strLogOverflow));
+
     // Check for -debugnet
     if (GetBoolArg("-debugnet", false))
         InitWarning(_("Unsupported argument -debugnet ignored, use -debug=net."));
@@ -1498,6 +1553,10 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     if (fPrintToDebugLog)
         OpenDebugLog();
 
+    if (GetBoolArg("-logasync", DEFAULT_LOGASYNC) && (fPrintToConsole || fPrintToDebugLog)) {
+        StartAsyncLogging(std::max((int)GetArg("-logbuffersize", DEFAULT_LOGBUFFERSIZE), 1), GetArg("-logoverflow", DEFAULT_LOGOVERFLOW) == "drop");
+    }
+
     if (!fLogTimestamps)
         LogPrintf("Startup time: %s\n", DateTimeStrFormat("%Y-%m-%d %H:%M:%S", GetTime()));
     LogPrintf("Default data directory %s\n", GetDefaultDataDir().string());
@@ -1512,6 +1571,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         for (int i=0; i<nScriptCheckThreads-1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
     }
+    StartHeaderHashThreads(nScriptCheckThreads);
+
+    int nInputPrefetchThreads = std::max(0, std::min((int)GetArg("-inputprefetchthreads", DEFAULT_INPUT_PREFETCH_THREADS), MAX_INPUT_PREFETCH_THREADS));
+    LogPrintf("Using %u threads for block input prefetching\n", nInputPrefetchThreads);
+    StartInputPrefetch(nInputPrefetchThreads);
 
     std::vector<std::string> vSporkAddresses;
     if (mapMultiArgs.count("-sporkaddr")) {
@@ -1548,6 +1612,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
      */
     if (GetBoolArg("-server", false))
     {
+        responseCache.SetMaxMemory(std::max(GetArg("-rpccachesize", DEFAULT_RPC_RESPONSE_CACHE_SIZE), (int64_t)0) * 1024 * 1024);
         uiInterface.InitMessage.connect(SetRPCWarmupStatus);
         if (!AppInitServers(threadGroup))
             return InitError(_("Unable to start HTTP server. See debug log for details."));
@@ -1774,17 +1839,24 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
     int64_t nBlockTreeDBCache = nTotalCache / 8;
     nBlockTreeDBCache = std::min(nBlockTreeDBCache, (GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
-    nTotalCache -= nBlockTreeDBCache;
+    // -dbprofile may give the databases more or less than their share
+    int64_t nBlockTreeDBUsage = GetDBOptions("blockindex", nBlockTreeDBCache).CacheSize();
+    nTotalCache = std::max(nTotalCache - nBlockTreeDBUsage, (int64_t)0);
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
-    nTotalCache -= nCoinDBCache;
+    int64_t nCoinDBUsage = GetDBOptions("chainstate", nCoinDBCache).CacheSize();
+    if (nCoinDBUsage > nTotalCache) {
+        InitWarning(_("The database caches set with -dbprofile exceed -dbcache, the in-memory UTXO set gets no cache."));
+    }
+    nTotalCache = std::max(nTotalCache - nCoinDBUsage, (int64_t)0);
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
-    LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
-    LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBUsage * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBUsage * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for evo database\n", GetDBOptions("evodb", nEvoDbCache).CacheSize() * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     int64_t nStart = GetTimeMillis();
@@ -1856,6 +1928,12 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                     break;
                 }
 
+                // Build the address summary index from the address index when it was just enabled
+                if (!SetAddressSummaryIndex(GetBoolArg("-addresssummaryindex", DEFAULT_ADDRESSSUMMARYINDEX))) {
+                    strLoadError = _("Error building the address summary index");
+                    break;
+                }
+
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -2040,10 +2118,16 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
         strDBName = "governance.dat";
         uiInterface.InitMessage(_("Loading governance cache..."));
+        // the journal only holds changes on top of governance.dat, it's useless without it
+        bool fWipeGovernanceJournal = !fs::exists(pathDB / strDBName);
+        if (!governance.OpenJournal(pathDB / "governance.log", fWipeGovernanceJournal)) {
+            return InitError(_("Failed to open governance journal") + "\n" + (pathDB / "governance.log").string());
+        }
         CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
         if(!flatdb3.Load(governance)) {
             return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / strDBName).string());
         }
+        governance.ReplayJournal();
         governance.InitOnLoad();
 
         strDBName = "netfulfilled.dat";
@@ -2062,6 +2146,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                 return InitError(_("Failed to load InstantSend data cache from") + "\n" + (pathDB / strDBName).string());
             }
         }
+    } else if (!fLiteMode) {
+        // governance.dat is going to be rebuilt from scratch, so are its journaled changes
+        if (!governance.OpenJournal(GetDataDir() / "governance.log", true)) {
+            return InitError(_("Failed to open governance journal") + "\n" + (GetDataDir() / "governance.log").string());
+        }
     }
 
     // ********************************************************* Step 10d: schedule Dash-specific tasks
@@ -2072,6 +2161,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
         scheduler.scheduleEvery(boost::bind(&CMasternodeUtils::DoMaintenance, boost::ref(*g_connman)), 1 * 1000);
 
         scheduler.scheduleEvery(boost::bind(&CGovernanceManager::DoMaintenance, boost::ref(governance), boost::ref(*g_connman)), 60 * 5 * 1000);
+        scheduler.scheduleEvery(boost::bind(&CGovernanceManager::ProcessSyncCursors, boost::ref(governance), boost::ref(*g_connman)), 1 * 1000);
 
         scheduler.scheduleEvery(boost::bind(&CInstantSend::DoMaintenance, boost::ref(instantsend)), 60 * 1000);
 
@@ -2085,6 +2175,12 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     llmq::StartLLMQSystem();
 
+#if ENABLE_ZMQ
+    if (pzmqNotificationInterface) {
+        llmq::quorumSigningManager->RegisterRecoveredSigsListener(pzmqNotificationInterface);
+    }
+#endif
+
     // ********************************************************* Step 11: import blocks
 
     if (!CheckDiskSpace())
@@ -2110,6 +2206,11 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
+    int64_t nMempoolDumpInterval = GetArg("-mempooldumpinterval", DEFAULT_MEMPOOL_DUMP_INTERVAL);
+    if (nMempoolDumpInterval > 0) {
+        scheduler.scheduleEvery(PeriodicDumpMempool, nMempoolDumpInterval * 1000);
+    }
+
     // Wait for genesis block to be processed
     {
         boost::unique_lock<boost::mutex> lock(cs_GenesisWait);
@@ -1418,6 +1418,16 @@ bool CInstantSendManager::GetInstantSendLockByHash(const uint256& hash, llmq::CI
     return true;
 }
 
+CInstantSendLockPtr CInstantSendManager::GetInstantSendLockByTxid(const uint256& txid)
+{
+    if (!IsNewInstantSendEnabled()) {
+        return nullptr;
+    }
+
+    LOCK(cs);
+    return db.GetInstantSendLockByTxid(txid);
+}
+
 bool CInstantSendManager::IsLocked(const uint256& txHash)
 {
     if (!IsNewInstantSendEnabled()) {
@@ -162,6 +162,7 @@ public:
 
     bool AlreadyHave(const CInv& inv);
     bool GetInstantSendLockByHash(const uint256& hash, CInstantSendLock& ret);
+    CInstantSendLockPtr GetInstantSendLockByTxid(const uint256& txid);
 
     size_t GetInstantSendLockCount();
 
@@ -0,0 +1,113 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mempoolindex.h"
+
+#include "hash.h"
+#include "primitives/transaction.h"
+
+uint64_t CMempoolAddressIndex::AddressKeyHasher::Hash(const AddressKey& k)
+{
+    return CSipHasher(StaticSaltedHasher::s.k0, StaticSaltedHasher::s.k1)
+        .Write((uint64_t)k.second)
+        .Write(k.first.begin(), k.first.size())
+        .Finalize();
+}
+
+void CMempoolAddressIndex::Add(const uint256& txid, const std::vector<Entry>& entries)
+{
+    std::vector<CMempoolAddressDeltaKey> inserted;
+    inserted.reserve(entries.size());
+
+    for (const auto& e : entries) {
+        AddressKey k(e.first.addressBytes, e.first.type);
+        auto& shard = addressShards[GetShard(k)];
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+        if (shard.mapDeltas[k].emplace(e.first, e.second).second) {
+            inserted.emplace_back(e.first);
+        }
+    }
+
+    auto& txShard = txShards[GetShard(txid)];
+    boost::unique_lock<boost::shared_mutex> lock(txShard.cs);
+    txShard.mapInserted.emplace(txid, std::move(inserted));
+}
+
+void CMempoolAddressIndex::Remove(const uint256& txid)
+{
+    std::vector<CMempoolAddressDeltaKey> inserted;
+    {
+        auto& txShard = txShards[GetShard(txid)];
+        boost::unique_lock<boost::shared_mutex> lock(txShard.cs);
+        auto it = txShard.mapInserted.find(txid);
+        if (it == txShard.mapInserted.end()) {
+            return;
+        }
+        inserted = std::move(it->second);
+        txShard.mapInserted.erase(it);
+    }
+
+    for (const auto& deltaKey : inserted) {
+        AddressKey k(deltaKey.addressBytes, deltaKey.type);
+        auto& shard = addressShards[GetShard(k)];
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+        auto it = shard.mapDeltas.find(k);
+        if (it == shard.mapDeltas.end()) {
+            continue;
+        }
+        it->second.erase(deltaKey);
+        if (it->second.empty()) {
+            shard.mapDeltas.erase(it);
+        }
+    }
+}
+
+void CMempoolAddressIndex::Get(const std::vector<AddressKey>& addresses, std::vector<Entry>& results) const
+{
+    for (const auto& k : addresses) {
+        auto& shard = addressShards[GetShard(k)];
+        boost::shared_lock<boost::shared_mutex> lock(shard.cs);
+        auto it = shard.mapDeltas.find(k);
+        if (it == shard.mapDeltas.end()) {
+            continue;
+        }
+        results.insert(results.end(), it->second.begin(), it->second.end());
+    }
+}
+
+void CMempoolSpentIndex::Add(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& entries)
+{
+    for (const auto& e : entries) {
+        auto& shard = shards[GetShard(e.first)];
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+        shard.mapSpent.emplace(e.first, e.second);
+    }
+}
+
+void CMempoolSpentIndex::Remove(const CTransaction& tx)
+{
+    const uint256& txid = tx.GetHash();
+    for (const auto& in : tx.vin) {
+        CSpentIndexKey key(in.prevout.hash, in.prevout.n);
+        auto& shard = shards[GetShard(key)];
+        boost::unique_lock<boost::shared_mutex> lock(shard.cs);
+        auto it = shard.mapSpent.find(key);
+        // a conflicting tx might have replaced the entry, only remove what this tx added
+        if (it != shard.mapSpent.end() && it->second.txid == txid) {
+            shard.mapSpent.erase(it);
+        }
+    }
+}
+
+bool CMempoolSpentIndex::Get(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    auto& shard = shards[GetShard(key)];
+    boost::shared_lock<boost::shared_mutex> lock(shard.cs);
+    auto it = shard.mapSpent.find(key);
+    if (it == shard.mapSpent.end()) {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
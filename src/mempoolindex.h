@@ -0,0 +1,127 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef DASH_MEMPOOLINDEX_H
+#define DASH_MEMPOOLINDEX_H
+
+#include "addressindex.h"
+#include "saltedhasher.h"
+#include "spentindex.h"
+#include "uint256.h"
+
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/thread/shared_mutex.hpp>
+
+class CTransaction;
+
+/**
+ * Mempool part of -addressindex.
+ *
+ * Deltas are grouped per address and spread over shards by address hash, while the
+ * per-transaction bookkeeping needed for removal is spread over shards by txid. Every shard
+ * has its own reader/writer lock, so RPC readers neither block each other nor need
+ * CTxMemPool::cs, and writers only contend when they touch the same shard.
+ *
+ * Addresses and txids are attacker-chosen, so all hashes are salted. The deltas of an address
+ * are kept sorted by key, so removing a transaction costs O(log n) per delta no matter how many
+ * other transactions touch the same address.
+ */
+class CMempoolAddressIndex
+{
+public:
+    static const size_t SHARD_COUNT = 16;
+
+    typedef std::pair<uint160, int> AddressKey; // (address hash, address type)
+    typedef std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> Entry;
+
+private:
+    struct AddressKeyHasher
+    {
+        size_t operator()(const AddressKey& k) const { return Hash(k); }
+        static uint64_t Hash(const AddressKey& k);
+    };
+
+    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> DeltaMap;
+
+    struct AddressShard
+    {
+        mutable boost::shared_mutex cs;
+        std::unordered_map<AddressKey, DeltaMap, AddressKeyHasher> mapDeltas;
+    };
+
+    struct TxShard
+    {
+        boost::shared_mutex cs;
+        // txid -> keys of the deltas added for this tx
+        std::unordered_map<uint256, std::vector<CMempoolAddressDeltaKey>, StaticSaltedHasher> mapInserted;
+    };
+
+    std::array<AddressShard, SHARD_COUNT> addressShards;
+    std::array<TxShard, SHARD_COUNT> txShards;
+
+    // the low bits pick the hash table bucket, use the high ones for the shard
+    static size_t GetShard(const AddressKey& k) { return (AddressKeyHasher::Hash(k) >> 32) % SHARD_COUNT; }
+    static size_t GetShard(const uint256& txid) { return (SipHashUint256(StaticSaltedHasher::s.k0, StaticSaltedHasher::s.k1, txid) >> 32) % SHARD_COUNT; }
+
+public:
+    /** Add all deltas of a single transaction */
+    void Add(const uint256& txid, const std::vector<Entry>& entries);
+    /** Remove all deltas previously added for txid */
+    void Remove(const uint256& txid);
+    /** Append all deltas of the given addresses to results, ordered like CMempoolAddressDeltaKeyCompare per address */
+    void Get(const std::vector<AddressKey>& addresses, std::vector<Entry>& results) const;
+};
+
+/**
+ * Mempool part of -spentindex, sharded by the spent outpoint's txid.
+ *
+ * The keys of a transaction are its inputs' prevouts, so removal is driven by the transaction
+ * itself and no separate per-transaction bookkeeping is needed.
+ */
+class CMempoolSpentIndex
+{
+public:
+    static const size_t SHARD_COUNT = 16;
+
+private:
+    struct KeyHasher
+    {
+        size_t operator()(const CSpentIndexKey& k) const { return Hash(k); }
+        static uint64_t Hash(const CSpentIndexKey& k)
+        {
+            return SipHashUint256Extra(StaticSaltedHasher::s.k0, StaticSaltedHasher::s.k1, k.txid, k.outputIndex);
+        }
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const CSpentIndexKey& a, const CSpentIndexKey& b) const
+        {
+            return a.outputIndex == b.outputIndex && a.txid == b.txid;
+        }
+    };
+
+    struct Shard
+    {
+        mutable boost::shared_mutex cs;
+        std::unordered_map<CSpentIndexKey, CSpentIndexValue, KeyHasher, KeyEqual> mapSpent;
+    };
+
+    std::array<Shard, SHARD_COUNT> shards;
+
+    static size_t GetShard(const CSpentIndexKey& k) { return (KeyHasher::Hash(k) >> 32) % SHARD_COUNT; }
+
+public:
+    void Add(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& entries);
+    /** Remove all entries added for the inputs of tx */
+    void Remove(const CTransaction& tx);
+    bool Get(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+};
+
+#endif // DASH_MEMPOOLINDEX_H
@@ -0,0 +1,135 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_MPMCQUEUE_H
+#define BITCOIN_MPMCQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bounded multi-producer multi-consumer FIFO queue which doesn't use locks.
+ *
+ * This is Dmitry Vyukov's array based queue: every cell carries a sequence number which tells
+ * producers and consumers whether it's their turn to use it, so Push and Pop only need a
+ * single CAS on the shared position in the common case. Neither of them ever blocks, they
+ * fail if the queue is full or empty instead. Callers which need to wait for items have to
+ * do so on their own.
+ *
+ * The capacity is rounded up to the next power of two.
+ */
+template <typename T>
+class CMPMCQueue
+{
+private:
+    struct Cell {
+        std::atomic<size_t> nSequence;
+        T value;
+    };
+
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    std::unique_ptr<Cell[]> cells;
+    const size_t nMask;
+
+    // keep the positions written by producers and consumers on separate cache lines
+    char pad0[CACHE_LINE_SIZE];
+    std::atomic<size_t> nEnqueuePos;
+    char pad1[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> nDequeuePos;
+    char pad2[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+
+    static size_t RoundUpCapacity(size_t nCapacity)
+    {
+        size_t n = 2;
+        while (n < nCapacity) {
+            n <<= 1;
+        }
+        return n;
+    }
+
+public:
+    explicit CMPMCQueue(size_t nCapacity) :
+        cells(new Cell[RoundUpCapacity(nCapacity)]),
+        nMask(RoundUpCapacity(nCapacity) - 1),
+        nEnqueuePos(0),
+        nDequeuePos(0)
+    {
+        for (size_t i = 0; i <= nMask; i++) {
+            cells[i].nSequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    CMPMCQueue(const CMPMCQueue&) = delete;
+    CMPMCQueue& operator=(const CMPMCQueue&) = delete;
+
+    size_t Capacity() const { return nMask + 1; }
+
+    /** Append value, returns false if the queue is full. value is only moved from on success */
+    bool Push(T&& value)
+    {
+        Cell* cell;
+        size_t nPos = nEnqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[nPos & nMask];
+            size_t nSeq = cell->nSequence.load(std::memory_order_acquire);
+            intptr_t nDiff = (intptr_t)nSeq - (intptr_t)nPos;
+            if (nDiff == 0) {
+                if (nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (nDiff < 0) {
+                // the consumer of the previous round didn't get to this cell yet
+                return false;
+            } else {
+                nPos = nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->nSequence.store(nPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Push(const T& value)
+    {
+        T copy(value);
+        return Push(std::move(copy));
+    }
+
+    /** Take the oldest value, returns false if the queue is empty */
+    bool Pop(T& valueRet)
+    {
+        Cell* cell;
+        size_t nPos = nDequeuePos.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[nPos & nMask];
+            size_t nSeq = cell->nSequence.load(std::memory_order_acquire);
+            intptr_t nDiff = (intptr_t)nSeq - (intptr_t)(nPos + 1);
+            if (nDiff == 0) {
+                if (nDequeuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (nDiff < 0) {
+                return false;
+            } else {
+                nPos = nDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        valueRet = std::move(cell->value);
+        cell->nSequence.store(nPos + nMask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Number of queued values. Only a snapshot while other threads are pushing or popping */
+    size_t SizeApprox() const
+    {
+        size_t nDequeue = nDequeuePos.load(std::memory_order_relaxed);
+        size_t nEnqueue = nEnqueuePos.load(std::memory_order_relaxed);
+        return nEnqueue > nDequeue ? nEnqueue - nDequeue : 0;
+    }
+};
+
+#endif // BITCOIN_MPMCQUEUE_H
@@ -2224,42 +2224,66 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 tx.GetHash().ToString(),
                 mempool.size(), mempool.DynamicMemoryUsage() / 1000);
 
-            // Recursively process any orphan transactions that depended on this one
+            // Recursively process any orphan transactions that depended on this one. All orphans
+            // unlocked by the previous round are submitted as one batch, so their scripts are
+            // verified in parallel.
             std::set<NodeId> setMisbehaving;
+            // orphans which were accepted or rejected already. Those which still miss inputs may
+            // be resolved by a parent accepted in a later round and must be retried then
+            std::set<uint256> setDone;
             while (!vWorkQueue.empty()) {
-                auto itByPrev = mapOrphanTransactionsByPrev.find(vWorkQueue.front());
-                vWorkQueue.pop_front();
-                if (itByPrev == mapOrphanTransactionsByPrev.end())
-                    continue;
-                for (auto mi = itByPrev->second.begin();
-                     mi != itByPrev->second.end();
-                     ++mi)
-                {
-                    const CTransactionRef& porphanTx = (*mi)->second.tx;
-                    const CTransaction& orphanTx = *porphanTx;
+                std::vector<CTransactionRef> vOrphans;
+                std::vector<NodeId> vFromPeer;
+                std::set<uint256> setQueued;
+                while (!vWorkQueue.empty()) {
+                    auto itByPrev = mapOrphanTransactionsByPrev.find(vWorkQueue.front());
+                    vWorkQueue.pop_front();
+                    if (itByPrev == mapOrphanTransactionsByPrev.end())
+                        continue;
+                    for (auto mi = itByPrev->second.begin();
+                         mi != itByPrev->second.end();
+                         ++mi)
+                    {
+                        NodeId fromPeer = (*mi)->second.fromPeer;
+                        if (setMisbehaving.count(fromPeer))
+                            continue;
+                        if (setDone.count((*mi)->first) || !setQueued.emplace((*mi)->first).second)
+                            continue;
+                        vOrphans.emplace_back((*mi)->second.tx);
+                        vFromPeer.emplace_back(fromPeer);
+                    }
+                }
+
+                // Use dummy CValidationStates so someone can't setup nodes to counter-DoS based on orphan
+                // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
+                // anyone relaying LegitTxX banned)
+                std::vector<CValidationState> vStateDummy;
+                std::vector<bool> vAccepted;
+                std::vector<bool> vMissingInputs;
+                AcceptToMemoryPoolMany(mempool, vStateDummy, vOrphans, true, vAccepted, &vMissingInputs);
+
+                for (size_t i = 0; i < vOrphans.size(); i++) {
+                    const CTransaction& orphanTx = *vOrphans[i];
                     const uint256& orphanHash = orphanTx.GetHash();
-                    NodeId fromPeer = (*mi)->second.fromPeer;
-                    bool fMissingInputs2 = false;
-                    // Use a dummy CValidationState so someone can't setup nodes to counter-DoS based on orphan
-                    // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
-                    // anyone relaying LegitTxX banned)
-                    CValidationState stateDummy;
+                    NodeId fromPeer = vFromPeer[i];
+                    CValidationState& stateDummy = vStateDummy[i];
 
+                    if (vAccepted[i] || !vMissingInputs[i]) {
+                        setDone.insert(orphanHash);
+                    }
 
-                    if (setMisbehaving.count(fromPeer))
-                        continue;
-                    if (AcceptToMemoryPool(mempool, stateDummy, porphanTx, true, &fMissingInputs2)) {
+                    if (vAccepted[i]) {
                         LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
                         connman.RelayTransaction(orphanTx);
-                        for (unsigned int i = 0; i < orphanTx.vout.size(); i++) {
-                            vWorkQueue.emplace_back(orphanHash, i);
+                        for (unsigned int j = 0; j < orphanTx.vout.size(); j++) {
+                            vWorkQueue.emplace_back(orphanHash, j);
                         }
                         vEraseQueue.push_back(orphanHash);
                     }
-                    else if (!fMissingInputs2)
+                    else if (!vMissingInputs[i])
                     {
                         int nDos = 0;
-                        if (stateDummy.IsInvalid(nDos) && nDos > 0)
+                        if (stateDummy.IsInvalid(nDos) && nDos > 0 && !setMisbehaving.count(fromPeer))
                         {
                             // Punish peer that gave us an invalid orphan tx
                             Misbehaving(fromPeer, nDos);
@@ -2275,8 +2299,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                             recentRejects->insert(orphanHash);
                         }
                     }
-                    mempool.check(pcoinsTip);
                 }
+                mempool.check(pcoinsTip);
             }
 
             BOOST_FOREACH(uint256 hash, vEraseQueue)
@@ -2646,6 +2670,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
+        // Hash all headers in one batch before taking cs_main, the hashes are reused for validation
+        const std::vector<uint256> vHeaderHashes = HashBlockHeaders(headers);
+
         const CBlockIndex *pindexLast = NULL;
         {
         LOCK(cs_main);
@@ -2663,14 +2690,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             nodestate->nUnconnectingHeaders++;
             connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::GETHEADERS, chainActive.GetLocator(pindexBestHeader), uint256()));
             LogPrint(BCLog::NET, "received header %s: missing prev block %s, sending getheaders (%d) to end (peer=%d, nUnconnectingHeaders=%d)\n",
-                    headers[0].GetHash().ToString(),
+                    vHeaderHashes[0].ToString(),
                     headers[0].hashPrevBlock.ToString(),
                     pindexBestHeader->nHeight,
                     pfrom->id, nodestate->nUnconnectingHeaders);
             // Set hashLastUnknownBlock for this peer, so that if we
             // eventually get the headers - even from a different peer -
             // we can use this peer to download.
-            UpdateBlockAvailability(pfrom->GetId(), headers.back().GetHash());
+            UpdateBlockAvailability(pfrom->GetId(), vHeaderHashes.back());
 
             if (nodestate->nUnconnectingHeaders % MAX_UNCONNECTING_HEADERS == 0) {
                 Misbehaving(pfrom->GetId(), 20);
@@ -2678,18 +2705,16 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
-        uint256 hashLastBlock;
-        for (const CBlockHeader& header : headers) {
-            if (!hashLastBlock.IsNull() && header.hashPrevBlock != hashLastBlock) {
+        for (size_t i = 1; i < headers.size(); i++) {
+            if (headers[i].hashPrevBlock != vHeaderHashes[i - 1]) {
                 Misbehaving(pfrom->GetId(), 20);
                 return error("non-continuous headers sequence");
             }
-            hashLastBlock = header.GetHash();
         }
         }
 
         CValidationState state;
-        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast)) {
+        if (!ProcessNewBlockHeaders(headers, state, chainparams, &pindexLast, &vHeaderHashes)) {
             int nDoS;
             if (state.IsInvalid(nDoS)) {
                 if (nDoS > 0) {
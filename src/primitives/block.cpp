@@ -19,6 +19,23 @@ uint256 CBlockHeader::GetHash() const
     return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
 }
 
+std::vector<uint256> CBlockHeader::GetHashes(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<uint256> vHashes(headers.size());
+    GetHashes(headers.data(), headers.size(), vHashes.data());
+    return vHashes;
+}
+
+void CBlockHeader::GetHashes(const CBlockHeader* pheaders, size_t nCount, uint256* pout)
+{
+    std::vector<unsigned char> vch(80 * nCount);
+    for (size_t i = 0; i < nCount; i++) {
+        CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, i * 80);
+        ss << pheaders[i];
+    }
+    HashX11Many(vch.data(), 80, nCount, pout);
+}
+
 std::string CBlock::ToString() const
 {
     std::stringstream s;
@@ -64,6 +64,10 @@ public:
 
     uint256 GetHash() const;
 
+    /** Compute GetHash() of all headers at once, which is considerably faster than one by one */
+    static std::vector<uint256> GetHashes(const std::vector<CBlockHeader>& headers);
+    static void GetHashes(const CBlockHeader* pheaders, size_t nCount, uint256* pout);
+
     int64_t GetBlockTime() const
     {
         return (int64_t)nTime;
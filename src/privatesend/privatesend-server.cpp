@@ -284,6 +284,13 @@ void CPrivateSendServer::ProcessMessage(CNode* pfrom, const std::string& strComm
 
         LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- vecTxIn.size() %s\n", vecTxIn.size());
 
+        // verify all scriptSigs of the message at once on the script check threads
+        if (!IsInputScriptSigsValid(vecTxIn)) {
+            LogPrint(BCLog::PRIVATESEND, "DSSIGNFINALTX -- IsInputScriptSigsValid() failed, session: %d\n", nSessionID);
+            RelayStatus(STATUS_REJECTED, connman);
+            return;
+        }
+
         int nTxInIndex = 0;
         int nTxInsCount = (int)vecTxIn.size();
 
@@ -306,6 +313,8 @@ void CPrivateSendServer::SetNull()
     // MN side
     vecSessionCollaterals.clear();
     nSessionMaxParticipants = 0;
+    nSessionVerifyTime = 0;
+    nSessionVerifiedInputs = 0;
 
     CPrivateSendBaseSession::SetNull();
     CPrivateSendBaseManager::SetNull();
@@ -369,9 +378,10 @@ void CPrivateSendServer::CommitFinalTransaction(CConnman& connman)
     uint256 hashTx = finalTransaction->GetHash();
 
     LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::CommitFinalTransaction -- finalTransaction=%s", finalTransaction->ToString());
+    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::CommitFinalTransaction -- verified %d scriptSigs in %.2fms\n", nSessionVerifiedInputs, nSessionVerifyTime * 0.001);
 
     {
-        // See if the transaction is valid
+        // See if the transaction is valid, signatures were already verified and are in the signature cache
         TRY_LOCK(cs_main, lockMain);
         CValidationState validationState;
         mempool.PrioritiseTransaction(hashTx, 0.1 * COIN);
@@ -572,45 +582,71 @@ void CPrivateSendServer::CheckForCompleteQueue(CConnman& connman)
     }
 }
 
-// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-bool CPrivateSendServer::IsInputScriptSigValid(const CTxIn& txin)
+// Check to make sure the given inputs match unsigned inputs of the final transaction and their scriptSigs are valid
+bool CPrivateSendServer::IsInputScriptSigsValid(const std::vector<CTxIn>& vecTxIn)
 {
-    CMutableTransaction txNew;
-    txNew.vin.clear();
-    txNew.vout.clear();
-
-    int i = 0;
-    int nTxInIndex = -1;
-    CScript sigPubKey = CScript();
-
-    for (const auto& entry : vecEntries) {
-        for (const auto& txout : entry.vecTxOut)
-            txNew.vout.push_back(txout);
-
-        for (const auto& txdsin : entry.vecTxDSIn) {
-            txNew.vin.push_back(txdsin);
-
-            if (txdsin.prevout == txin.prevout) {
+    int64_t nTimeStart = GetTimeMicros();
+
+    // Verify against the final transaction itself, that's what clients sign and what ends up in
+    // the mempool, so the signature cache entries created here are hit again by AcceptToMemoryPool
+    CMutableTransaction txNew(finalMutableTransaction);
+    std::vector<std::pair<unsigned int, CScript> > vecInputs;
+    std::set<unsigned int> setIndexes;
+
+    for (const auto& txin : vecTxIn) {
+        int nTxInIndex = -1;
+        for (size_t i = 0; i < txNew.vin.size(); i++) {
+            if (txNew.vin[i].prevout == txin.prevout) {
                 nTxInIndex = i;
-                sigPubKey = txdsin.prevPubKey;
+                break;
             }
-            i++;
         }
-    }
 
-    if (nTxInIndex >= 0) { //might have to do this one input at a time?
-        txNew.vin[nTxInIndex].scriptSig = txin.scriptSig;
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- verifying scriptSig %s\n", ScriptToAsmStr(txin.scriptSig).substr(0, 24));
-        if (!VerifyScript(txNew.vin[nTxInIndex].scriptSig, sigPubKey, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, MutableTransactionSignatureChecker(&txNew, nTxInIndex))) {
-            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- VerifyScript() failed on input %d\n", nTxInIndex);
+        const CTxDSIn* pdsin = nullptr;
+        for (const auto& entry : vecEntries) {
+            for (const auto& txdsin : entry.vecTxDSIn) {
+                if (txdsin.prevout == txin.prevout) {
+                    pdsin = &txdsin;
+                }
+            }
+        }
+
+        if (nTxInIndex < 0 || pdsin == nullptr) {
+            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigsValid -- Failed to find matching input in pool, %s\n", txin.ToString());
             return false;
         }
-    } else {
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- Failed to find matching input in pool, %s\n", txin.ToString());
+        if (pdsin->fHasSig || !setIndexes.insert(nTxInIndex).second) {
+            LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigsValid -- input already signed, %s\n", txin.ToString());
+            return false;
+        }
+
+        txNew.vin[nTxInIndex].scriptSig = txin.scriptSig;
+        vecInputs.emplace_back(nTxInIndex, pdsin->prevPubKey);
+    }
+
+    // Only the spent scriptPubKey matters for the checks, amounts aren't part of the signature hash
+    const CTransaction tx(txNew);
+    std::vector<CScriptCheck> vChecks;
+    vChecks.reserve(vecInputs.size());
+    for (const auto& input : vecInputs) {
+        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigsValid -- verifying scriptSig %s\n", ScriptToAsmStr(tx.vin[input.first].scriptSig).substr(0, 24));
+        vChecks.emplace_back(input.second, 0, tx, input.first, SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC, true);
+    }
+
+    bool fValid = RunScriptChecks(vChecks, GetScriptCheckQueue());
+
+    int64_t nTime = GetTimeMicros() - nTimeStart;
+    nSessionVerifyTime += nTime;
+    nSessionVerifiedInputs += vecInputs.size();
+    LogPrint(BCLog::BENCHMARK, "CPrivateSendServer::IsInputScriptSigsValid -- verified %u inputs: %.2fms, session total %d inputs: %.2fms\n",
+        vecInputs.size(), nTime * 0.001, nSessionVerifiedInputs, nSessionVerifyTime * 0.001);
+
+    if (!fValid) {
+        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigsValid -- VerifyScript() failed, session: %d\n", nSessionID);
         return false;
     }
 
-    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigValid -- Successfully validated input and scriptSig\n");
+    LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::IsInputScriptSigsValid -- Successfully validated %u inputs and scriptSigs\n", vecInputs.size());
     return true;
 }
 
@@ -666,6 +702,12 @@ bool CPrivateSendServer::AddScriptSig(const CTxIn& txinNew)
 {
     LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- scriptSig=%s\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
 
+    // The signature was verified by IsInputScriptSigsValid, but never accept anything that can't be a standard scriptSig
+    if (txinNew.scriptSig.empty() || !txinNew.scriptSig.IsPushOnly()) {
+        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- scriptSig is not push only\n");
+        return false;
+    }
+
     for (const auto& entry : vecEntries) {
         for (const auto& txdsin : entry.vecTxDSIn) {
             if (txdsin.scriptSig == txinNew.scriptSig) {
@@ -675,11 +717,6 @@ bool CPrivateSendServer::AddScriptSig(const CTxIn& txinNew)
         }
     }
 
-    if (!IsInputScriptSigValid(txinNew)) {
-        LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- Invalid scriptSig\n");
-        return false;
-    }
-
     LogPrint(BCLog::PRIVATESEND, "CPrivateSendServer::AddScriptSig -- scriptSig=%s new\n", ScriptToAsmStr(txinNew.scriptSig).substr(0, 24));
 
     for (auto& txin : finalMutableTransaction.vin) {
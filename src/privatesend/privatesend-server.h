@@ -27,9 +27,18 @@ private:
 
     bool fUnitTest;
 
+    // Time spent verifying scriptSigs in the current session (in microseconds) and the number of verified inputs
+    int64_t nSessionVerifyTime;
+    int nSessionVerifiedInputs;
+
     /// Add a clients entry to the pool
     bool AddEntry(const CPrivateSendEntry& entryNew, PoolMessage& nMessageIDRet);
-    /// Add signature to a txin
+    /**
+     * Add signature to a txin.
+     * Precondition: txin was passed to IsInputScriptSigsValid() (which verified its scriptSig against the
+     * final transaction) and nothing changed the session since. Only a cheap push-only check is done here,
+     * the signature itself is NOT verified again.
+     */
     bool AddScriptSig(const CTxIn& txin);
 
     /// Charge fees to bad actors (Charge clients a fee if they're abusive)
@@ -54,8 +63,8 @@ private:
 
     /// Check that all inputs are signed. (Are all inputs signed?)
     bool IsSignaturesComplete();
-    /// Check to make sure a given input matches an input in the pool and its scriptSig is valid
-    bool IsInputScriptSigValid(const CTxIn& txin);
+    /// Check to make sure the given inputs match unsigned inputs of the final transaction and their scriptSigs are valid
+    bool IsInputScriptSigsValid(const std::vector<CTxIn>& vecTxIn);
     /// Are these outputs compatible with other client in the pool?
     bool IsOutputsCompatibleWithSessionDenom(const std::vector<CTxOut>& vecTxOut);
 
@@ -74,7 +83,9 @@ public:
     CPrivateSendServer() :
         vecSessionCollaterals(),
         nSessionMaxParticipants(0),
-        fUnitTest(false) {}
+        fUnitTest(false),
+        nSessionVerifyTime(0),
+        nSessionVerifiedInputs(0) {}
 
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
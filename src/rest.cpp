@@ -10,6 +10,8 @@
 #include "validation.h"
 #include "httpserver.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonstream.h"
+#include "rpc/responsecache.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -17,6 +19,13 @@
 #include "utilstrencodings.h"
 #include "version.h"
 
+#include "evo/deterministicmns.h"
+#include "evo/simplifiedmns.h"
+
+#include "llmq/quorums.h"
+#include "llmq/quorums_chainlocks.h"
+#include "llmq/quorums_instantsend.h"
+
 #include <boost/algorithm/string.hpp>
 
 #include <univalue.h>
@@ -62,6 +71,8 @@ struct CCoin {
 /* Defined in rawtransaction.cpp */
 void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
 void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
+/* Defined in rpcquorums.cpp */
+UniValue BuildQuorumInfo(const llmq::CQuorumCPtr& quorum, bool includeSkShare);
 
 static bool RESTERR(HTTPRequest* req, enum HTTPStatusCode status, std::string message)
 {
@@ -146,9 +157,13 @@ static bool rest_headers(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    // The serialized headers only change if one of them is disconnected, which always
+    // disconnects the last one first. Incomplete results change as the chain grows.
+    const std::string strCacheParams = strprintf("%d/%s", count, hash.ToString());
+    std::string strHeaders;
     std::vector<const CBlockIndex *> headers;
-    headers.reserve(count);
-    {
+    if (rf == RF_JSON || !responseCache.Get("rest/headers", strCacheParams, strHeaders)) {
+        headers.reserve(count);
         LOCK(cs_main);
         BlockMap::const_iterator it = mapBlockIndex.find(hash);
         const CBlockIndex *pindex = (it != mapBlockIndex.end()) ? it->second : NULL;
@@ -158,23 +173,26 @@ static bool rest_headers(HTTPRequest* req,
                 break;
             pindex = chainActive.Next(pindex);
         }
-    }
 
-    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
-    BOOST_FOREACH(const CBlockIndex *pindex, headers) {
-        ssHeader << pindex->GetBlockHeader();
+        CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+        BOOST_FOREACH(const CBlockIndex *pindex, headers) {
+            ssHeader << pindex->GetBlockHeader();
+        }
+        strHeaders = ssHeader.str();
+        if (rf != RF_JSON && headers.size() == (unsigned long)count) {
+            responseCache.Put("rest/headers", strCacheParams, headers.back()->GetBlockHash(), strHeaders);
+        }
     }
 
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryHeader = ssHeader.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryHeader);
+        req->WriteReply(HTTP_OK, strHeaders);
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssHeader.begin(), ssHeader.end()) + "\n";
+        std::string strHex = HexStr(strHeaders.begin(), strHeaders.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
@@ -211,42 +229,44 @@ static bool rest_block(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
-    CBlockIndex* pblockindex = NULL;
+    // block data comes from the response cache if possible
+    std::string strBlock;
+    std::string strJSON;
     {
         LOCK(cs_main);
         if (mapBlockIndex.count(hash) == 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
 
-        pblockindex = mapBlockIndex[hash];
+        CBlockIndex* pblockindex = mapBlockIndex[hash];
         if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        if (rf == RF_JSON) {
+            CJSONStreamWriter writer([&strJSON](const std::string& strChunk) { strJSON += strChunk; });
+            if (!blockToJSON(pblockindex, showTxDetails, writer))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            writer.Flush();
+        } else if (!ReadBlockCached(pblockindex, strBlock)) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryBlock = ssBlock.str();
         req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
+        req->WriteReply(HTTP_OK, strBlock);
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::string strHex = HexStr(strBlock.begin(), strBlock.end()) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
+        strJSON += "\n";
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strJSON);
         return true;
@@ -363,7 +383,7 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
 
     CTransactionRef tx;
     uint256 hashBlock = uint256();
-    if (!GetTransaction(hash, tx, Params().GetConsensus(), hashBlock, true))
+    if (!GetTransactionCached(hash, tx, hashBlock))
         return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
 
     CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
@@ -589,6 +609,271 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+/** Reply with serialized data in binary or hex-encoded binary format */
+static bool RESTReplySerialized(HTTPRequest* req, enum RetFormat rf, const std::string& strData)
+{
+    if (rf == RF_BINARY) {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, strData);
+    } else {
+        std::string strHex = HexStr(strData.begin(), strData.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+    }
+    return true;
+}
+
+static bool RESTReplyJSON(HTTPRequest* req, const std::string& strJSON)
+{
+    req->WriteHeader("Content-Type", "application/json");
+    req->WriteReply(HTTP_OK, strJSON + "\n");
+    return true;
+}
+
+static bool rest_mnlist(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    CDeterministicMNList mnList;
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(hash);
+        if (it == mapBlockIndex.end() || !chainActive.Contains(it->second))
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found in active chain");
+        mnList = deterministicMNManager->GetListForBlock(hash);
+    }
+
+    switch (rf) {
+    case RF_BINARY:
+    case RF_HEX: {
+        // the list's entries only, without the lookup maps kept by CDeterministicMNList
+        CDataStream ssList(SER_NETWORK, PROTOCOL_VERSION);
+        ssList << mnList.GetBlockHash() << mnList.GetHeight();
+        WriteCompactSize(ssList, mnList.GetAllMNsCount());
+        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            ssList << *dmn;
+        });
+        return RESTReplySerialized(req, rf, ssList.str());
+    }
+
+    case RF_JSON: {
+        std::string strJSON;
+        CJSONStreamWriter writer([&strJSON](const std::string& strChunk) { strJSON += strChunk; });
+        writer.BeginObject();
+        writer.Pair("blockHash", mnList.GetBlockHash().ToString());
+        writer.Pair("height", mnList.GetHeight());
+        writer.Key("mnList").BeginArray();
+        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            UniValue obj;
+            dmn->ToJson(obj);
+            writer.Value(obj);
+        });
+        writer.EndArray();
+        writer.EndObject();
+        writer.Flush();
+        return RESTReplyJSON(req, strJSON);
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_mnlistdiff(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Use /rest/mnlistdiff/<base-block-hash>/<block-hash>.<ext>.");
+
+    uint256 baseBlockHash;
+    uint256 blockHash;
+    if (!ParseHashStr(path[0], baseBlockHash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[0]);
+    if (!ParseHashStr(path[1], blockHash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[1]);
+    if (rf != RF_BINARY && rf != RF_HEX && rf != RF_JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    // Only diffs built by BuildSimplifiedMNListDiff are cached, which fails unless both blocks are on the
+    // active chain and the base block is not higher. So the base block is an ancestor of the block and the
+    // entry is invalidated as soon as either of them is disconnected. The JSON is shared with "protx diff".
+    const std::string strCacheParams = baseBlockHash.ToString() + "/" + blockHash.ToString();
+    const std::string strCacheEndpoint = rf == RF_JSON ? "protx diff" : "rest/mnlistdiff";
+    std::string strData;
+    if (!responseCache.Get(strCacheEndpoint, strCacheParams, strData)) {
+        LOCK(cs_main);
+        CSimplifiedMNListDiff mnListDiff;
+        std::string strError;
+        if (!BuildSimplifiedMNListDiff(baseBlockHash, blockHash, mnListDiff, strError))
+            return RESTERR(req, HTTP_NOT_FOUND, strError);
+
+        if (rf == RF_JSON) {
+            UniValue objDiff;
+            mnListDiff.ToJson(objDiff);
+            strData = objDiff.write();
+        } else {
+            CDataStream ssDiff(SER_NETWORK, PROTOCOL_VERSION);
+            ssDiff << mnListDiff;
+            strData = ssDiff.str();
+        }
+        responseCache.Put(strCacheEndpoint, strCacheParams, blockHash, strData);
+    }
+
+    if (rf == RF_JSON)
+        return RESTReplyJSON(req, strData);
+    return RESTReplySerialized(req, rf, strData);
+}
+
+static bool rest_quorum(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Use /rest/quorum/<llmq-type>/<quorum-hash>.<ext>.");
+
+    int32_t nType;
+    if (!ParseInt32(path[0], &nType) || !Params().GetConsensus().llmqs.count((Consensus::LLMQType)nType))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid LLMQ type: " + path[0]);
+    Consensus::LLMQType llmqType = (Consensus::LLMQType)nType;
+
+    uint256 quorumHash;
+    if (!ParseHashStr(path[1], quorumHash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + path[1]);
+
+    // the JSON is the one of "quorum info" without secret key share, which is shared with it
+    const std::string strCacheParams = strprintf("%d/%s", nType, quorumHash.ToString());
+    std::string strJSON;
+    if (rf == RF_JSON && responseCache.Get("quorum info", strCacheParams, strJSON))
+        return RESTReplyJSON(req, strJSON);
+
+    llmq::CQuorumCPtr quorum;
+    {
+        LOCK(cs_main);
+        quorum = llmq::quorumManager->GetQuorum(llmqType, quorumHash);
+    }
+    if (!quorum)
+        return RESTERR(req, HTTP_NOT_FOUND, path[1] + " not found");
+
+    switch (rf) {
+    case RF_BINARY:
+    case RF_HEX: {
+        CDataStream ssQuorum(SER_NETWORK, PROTOCOL_VERSION);
+        ssQuorum << quorum->qc << quorum->height << quorum->minedBlockHash;
+        WriteCompactSize(ssQuorum, quorum->members.size());
+        for (const auto& dmn : quorum->members) {
+            ssQuorum << dmn->proTxHash;
+        }
+        return RESTReplySerialized(req, rf, ssQuorum.str());
+    }
+
+    case RF_JSON: {
+        strJSON = BuildQuorumInfo(quorum, false).write();
+        responseCache.Put("quorum info", strCacheParams, quorum->minedBlockHash, strJSON);
+        return RESTReplyJSON(req, strJSON);
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_islock(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string hashStr;
+    const RetFormat rf = ParseDataFormat(hashStr, strURIPart);
+
+    uint256 txid;
+    if (!ParseHashStr(hashStr, txid))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    llmq::CInstantSendLockPtr islock = llmq::quorumInstantSendManager->GetInstantSendLockByTxid(txid);
+    if (!islock)
+        return RESTERR(req, HTTP_NOT_FOUND, "no InstantSend lock for " + hashStr);
+
+    switch (rf) {
+    case RF_BINARY:
+    case RF_HEX: {
+        CDataStream ssLock(SER_NETWORK, PROTOCOL_VERSION);
+        ssLock << *islock;
+        return RESTReplySerialized(req, rf, ssLock.str());
+    }
+
+    case RF_JSON: {
+        UniValue objLock(UniValue::VOBJ);
+        objLock.push_back(Pair("txid", islock->txid.ToString()));
+        UniValue inputs(UniValue::VARR);
+        for (const auto& outpoint : islock->inputs) {
+            UniValue objInput(UniValue::VOBJ);
+            objInput.push_back(Pair("txid", outpoint.hash.ToString()));
+            objInput.push_back(Pair("vout", (int64_t)outpoint.n));
+            inputs.push_back(objInput);
+        }
+        objLock.push_back(Pair("inputs", inputs));
+        objLock.push_back(Pair("sig", islock->sig.GetSig().ToString()));
+        return RESTReplyJSON(req, objLock.write());
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
+static bool rest_chainlock(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    llmq::CChainLockSig clsig = llmq::chainLocksHandler->GetBestChainLock();
+    if (clsig.nHeight == -1)
+        return RESTERR(req, HTTP_NOT_FOUND, "no ChainLock known");
+
+    switch (rf) {
+    case RF_BINARY:
+    case RF_HEX: {
+        CDataStream ssLock(SER_NETWORK, PROTOCOL_VERSION);
+        ssLock << clsig;
+        return RESTReplySerialized(req, rf, ssLock.str());
+    }
+
+    case RF_JSON: {
+        UniValue objLock(UniValue::VOBJ);
+        objLock.push_back(Pair("height", clsig.nHeight));
+        objLock.push_back(Pair("blockhash", clsig.blockHash.ToString()));
+        objLock.push_back(Pair("sig", clsig.sig.ToString()));
+        return RESTReplyJSON(req, objLock.write());
+    }
+
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -601,6 +886,11 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/mnlistdiff/", rest_mnlistdiff},
+      {"/rest/mnlist/", rest_mnlist},
+      {"/rest/quorum/", rest_quorum},
+      {"/rest/islock/", rest_islock},
+      {"/rest/chainlock", rest_chainlock},
 };
 
 bool StartREST()
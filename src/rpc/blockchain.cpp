@@ -17,6 +17,8 @@
 #include "validation.h"
 #include "policy/policy.h"
 #include "primitives/transaction.h"
+#include "rpc/jsonstream.h"
+#include "rpc/responsecache.h"
 #include "rpc/server.h"
 #include "streams.h"
 #include "sync.h"
@@ -115,33 +117,40 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+static UniValue blockTxToJSON(const CTransaction& tx, bool txDetails)
 {
-    UniValue result(UniValue::VOBJ);
+    if (!txDetails) {
+        return tx.GetHash().GetHex();
+    }
+    UniValue objTx(UniValue::VOBJ);
+    TxToJSON(tx, uint256(), objTx);
+    return objTx;
+}
+
+/** Fields of blockToJSON before the "tx" array */
+static void blockHeadToJSON(const CBlockIndex* blockindex, int nSize, UniValue& result)
+{
+    result.setObject();
     result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
     if (chainActive.Contains(blockindex))
         confirmations = chainActive.Height() - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
-    result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
+    result.push_back(Pair("size", nSize));
     result.push_back(Pair("height", blockindex->nHeight));
-    result.push_back(Pair("version", block.nVersion));
-    result.push_back(Pair("versionHex", strprintf("%08x", block.nVersion)));
-    result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
-    UniValue txs(UniValue::VARR);
+    result.push_back(Pair("version", blockindex->nVersion));
+    result.push_back(Pair("versionHex", strprintf("%08x", blockindex->nVersion)));
+    result.push_back(Pair("merkleroot", blockindex->hashMerkleRoot.GetHex()));
+}
+
+/** Special transaction payloads of blockToJSON, right after the "tx" array */
+static void blockPayloadsToJSON(const CBlock& block, bool txDetails, UniValue& result)
+{
+    result.setObject();
     UniValue transitions(UniValue::VARR);
     for(const auto& tx : block.vtx)
     {
-        if(txDetails)
-        {
-            UniValue objTx(UniValue::VOBJ);
-            TxToJSON(*tx, uint256(), objTx);
-            txs.push_back(objTx);
-        }
-        else
-            txs.push_back(tx->GetHash().GetHex());
-
         if (tx->nType == TRANSACTION_SUBTX_TRANSITION) {
             CSubTxTransition subTx;
             if (GetTxPayload(*tx, subTx)) {
@@ -154,7 +163,6 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
             }
         }
     }
-    result.push_back(Pair("tx", txs));
     result.push_back(Pair("ts", transitions));
     if (!block.vtx[0]->vExtraPayload.empty()) {
         CCbTx cbTx;
@@ -164,10 +172,16 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
             result.push_back(Pair("cbTx", cbTxObj));
         }
     }
-    result.push_back(Pair("time", block.GetBlockTime()));
+}
+
+/** Fields of blockToJSON after the special transaction payloads */
+static void blockTailToJSON(const CBlockIndex* blockindex, UniValue& result)
+{
+    result.setObject();
+    result.push_back(Pair("time", (int64_t)blockindex->nTime));
     result.push_back(Pair("mediantime", (int64_t)blockindex->GetMedianTimePast()));
-    result.push_back(Pair("nonce", (uint64_t)block.nNonce));
-    result.push_back(Pair("bits", strprintf("%08x", block.nBits)));
+    result.push_back(Pair("nonce", (uint64_t)blockindex->nNonce));
+    result.push_back(Pair("bits", strprintf("%08x", blockindex->nBits)));
     result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
     result.push_back(Pair("chainwork", blockindex->nChainWork.GetHex()));
 
@@ -178,10 +192,152 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
 
     result.push_back(Pair("chainlock", llmq::chainLocksHandler->HasChainLock(blockindex->nHeight, blockindex->GetBlockHash())));
+}
 
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    UniValue result;
+    blockHeadToJSON(blockindex, ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION), result);
+
+    UniValue txs(UniValue::VARR);
+    for (const auto& tx : block.vtx) {
+        txs.push_back(blockTxToJSON(*tx, txDetails));
+    }
+    result.push_back(Pair("tx", txs));
+
+    UniValue payloads;
+    UniValue tail;
+    blockPayloadsToJSON(block, txDetails, payloads);
+    blockTailToJSON(blockindex, tail);
+    result.pushKVs(payloads);
+    result.pushKVs(tail);
     return result;
 }
 
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, CJSONStreamWriter& writer)
+{
+    UniValue head;
+    UniValue payloads;
+    UniValue tail;
+    blockHeadToJSON(blockindex, ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION), head);
+    blockPayloadsToJSON(block, txDetails, payloads);
+    blockTailToJSON(blockindex, tail);
+
+    writer.BeginObject();
+    writer.Fields(head);
+    writer.Key("tx").BeginArray();
+    for (const auto& tx : block.vtx) {
+        writer.Value(blockTxToJSON(*tx, txDetails));
+    }
+    writer.EndArray();
+    writer.Fields(payloads);
+    writer.Fields(tail);
+    writer.EndObject();
+}
+
+/**
+ * The parts of blockToJSON which only depend on the block data, serialized for the response cache.
+ * Everything depending on the chain state (confirmations, next block, chainlock) is added per call.
+ * Transaction details are not cached if -spentindex is on, they include the spending of the outputs.
+ */
+struct CBlockJSONBody
+{
+    int nSize;
+    // the "tx" array
+    std::string strTx;
+    // object with the special transaction payloads
+    std::string strPayloads;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nSize);
+        READWRITE(strTx);
+        READWRITE(strPayloads);
+    }
+};
+
+static bool GetBlockJSONBody(const CBlockIndex* blockindex, bool txDetails, CBlockJSONBody& body)
+{
+    const uint256 hashBlock = blockindex->GetBlockHash();
+    const std::string strParams = strprintf("%d/%s", txDetails, hashBlock.ToString());
+    // With the spent index the transaction details carry spentTxId/spentIndex/spentHeight of the
+    // outputs, which change whenever later blocks spend them, so they can't be cached by block hash.
+    const bool fCache = !(txDetails && fSpentIndex);
+    std::string strData;
+    if (fCache && responseCache.Get("blockjson", strParams, strData)) {
+        CDataStream ssBody(strData.data(), strData.data() + strData.size(), SER_NETWORK, PROTOCOL_VERSION);
+        ssBody >> body;
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, blockindex, Params().GetConsensus()))
+        return false;
+
+    body.nSize = ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION);
+    UniValue txs(UniValue::VARR);
+    for (const auto& tx : block.vtx) {
+        txs.push_back(blockTxToJSON(*tx, txDetails));
+    }
+    body.strTx = txs.write();
+    UniValue payloads;
+    blockPayloadsToJSON(block, txDetails, payloads);
+    body.strPayloads = payloads.write();
+
+    if (fCache) {
+        CDataStream ssBody(SER_NETWORK, PROTOCOL_VERSION);
+        ssBody << body;
+        responseCache.Put("blockjson", strParams, hashBlock, ssBody.str());
+    }
+    return true;
+}
+
+static UniValue ParseCachedJSON(const std::string& strJson)
+{
+    UniValue value;
+    if (!value.read(strJson))
+        throw std::runtime_error("Invalid cached block data");
+    return value;
+}
+
+bool blockToJSON(const CBlockIndex* blockindex, bool txDetails, UniValue& result)
+{
+    CBlockJSONBody body;
+    if (!GetBlockJSONBody(blockindex, txDetails, body))
+        return false;
+
+    UniValue tail;
+    blockHeadToJSON(blockindex, body.nSize, result);
+    blockTailToJSON(blockindex, tail);
+    result.push_back(Pair("tx", ParseCachedJSON(body.strTx)));
+    result.pushKVs(ParseCachedJSON(body.strPayloads));
+    result.pushKVs(tail);
+    return true;
+}
+
+bool blockToJSON(const CBlockIndex* blockindex, bool txDetails, CJSONStreamWriter& writer)
+{
+    CBlockJSONBody body;
+    if (!GetBlockJSONBody(blockindex, txDetails, body))
+        return false;
+
+    UniValue head;
+    UniValue tail;
+    blockHeadToJSON(blockindex, body.nSize, head);
+    blockTailToJSON(blockindex, tail);
+
+    writer.BeginObject();
+    writer.Fields(head);
+    writer.Key("tx").Raw(body.strTx);
+    writer.Fields(ParseCachedJSON(body.strPayloads));
+    writer.Fields(tail);
+    writer.EndObject();
+    return true;
+}
+
 UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -419,6 +575,48 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e)
     info.push_back(Pair("instantlock", instantsend.IsLockedInstantSendTransaction(tx.GetHash()) || llmq::quorumInstantSendManager->IsLocked(tx.GetHash())));
 }
 
+/** Number of mempool entries written per lock of mempool.cs when streaming */
+static const size_t MEMPOOL_JSON_BATCH_SIZE = 1000;
+
+void mempoolToJSON(bool fVerbose, CJSONStreamWriter& writer)
+{
+    if (fVerbose)
+    {
+        // Writing may block until the client reads, so mempool.cs is only held for one batch of
+        // entries at a time. Transactions which leave the mempool in between are skipped.
+        std::vector<uint256> vtxid;
+        mempool.queryHashes(vtxid);
+
+        writer.BeginObject();
+        for (size_t nBatchStart = 0; nBatchStart < vtxid.size(); nBatchStart += MEMPOOL_JSON_BATCH_SIZE)
+        {
+            CJSONStreamHold hold(&writer);
+            LOCK(mempool.cs);
+            size_t nBatchEnd = std::min(nBatchStart + MEMPOOL_JSON_BATCH_SIZE, vtxid.size());
+            for (size_t i = nBatchStart; i < nBatchEnd; i++)
+            {
+                CTxMemPool::txiter it = mempool.mapTx.find(vtxid[i]);
+                if (it == mempool.mapTx.end())
+                    continue;
+                UniValue info(UniValue::VOBJ);
+                entryToJSON(info, *it);
+                writer.Key(vtxid[i].ToString()).Value(info);
+            }
+        }
+        writer.EndObject();
+    }
+    else
+    {
+        std::vector<uint256> vtxid;
+        mempool.queryHashes(vtxid);
+
+        writer.BeginArray();
+        for (const uint256& hash : vtxid)
+            writer.Value(hash.ToString());
+        writer.EndArray();
+    }
+}
+
 UniValue mempoolToJSON(bool fVerbose)
 {
     if (fVerbose)
@@ -476,6 +674,10 @@ UniValue getrawmempool(const JSONRPCRequest& request)
     if (request.params.size() > 0)
         fVerbose = request.params[0].get_bool();
 
+    if (request.streamWriter) {
+        mempoolToJSON(fVerbose, *request.streamWriter);
+        return NullUniValue;
+    }
     return mempoolToJSON(fVerbose);
 }
 
@@ -980,6 +1182,8 @@ UniValue getblock(const JSONRPCRequest& request)
             + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
+    // the result is only streamed once cs_main is released, a slow client mustn't hold up validation
+    CJSONStreamHold hold(request.streamWriter);
     LOCK(cs_main);
 
     std::string strHash = request.params[0].get_str();
@@ -996,29 +1200,32 @@ UniValue getblock(const JSONRPCRequest& request)
     if (mapBlockIndex.count(hash) == 0)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
 
     if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
 
-    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-        // Block not found on disk. This could be because we have the block
-        // header in our index but don't have the block (for example if a
-        // non-whitelisted node sends us an unrequested long chain of valid
-        // blocks, we add the headers to our index, but don't accept the
-        // block).
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
-
+    // Block data comes from the response cache if possible. Failing to read it from disk
+    // could be because we have the block header in our index but don't have the block (for
+    // example if a non-whitelisted node sends us an unrequested long chain of valid blocks,
+    // we add the headers to our index, but don't accept the block).
     if (verbosity <= 0)
     {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        std::string strBlock;
+        if (!ReadBlockCached(pblockindex, strBlock))
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+        return HexStr(strBlock.begin(), strBlock.end());
     }
 
-    return blockToJSON(block, pblockindex, verbosity >= 2);
+    if (request.streamWriter) {
+        if (!blockToJSON(pblockindex, verbosity >= 2, *request.streamWriter))
+            throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+        return NullUniValue;
+    }
+    UniValue result;
+    if (!blockToJSON(pblockindex, verbosity >= 2, result))
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    return result;
 }
 
 struct CCoinsStats
@@ -1845,11 +2052,11 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      true,  {} },
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       true,  {} },
     { "blockchain",         "getblockcount",          &getblockcount,          true,  {} },
-    { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbosity|verbose"} },
-    { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"} },
-    { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
-    { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
-    { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"} },
+    { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbosity|verbose"}, true },
+    { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"}, true },
+    { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"}, true },
+    { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"}, true },
+    { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"}, true },
     { "blockchain",         "getmerkleblocks",        &getmerkleblocks,        true,  {"filter","blockhash","count"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
@@ -1859,7 +2066,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true,  {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         true,  {"blockhash", "type", "count", "skip", "verbosity"} },
-    { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
+    { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"}, true },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
@@ -7,6 +7,7 @@
 
 class CBlock;
 class CBlockIndex;
+class CJSONStreamWriter;
 class CScript;
 class CTransaction;
 class uint256;
@@ -26,12 +27,21 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+/** Same as above, but written to a stream transaction by transaction */
+void blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, CJSONStreamWriter& writer);
+/**
+ * Same as above, but with the block data from the response cache or disk, see CResponseCache.
+ * Returns false if the block can't be read.
+ */
+bool blockToJSON(const CBlockIndex* blockindex, bool txDetails, UniValue& result);
+bool blockToJSON(const CBlockIndex* blockindex, bool txDetails, CJSONStreamWriter& writer);
 
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
+void mempoolToJSON(bool fVerbose, CJSONStreamWriter& writer);
 
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
@@ -151,6 +151,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getspentinfo", 0, "json" },
     { "getaddresstxids", 0, "addresses" },
     { "getaddressbalance", 0, "addresses" },
+    { "getaddresssummary", 0, "addresses" },
     { "getaddressdeltas", 0, "addresses" },
     { "getaddressutxos", 0, "addresses" },
     { "getaddressmempool", 0, "addresses" },
@@ -12,6 +12,7 @@
 #include "validation.h"
 #include "masternode/masternode-sync.h"
 #include "messagesigner.h"
+#include "rpc/jsonstream.h"
 #include "rpc/server.h"
 #include "util.h"
 #include "utilmoneystr.h"
@@ -617,12 +618,14 @@ UniValue gobject_vote_alias(const JSONRPCRequest& request)
 }
 #endif
 
-UniValue ListObjects(const std::string& strCachedSignal, const std::string& strType, int nStartTime)
+UniValue ListObjects(const std::string& strCachedSignal, const std::string& strType, int nStartTime, CJSONStreamWriter* writer)
 {
     UniValue objResult(UniValue::VOBJ);
 
     // GET MATCHING GOVERNANCE OBJECTS
 
+    // the result is only streamed once the locks are released, a slow client mustn't hold them up
+    CJSONStreamHold hold(writer);
     LOCK2(cs_main, governance.cs);
 
     std::vector<const CGovernanceObject*> objs = governance.GetAllNewerThan(nStartTime);
@@ -630,6 +633,10 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
 
     // CREATE RESULTS FOR USER
 
+    if (writer) {
+        writer->BeginObject();
+    }
+
     for (const auto& pGovObj : objs) {
         if (strCachedSignal == "valid" && !pGovObj->IsSetCachedValid()) continue;
         if (strCachedSignal == "funding" && !pGovObj->IsSetCachedFunding()) continue;
@@ -666,9 +673,17 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
         bObj.push_back(Pair("fCachedDelete",  pGovObj->IsSetCachedDelete()));
         bObj.push_back(Pair("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed()));
 
-        objResult.push_back(Pair(pGovObj->GetHash().ToString(), bObj));
+        if (writer) {
+            writer->Key(pGovObj->GetHash().ToString()).Value(bObj);
+        } else {
+            objResult.push_back(Pair(pGovObj->GetHash().ToString(), bObj));
+        }
     }
 
+    if (writer) {
+        writer->EndObject();
+        return NullUniValue;
+    }
     return objResult;
 }
 
@@ -698,7 +713,7 @@ UniValue gobject_list(const JSONRPCRequest& request)
     if (strType != "proposals" && strType != "triggers" && strType != "all")
         return "Invalid type, should be 'proposals', 'triggers' or 'all'";
 
-    return ListObjects(strCachedSignal, strType, 0);
+    return ListObjects(strCachedSignal, strType, 0, request.streamWriter);
 }
 
 void gobject_diff_help()
@@ -727,7 +742,7 @@ UniValue gobject_diff(const JSONRPCRequest& request)
     if (strType != "proposals" && strType != "triggers" && strType != "all")
         return "Invalid type, should be 'proposals', 'triggers' or 'all'";
 
-    return ListObjects(strCachedSignal, strType, governance.GetLastDiffTime());
+    return ListObjects(strCachedSignal, strType, governance.GetLastDiffTime(), request.streamWriter);
 }
 
 void gobject_get_help()
@@ -0,0 +1,160 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <assert.h>
+
+CJSONStreamWriter::CJSONStreamWriter(const sink_t& sinkIn, size_t nChunkSizeIn) :
+    sink(sinkIn),
+    nChunkSize(nChunkSizeIn),
+    nBytesWritten(0),
+    fAfterKey(false),
+    nHolds(0)
+{
+    strBuffer.reserve(nChunkSize + nChunkSize / 4);
+}
+
+void CJSONStreamWriter::Append(const std::string& str)
+{
+    strBuffer += str;
+    nBytesWritten += str.size();
+    if (nHolds == 0 && strBuffer.size() >= nChunkSize) {
+        Flush();
+    }
+}
+
+void CJSONStreamWriter::BeginValue()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!vNeedComma.empty()) {
+        if (vNeedComma.back()) {
+            strBuffer += ',';
+            nBytesWritten++;
+        }
+        vNeedComma.back() = true;
+    }
+}
+
+CJSONStreamWriter& CJSONStreamWriter::BeginObject()
+{
+    BeginValue();
+    vNeedComma.push_back(false);
+    Append("{");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::EndObject()
+{
+    assert(!vNeedComma.empty() && !fAfterKey);
+    vNeedComma.pop_back();
+    Append("}");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::BeginArray()
+{
+    BeginValue();
+    vNeedComma.push_back(false);
+    Append("[");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::EndArray()
+{
+    assert(!vNeedComma.empty() && !fAfterKey);
+    vNeedComma.pop_back();
+    Append("]");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Key(const std::string& strKey)
+{
+    assert(!vNeedComma.empty() && !fAfterKey);
+    BeginValue();
+    // UniValue takes care of escaping
+    Append(UniValue(strKey).write() + ":");
+    fAfterKey = true;
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Value(const UniValue& value)
+{
+    BeginValue();
+    Append(value.write());
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Value(const std::string& str)
+{
+    BeginValue();
+    Append(UniValue(str).write());
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Value(int64_t n)
+{
+    BeginValue();
+    Append(std::to_string(n));
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Value(uint64_t n)
+{
+    BeginValue();
+    Append(std::to_string(n));
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Value(bool f)
+{
+    BeginValue();
+    Append(f ? "true" : "false");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Null()
+{
+    BeginValue();
+    Append("null");
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Raw(const std::string& strJson)
+{
+    BeginValue();
+    Append(strJson);
+    return *this;
+}
+
+CJSONStreamWriter& CJSONStreamWriter::Fields(const UniValue& obj)
+{
+    assert(obj.isObject());
+    const std::vector<std::string>& vKeys = obj.getKeys();
+    const std::vector<UniValue>& vValues = obj.getValues();
+    for (size_t i = 0; i < vKeys.size(); i++) {
+        Key(vKeys[i]).Value(vValues[i]);
+    }
+    return *this;
+}
+
+void CJSONStreamWriter::Flush()
+{
+    if (strBuffer.empty()) {
+        return;
+    }
+    sink(strBuffer);
+    strBuffer.clear();
+}
+
+std::string CJSONStreamWriter::TakeBuffer()
+{
+    std::string strRet;
+    strRet.swap(strBuffer);
+    strBuffer.reserve(nChunkSize + nChunkSize / 4);
+    return strRet;
+}
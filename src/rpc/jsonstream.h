@@ -0,0 +1,126 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <univalue.h>
+
+/** Size at which the buffered output is handed to the sink */
+static const size_t DEFAULT_JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Incremental JSON emitter for large RPC results.
+ *
+ * Instead of building the whole result as a UniValue tree and serializing it at once, callers
+ * write it element by element. The output is buffered and passed to the sink in chunks of about
+ * nChunkSize bytes, e.g. straight into a chunked HTTP reply. Small parts of the result can still
+ * be built as UniValue and written with Value() or Fields().
+ *
+ * The output is byte for byte what UniValue::write() would produce for the same document.
+ */
+class CJSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string&)> sink_t;
+
+private:
+    sink_t sink;
+    size_t nChunkSize;
+    std::string strBuffer;
+    uint64_t nBytesWritten;
+
+    // one entry per open object/array: whether the next element needs a separating comma
+    std::vector<bool> vNeedComma;
+    bool fAfterKey;
+    // nesting depth of Hold() calls, nothing is passed to the sink while it's not zero
+    int nHolds;
+
+    void BeginValue();
+    void Append(const std::string& str);
+
+public:
+    explicit CJSONStreamWriter(const sink_t& sinkIn, size_t nChunkSizeIn = DEFAULT_JSON_STREAM_CHUNK_SIZE);
+
+    CJSONStreamWriter& BeginObject();
+    CJSONStreamWriter& EndObject();
+    CJSONStreamWriter& BeginArray();
+    CJSONStreamWriter& EndArray();
+    /** Write the key of the next object member */
+    CJSONStreamWriter& Key(const std::string& strKey);
+
+    CJSONStreamWriter& Value(const UniValue& value);
+    CJSONStreamWriter& Value(const std::string& str);
+    CJSONStreamWriter& Value(const char* psz) { return Value(std::string(psz)); }
+    CJSONStreamWriter& Value(int64_t n);
+    CJSONStreamWriter& Value(int n) { return Value((int64_t)n); }
+    CJSONStreamWriter& Value(uint64_t n);
+    CJSONStreamWriter& Value(bool f);
+    CJSONStreamWriter& Null();
+    /** Write a value which is already serialized JSON, e.g. from the response cache */
+    CJSONStreamWriter& Raw(const std::string& strJson);
+
+    template<typename T>
+    CJSONStreamWriter& Pair(const std::string& strKey, const T& value)
+    {
+        return Key(strKey).Value(value);
+    }
+
+    /** Write all members of obj into the currently open object */
+    CJSONStreamWriter& Fields(const UniValue& obj);
+
+    /** Hand everything buffered to the sink */
+    void Flush();
+
+    /**
+     * Keep output in the buffer instead of passing full chunks to the sink, until the matching
+     * Release(). The sink may block until the client reads, so it must not be called while
+     * holding a lock other threads need. Use CJSONStreamHold instead of calling these directly.
+     */
+    void Hold() { nHolds++; }
+    void Release() { nHolds--; }
+
+    /** Take the buffered output without passing it to the sink */
+    std::string TakeBuffer();
+
+    /** Number of bytes written so far, including those not flushed yet */
+    uint64_t GetBytesWritten() const { return nBytesWritten; }
+    /** True once a complete top level value was written */
+    bool IsComplete() const { return nBytesWritten > 0 && vNeedComma.empty(); }
+};
+
+/**
+ * Holds the writer, if any, while in scope. Create it before taking the locks a handler needs for
+ * building (part of) its result, so it's released after them: everything written while the locks
+ * are held is buffered and passed on later, once the lock is gone.
+ */
+class CJSONStreamHold
+{
+private:
+    CJSONStreamWriter* writer;
+
+public:
+    explicit CJSONStreamHold(CJSONStreamWriter* writerIn) : writer(writerIn)
+    {
+        if (writer) {
+            writer->Hold();
+        }
+    }
+    ~CJSONStreamHold()
+    {
+        if (writer) {
+            writer->Release();
+        }
+    }
+
+    CJSONStreamHold(const CJSONStreamHold&) = delete;
+    CJSONStreamHold& operator=(const CJSONStreamHold&) = delete;
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
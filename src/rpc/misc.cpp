@@ -6,10 +6,14 @@
 
 #include "base58.h"
 #include "clientversion.h"
+#include "dbwrapper.h"
+#include "httpserver.h"
 #include "init.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/blockchain.h"
+#include "rpc/jsonstream.h"
+#include "rpc/responsecache.h"
 #include "rpc/server.h"
 #include "timedata.h"
 #include "txmempool.h"
@@ -698,6 +702,229 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+typedef std::map<std::pair<uint160, int>, std::string> AddressStringMap;
+
+/**
+ * Encode the requested addresses before the first result row is written, a streamed result
+ * can't fail on an unknown address type anymore once part of it was sent
+ */
+static AddressStringMap getAddressStrings(const std::vector<std::pair<uint160, int> >& addresses)
+{
+    AddressStringMap mapAddresses;
+    for (const auto& address : addresses) {
+        if (!getAddressFromIndex(address.second, address.first, mapAddresses[address])) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+        }
+    }
+    return mapAddresses;
+}
+
+static UniValue addressUnspentToJSON(const AddressStringMap& mapAddresses, const CAddressUnspentKey& key, const CAddressUnspentValue& value)
+{
+    const std::string& address = mapAddresses.at(std::make_pair(key.hashBytes, (int)key.type));
+
+    UniValue output(UniValue::VOBJ);
+    output.push_back(Pair("address", address));
+    output.push_back(Pair("txid", key.txhash.GetHex()));
+    output.push_back(Pair("outputIndex", (int)key.index));
+    output.push_back(Pair("script", HexStr(value.script.begin(), value.script.end())));
+    output.push_back(Pair("satoshis", value.satoshis));
+    output.push_back(Pair("height", value.blockHeight));
+    return output;
+}
+
+static UniValue addressDeltaToJSON(const AddressStringMap& mapAddresses, const CAddressIndexKey& key, CAmount nValue)
+{
+    const std::string& address = mapAddresses.at(std::make_pair(key.hashBytes, (int)key.type));
+
+    UniValue delta(UniValue::VOBJ);
+    delta.push_back(Pair("satoshis", nValue));
+    delta.push_back(Pair("txid", key.txhash.GetHex()));
+    delta.push_back(Pair("index", (int)key.index));
+    delta.push_back(Pair("blockindex", (int)key.txindex));
+    delta.push_back(Pair("height", key.blockHeight));
+    delta.push_back(Pair("address", address));
+    return delta;
+}
+
+/** Default and maximum number of addresses returned per getaddresssummary call */
+static const int64_t DEFAULT_ADDRESS_SUMMARY_LIMIT = 1000;
+static const int64_t MAX_ADDRESS_SUMMARY_LIMIT = 10000;
+/** Default and maximum number of rows per page of getaddresstxids, getaddressdeltas and getaddressutxos */
+static const int64_t DEFAULT_ADDRESS_PAGE_LIMIT = 1000;
+static const int64_t MAX_ADDRESS_PAGE_LIMIT = 100000;
+
+static const std::string strAddressPageHelp =
+    "  \"limit\" (number, optional) Return at most this many results and a cursor for the rest (default: " + std::to_string(DEFAULT_ADDRESS_PAGE_LIMIT) + ", max: " + std::to_string(MAX_ADDRESS_PAGE_LIMIT) + ")\n"
+    "  \"cursor\" (string, optional) Continue after the last result of a previous call with the same arguments\n";
+
+/**
+ * Read "limit" and "cursor" of the paged address RPCs. Returns false if neither is given, these
+ * calls then return everything at once like they always did.
+ */
+static bool getAddressPageFromParams(const UniValue& params, int64_t& nLimit, std::string& strCursor)
+{
+    nLimit = DEFAULT_ADDRESS_PAGE_LIMIT;
+    strCursor.clear();
+    if (!params[0].isObject()) {
+        return false;
+    }
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (limitValue.isNull() && cursorValue.isNull()) {
+        return false;
+    }
+    if (!limitValue.isNull()) {
+        nLimit = limitValue.get_int64();
+        if (nLimit <= 0 || nLimit > MAX_ADDRESS_PAGE_LIMIT) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid limit, must be between 1 and %d", MAX_ADDRESS_PAGE_LIMIT));
+        }
+    }
+    if (!cursorValue.isNull()) {
+        strCursor = cursorValue.get_str();
+    }
+    return true;
+}
+
+/**
+ * Walk the index entries of the addresses in the order given and pass every entry which starts a new
+ * result row to addRow, until nLimit rows were returned. Entries are read straight from the database
+ * and only the current page is kept in memory.
+ *
+ * The returned cursor is the position in the address list plus the last key that was visited, hex
+ * encoded, or empty once all entries were returned.
+ */
+template<typename Key, typename Value>
+static std::string readAddressPage(const std::vector<std::pair<uint160, int> >& addresses, int64_t nLimit, const std::string& strCursor,
+                                   const std::function<bool(size_t, const Key*, const std::function<bool(const Key&, const Value&)>&)>& forEachEntry,
+                                   const std::function<bool(const Key* pPrev, const Key&)>& isNewRow,
+                                   const std::function<void(const Key&, const Value&)>& addRow)
+{
+    uint32_t nAddress = 0;
+    Key lastKey;
+    uint32_t nLastKeyAddress = 0;
+    bool fHaveLastKey = false;
+
+    if (!strCursor.empty()) {
+        if (!IsHex(strCursor)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        std::vector<unsigned char> vchCursor = ParseHex(strCursor);
+        CDataStream ssCursor(vchCursor, SER_DISK, CLIENT_VERSION);
+        try {
+            ssCursor >> nAddress >> lastKey;
+        } catch (const std::exception&) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+        if (!ssCursor.empty() || nAddress >= addresses.size() ||
+            lastKey.hashBytes != addresses[nAddress].first || (int)lastKey.type != addresses[nAddress].second) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Cursor does not belong to these addresses");
+        }
+        nLastKeyAddress = nAddress;
+        fHaveLastKey = true;
+    }
+
+    int64_t nRows = 0;
+    bool fMore = false;
+    for (; nAddress < addresses.size(); nAddress++) {
+        const Key* pStartAfter = fHaveLastKey && nLastKeyAddress == nAddress ? &lastKey : nullptr;
+        // lastKey is updated during the walk, so resume from a copy
+        Key startAfter = pStartAfter ? *pStartAfter : Key();
+        bool fOk = forEachEntry(nAddress, pStartAfter ? &startAfter : nullptr, [&](const Key& key, const Value& value) {
+            if (isNewRow(fHaveLastKey ? &lastKey : nullptr, key)) {
+                if (nRows == nLimit) {
+                    fMore = true;
+                    return false;
+                }
+                nRows++;
+                addRow(key, value);
+            }
+            lastKey = key;
+            nLastKeyAddress = nAddress;
+            fHaveLastKey = true;
+            return true;
+        });
+        if (!fOk) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        if (fMore) {
+            break;
+        }
+    }
+
+    if (!fMore) {
+        return std::string();
+    }
+    CDataStream ssCursor(SER_DISK, CLIENT_VERSION);
+    ssCursor << nLastKeyAddress << lastKey;
+    return HexStr(ssCursor.begin(), ssCursor.end());
+}
+
+/**
+ * Result rows of getaddresstxids, getaddressdeltas and getaddressutxos. If the request can be
+ * streamed, rows go straight to its stream writer instead of being collected as UniValue first.
+ * With a page key, the rows are wrapped in an object together with the cursor of the next page.
+ *
+ * Nothing may fail once the first row was passed on, the client would only see a broken transfer.
+ * Unpaged results are read completely before the first row is written. Pages are read while they
+ * are written, so they are held in the buffer until they are complete, they are bounded by their limit.
+ */
+class CAddressResultRows
+{
+private:
+    CJSONStreamWriter* writer;
+    CJSONStreamHold hold;
+    std::string strPageKey;
+    UniValue rows;
+
+public:
+    CAddressResultRows(CJSONStreamWriter* writerIn, const std::string& strPageKeyIn = "") :
+        writer(writerIn), hold(strPageKeyIn.empty() ? nullptr : writerIn), strPageKey(strPageKeyIn), rows(UniValue::VARR)
+    {
+        if (writer) {
+            if (!strPageKey.empty()) {
+                writer->BeginObject().Key(strPageKey);
+            }
+            writer->BeginArray();
+        }
+    }
+
+    template<typename T>
+    void push_back(const T& row)
+    {
+        if (writer) {
+            writer->Value(row);
+        } else {
+            rows.push_back(row);
+        }
+    }
+
+    /** Close the result. Returns NullUniValue if it was streamed. */
+    UniValue Finish(const std::string& strNextCursor = "")
+    {
+        if (writer) {
+            writer->EndArray();
+            if (!strPageKey.empty()) {
+                if (!strNextCursor.empty()) {
+                    writer->Pair("cursor", strNextCursor);
+                }
+                writer->EndObject();
+            }
+            return NullUniValue;
+        }
+        if (strPageKey.empty()) {
+            return rows;
+        }
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair(strPageKey, rows));
+        if (!strNextCursor.empty()) {
+            result.push_back(Pair("cursor", strNextCursor));
+        }
+        return result;
+    }
+};
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -782,6 +1009,7 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            + strAddressPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -794,8 +1022,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit or cursor, outputs are ordered by address and txid instead of height):\n"
+            "{\n"
+            "  \"utxos\": [ ... ]  (array) The outputs as above\n"
+            "  \"cursor\": \"...\"  (string, optional) Pass this to get the next page, only present if there are more outputs\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 100}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -805,6 +1039,26 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    AddressStringMap mapAddresses = getAddressStrings(addresses);
+
+    int64_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        CAddressResultRows utxos(request.streamWriter, "utxos");
+        std::string strNextCursor = readAddressPage<CAddressUnspentKey, CAddressUnspentValue>(addresses, nLimit, strCursor,
+            [&addresses](size_t i, const CAddressUnspentKey* pStartAfter, const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& func) {
+                return ForEachAddressUnspent(addresses[i].first, addresses[i].second, pStartAfter, func);
+            },
+            [](const CAddressUnspentKey* pPrev, const CAddressUnspentKey& key) {
+                return true;
+            },
+            [&utxos, &mapAddresses](const CAddressUnspentKey& key, const CAddressUnspentValue& value) {
+                utxos.push_back(addressUnspentToJSON(mapAddresses, key, value));
+            });
+
+        return utxos.Finish(strNextCursor);
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -815,25 +1069,13 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
 
     std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
 
-    UniValue result(UniValue::VARR);
+    CAddressResultRows result(request.streamWriter);
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
-        UniValue output(UniValue::VOBJ);
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        output.push_back(Pair("address", address));
-        output.push_back(Pair("txid", it->first.txhash.GetHex()));
-        output.push_back(Pair("outputIndex", (int)it->first.index));
-        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
-        output.push_back(Pair("satoshis", it->second.satoshis));
-        output.push_back(Pair("height", it->second.blockHeight));
-        result.push_back(output);
+        result.push_back(addressUnspentToJSON(mapAddresses, it->first, it->second));
     }
 
-    return result;
+    return result.Finish();
 }
 
 UniValue getaddressdeltas(const JSONRPCRequest& request)
@@ -851,6 +1093,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            + strAddressPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -863,6 +1106,11 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit or cursor):\n"
+            "{\n"
+            "  \"deltas\": [ ... ]  (array) The deltas as above, ordered by address and height\n"
+            "  \"cursor\": \"...\"  (string, optional) Pass this to get the next page, only present if there are more deltas\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -889,6 +1137,26 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    AddressStringMap mapAddresses = getAddressStrings(addresses);
+
+    int64_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        CAddressResultRows deltas(request.streamWriter, "deltas");
+        std::string strNextCursor = readAddressPage<CAddressIndexKey, CAmount>(addresses, nLimit, strCursor,
+            [&addresses, start, end](size_t i, const CAddressIndexKey* pStartAfter, const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func) {
+                return ForEachAddressIndex(addresses[i].first, addresses[i].second, start, end, pStartAfter, func);
+            },
+            [](const CAddressIndexKey* pPrev, const CAddressIndexKey& key) {
+                return true;
+            },
+            [&deltas, &mapAddresses](const CAddressIndexKey& key, const CAmount& nValue) {
+                deltas.push_back(addressDeltaToJSON(mapAddresses, key, nValue));
+            });
+
+        return deltas.Finish(strNextCursor);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -903,25 +1171,13 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         }
     }
 
-    UniValue result(UniValue::VARR);
+    CAddressResultRows result(request.streamWriter);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        result.push_back(delta);
+        result.push_back(addressDeltaToJSON(mapAddresses, it->first, it->second));
     }
 
-    return result;
+    return result.Finish();
 }
 
 UniValue getaddressbalance(const JSONRPCRequest& request)
@@ -930,6 +1186,7 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw std::runtime_error(
             "getaddressbalance\n"
             "\nReturns the balance for an address(es) (requires addressindex to be enabled).\n"
+            "With addresssummaryindex enabled this is answered from the address summaries.\n"
             "\nArguments:\n"
             "{\n"
             "  \"addresses\"\n"
@@ -954,6 +1211,25 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    CAmount balance = 0;
+    CAmount received = 0;
+
+    if (fAddressSummaryIndex) {
+        for (const auto& address : addresses) {
+            CAddressSummary summary;
+            if (!GetAddressSummary(address.first, address.second, summary)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            balance += summary.balance;
+            received += summary.received;
+        }
+
+        UniValue result(UniValue::VOBJ);
+        result.push_back(Pair("balance", balance));
+        result.push_back(Pair("received", received));
+        return result;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -962,9 +1238,6 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         }
     }
 
-    CAmount balance = 0;
-    CAmount received = 0;
-
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
         if (it->second > 0) {
             received += it->second;
@@ -980,6 +1253,97 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
 
 }
 
+UniValue getaddresssummary(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddresssummary\n"
+            "\nReturns the balance, total received, transaction count and first/last seen height for\n"
+            "each of the given addresses (requires addresssummaryindex to be enabled).\n"
+            "\nArguments:\n"
+            "{\n"
+            "  \"addresses\"\n"
+            "    [\n"
+            "      \"address\"  (string) The base58check encoded address\n"
+            "      ,...\n"
+            "    ]\n"
+            "  \"start\" (number, optional) The position in the address list to start at (default: 0)\n"
+            "  \"limit\" (number, optional) The maximum number of addresses to return (default: " + std::to_string(DEFAULT_ADDRESS_SUMMARY_LIMIT) + ")\n"
+            "}\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"summaries\": [\n"
+            "    {\n"
+            "      \"address\"  (string) The base58check encoded address\n"
+            "      \"balance\"  (number) The current balance in duffs\n"
+            "      \"received\"  (number) The total number of duffs received (including change)\n"
+            "      \"txcount\"  (number) The number of transactions involving the address\n"
+            "      \"firstheight\"  (number) The height of the first block involving the address, -1 if never used\n"
+            "      \"lastheight\"  (number) The height of the last block involving the address, -1 if never used\n"
+            "    }\n"
+            "    ,...\n"
+            "  ],\n"
+            "  \"next\"  (number, optional) The start position of the next page, only present if there are more addresses\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresssummary", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleRpc("getaddresssummary", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
+        );
+
+    std::vector<std::pair<uint160, int> > addresses;
+
+    if (!getAddressesFromParams(request.params, addresses)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+    }
+
+    int64_t nStart = 0;
+    int64_t nLimit = DEFAULT_ADDRESS_SUMMARY_LIMIT;
+    if (request.params[0].isObject()) {
+        UniValue startValue = find_value(request.params[0].get_obj(), "start");
+        UniValue limitValue = find_value(request.params[0].get_obj(), "limit");
+        if (!startValue.isNull()) {
+            nStart = startValue.get_int64();
+        }
+        if (!limitValue.isNull()) {
+            nLimit = limitValue.get_int64();
+        }
+    }
+    if (nStart < 0 || nLimit <= 0 || nLimit > MAX_ADDRESS_SUMMARY_LIMIT) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid start or limit, limit must be between 1 and %d", MAX_ADDRESS_SUMMARY_LIMIT));
+    }
+
+    UniValue summaries(UniValue::VARR);
+    int64_t nEnd = std::min<int64_t>(addresses.size(), nStart + nLimit);
+    for (int64_t i = nStart; i < nEnd; i++) {
+        CAddressSummary summary;
+        if (!GetAddressSummary(addresses[i].first, addresses[i].second, summary)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+
+        std::string address;
+        if (!getAddressFromIndex(addresses[i].second, addresses[i].first, address)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("address", address));
+        obj.push_back(Pair("balance", summary.balance));
+        obj.push_back(Pair("received", summary.received));
+        obj.push_back(Pair("txcount", summary.txCount));
+        obj.push_back(Pair("firstheight", summary.firstHeight));
+        obj.push_back(Pair("lastheight", summary.lastHeight));
+        summaries.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("summaries", summaries));
+    if (nEnd < (int64_t)addresses.size()) {
+        result.push_back(Pair("next", nEnd));
+    }
+
+    return result;
+}
+
 UniValue getaddresstxids(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -995,12 +1359,18 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            + strAddressPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (with limit or cursor, txids are ordered by address and height and may repeat across addresses):\n"
+            "{\n"
+            "  \"txids\": [ ... ]  (array) The transaction ids\n"
+            "  \"cursor\": \"...\"  (string, optional) Pass this to get the next page, only present if there are more txids\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -1023,6 +1393,26 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    int64_t nLimit;
+    std::string strCursor;
+    if (getAddressPageFromParams(request.params, nLimit, strCursor)) {
+        CAddressResultRows txids(request.streamWriter, "txids");
+        std::string strNextCursor = readAddressPage<CAddressIndexKey, CAmount>(addresses, nLimit, strCursor,
+            [&addresses, start, end](size_t i, const CAddressIndexKey* pStartAfter, const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func) {
+                return ForEachAddressIndex(addresses[i].first, addresses[i].second, start, end, pStartAfter, func);
+            },
+            [](const CAddressIndexKey* pPrev, const CAddressIndexKey& key) {
+                // the entries of a transaction are adjacent in the index
+                return !pPrev || pPrev->txhash != key.txhash || pPrev->blockHeight != key.blockHeight ||
+                       pPrev->hashBytes != key.hashBytes || pPrev->type != key.type;
+            },
+            [&txids](const CAddressIndexKey& key, const CAmount& nValue) {
+                txids.push_back(key.txhash.GetHex());
+            });
+
+        return txids.Finish(strNextCursor);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -1038,7 +1428,7 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
     }
 
     std::set<std::pair<int, std::string> > txids;
-    UniValue result(UniValue::VARR);
+    CAddressResultRows result(request.streamWriter);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
         int height = it->first.blockHeight;
@@ -1059,7 +1449,7 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
-    return result;
+    return result.Finish();
 
 }
 
@@ -1189,6 +1579,200 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+UniValue getresponsecacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getresponsecacheinfo\n"
+            "Returns statistics of the cache for RPC and REST responses about blocks, see -rpccachesize.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"entries\": xxxxx,          (numeric) Number of cached responses\n"
+            "  \"usage\": xxxxx,            (numeric) Memory used by the cache in bytes\n"
+            "  \"maxusage\": xxxxx,         (numeric) Memory limit of the cache in bytes, 0 if disabled\n"
+            "  \"hits\": xxxxx,             (numeric) Number of lookups answered from the cache\n"
+            "  \"misses\": xxxxx,           (numeric) Number of lookups not found in the cache\n"
+            "  \"evictions\": xxxxx,        (numeric) Number of responses dropped to stay within the memory limit\n"
+            "  \"invalidations\": xxxxx,    (numeric) Number of responses dropped because their block was disconnected\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getresponsecacheinfo", "")
+            + HelpExampleRpc("getresponsecacheinfo", "")
+        );
+
+    CResponseCache::Stats stats = responseCache.GetStats();
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("entries", (uint64_t)stats.nEntries));
+    obj.push_back(Pair("usage", (uint64_t)stats.nMemoryUsage));
+    obj.push_back(Pair("maxusage", (uint64_t)stats.nMaxMemory));
+    obj.push_back(Pair("hits", stats.nHits));
+    obj.push_back(Pair("misses", stats.nMisses));
+    obj.push_back(Pair("evictions", stats.nEvictions));
+    obj.push_back(Pair("invalidations", stats.nInvalidations));
+    return obj;
+}
+
+UniValue getdbstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getdbstats\n"
+            "Returns the settings and statistics of the LevelDB databases, see -dbcache and -dbprofile.\n"
+            "Blocks of memory mapped table files are read in place and don't show up in the block cache.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {                  (object) Database, one of blockindex, chainstate, evodb and llmq\n"
+            "    \"path\": \"...\",            (string) Location on disk, empty if kept in memory\n"
+            "    \"profile\": {               (object) Options the database was opened with\n"
+            "      \"blockcache\": n,           (numeric) Block cache size in bytes\n"
+            "      \"writebuffer\": n,          (numeric) Write buffer size in bytes, up to two are held in memory\n"
+            "      \"bloombits\": n,            (numeric) Bits per key of the bloom filter, 0 if none\n"
+            "      \"blocksize\": n,            (numeric) Uncompressed size of table blocks in bytes\n"
+            "      \"compression\": true|false, (boolean) Whether blocks are compressed\n"
+            "      \"maxopenfiles\": n          (numeric) Number of table files kept open\n"
+            "    },\n"
+            "    \"memoryusage\": n,          (numeric) Approximate memory used by the caches and memtables in bytes\n"
+            "    \"blockcache\": {\n"
+            "      \"usage\": n,                (numeric) Bytes held by the block cache\n"
+            "      \"hits\": n,                 (numeric) Number of lookups answered from the block cache\n"
+            "      \"misses\": n,               (numeric) Number of lookups which had to read from disk\n"
+            "      \"hitrate\": x.xxx           (numeric) Hits per lookup\n"
+            "    },\n"
+            "    \"levels\": [                (array) Levels which have files or were compacted into\n"
+            "      {\n"
+            "        \"level\": n,              (numeric) Level number\n"
+            "        \"files\": n,              (numeric) Number of table files\n"
+            "        \"bytes\": n,              (numeric) Total size of the table files\n"
+            "        \"compactiontime\": n,     (numeric) Seconds spent compacting into this level\n"
+            "        \"compactionread\": n,     (numeric) MiB read by these compactions\n"
+            "        \"compactionwrite\": n     (numeric) MiB written by these compactions\n"
+            "      }, ...\n"
+            "    ]\n"
+            "  }, ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbstats", "")
+            + HelpExampleRpc("getdbstats", "")
+        );
+
+    UniValue result(UniValue::VOBJ);
+    for (const CDBStats& stats : GetDBStats()) {
+        UniValue profile(UniValue::VOBJ);
+        profile.push_back(Pair("blockcache", (uint64_t)stats.options.nBlockCacheSize));
+        profile.push_back(Pair("writebuffer", (uint64_t)stats.options.nWriteBufferSize));
+        profile.push_back(Pair("bloombits", stats.options.nBloomBits));
+        profile.push_back(Pair("blocksize", (uint64_t)stats.options.nBlockSize));
+        profile.push_back(Pair("compression", stats.options.fCompression));
+        profile.push_back(Pair("maxopenfiles", stats.options.nMaxOpenFiles));
+
+        UniValue blockCache(UniValue::VOBJ);
+        uint64_t nLookups = stats.nBlockCacheHits + stats.nBlockCacheMisses;
+        blockCache.push_back(Pair("usage", (uint64_t)stats.nBlockCacheUsage));
+        blockCache.push_back(Pair("hits", stats.nBlockCacheHits));
+        blockCache.push_back(Pair("misses", stats.nBlockCacheMisses));
+        blockCache.push_back(Pair("hitrate", nLookups ? (double)stats.nBlockCacheHits / nLookups : 0.0));
+
+        UniValue levels(UniValue::VARR);
+        for (const CDBLevelStats& level : stats.vLevels) {
+            if (level.nFiles == 0 && level.dCompactionTime == 0) {
+                continue;
+            }
+            UniValue obj(UniValue::VOBJ);
+            obj.push_back(Pair("level", level.nLevel));
+            obj.push_back(Pair("files", level.nFiles));
+            obj.push_back(Pair("bytes", level.nBytes));
+            obj.push_back(Pair("compactiontime", level.dCompactionTime));
+            obj.push_back(Pair("compactionread", level.dCompactionReadMB));
+            obj.push_back(Pair("compactionwrite", level.dCompactionWriteMB));
+            levels.push_back(obj);
+        }
+
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("path", stats.strPath));
+        obj.push_back(Pair("profile", profile));
+        obj.push_back(Pair("memoryusage", stats.nMemoryUsage));
+        obj.push_back(Pair("blockcache", blockCache));
+        obj.push_back(Pair("levels", levels));
+        result.push_back(Pair(stats.strName, obj));
+    }
+    return result;
+}
+
+UniValue gethttpqueueinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "gethttpqueueinfo\n"
+            "Returns statistics of the work queues of the HTTP server, see -rpcqueue and -rpcroute.\n"
+            "Wait times are the time requests spent in the queue before a worker picked them up.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queues\": {\n"
+            "    \"name\": {                (object) Work queue\n"
+            "      \"threads\": n,            (numeric) Number of worker threads\n"
+            "      \"depth\": n,              (numeric) Number of requests waiting right now\n"
+            "      \"maxdepth\": n,           (numeric) Requests are rejected when this many are waiting\n"
+            "      \"timeout\": n,            (numeric) Requests waiting longer than this are dropped, in milliseconds, 0 if never\n"
+            "      \"requests\": n,           (numeric) Number of requests taken from the queue\n"
+            "      \"rejected\": n,           (numeric) Number of requests rejected because the queue was full\n"
+            "      \"timedout\": n,           (numeric) Number of requests dropped because they waited too long\n"
+            "      \"avgwait\": n,            (numeric) Average wait time in milliseconds\n"
+            "      \"maxwait\": n,            (numeric) Maximum wait time in milliseconds\n"
+            "    }, ...\n"
+            "  },\n"
+            "  \"endpoints\": {\n"
+            "    \"endpoint\": {            (object) RPC method, or URI prefix of other requests\n"
+            "      \"queue\": \"name\",        (string) Work queue of the last request\n"
+            "      \"requests\": n,           (numeric) Same as above, for this endpoint\n"
+            "      \"rejected\": n,\n"
+            "      \"timedout\": n,\n"
+            "      \"avgwait\": n,\n"
+            "      \"maxwait\": n\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("gethttpqueueinfo", "")
+            + HelpExampleRpc("gethttpqueueinfo", "")
+        );
+
+    std::vector<HTTPWorkQueueStats> vQueueStats;
+    std::vector<HTTPEndpointStats> vEndpointStats;
+    GetHTTPWorkQueueStats(vQueueStats, vEndpointStats);
+
+    UniValue queues(UniValue::VOBJ);
+    for (const auto& stats : vQueueStats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("threads", stats.nThreads));
+        obj.push_back(Pair("depth", (uint64_t)stats.nDepth));
+        obj.push_back(Pair("maxdepth", (uint64_t)stats.nMaxDepth));
+        obj.push_back(Pair("timeout", stats.nTimeout));
+        obj.push_back(Pair("requests", stats.nRequests));
+        obj.push_back(Pair("rejected", stats.nRejected));
+        obj.push_back(Pair("timedout", stats.nTimedOut));
+        obj.push_back(Pair("avgwait", stats.nRequests ? (double)stats.nTotalWaitTime / stats.nRequests / 1000 : 0.0));
+        obj.push_back(Pair("maxwait", (double)stats.nMaxWaitTime / 1000));
+        queues.push_back(Pair(stats.name, obj));
+    }
+
+    UniValue endpoints(UniValue::VOBJ);
+    for (const auto& stats : vEndpointStats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("queue", stats.queue));
+        obj.push_back(Pair("requests", stats.nRequests));
+        obj.push_back(Pair("rejected", stats.nRejected));
+        obj.push_back(Pair("timedout", stats.nTimedOut));
+        obj.push_back(Pair("avgwait", stats.nRequests ? (double)stats.nTotalWaitTime / stats.nRequests / 1000 : 0.0));
+        obj.push_back(Pair("maxwait", (double)stats.nMaxWaitTime / 1000));
+        endpoints.push_back(Pair(stats.endpoint, obj));
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("queues", queues));
+    result.push_back(Pair("endpoints", endpoints));
+    return result;
+}
+
 UniValue echo(const JSONRPCRequest& request)
 {
     if (request.fHelp)
@@ -1208,18 +1792,22 @@ static const CRPCCommand commands[] =
     { "control",            "debug",                  &debug,                  true,  {} },
     { "control",            "getinfo",                &getinfo,                true,  {} }, /* uses wallet if enabled */
     { "control",            "getmemoryinfo",          &getmemoryinfo,          true,  {"mode"} },
+    { "control",            "getresponsecacheinfo",   &getresponsecacheinfo,   true,  {} },
+    { "control",            "gethttpqueueinfo",       &gethttpqueueinfo,       true,  {} },
+    { "control",            "getdbstats",             &getdbstats,             true,  {} },
     { "util",               "validateaddress",        &validateaddress,        true,  {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         true,  {"nrequired","keys"} },
     { "util",               "verifymessage",          &verifymessage,          true,  {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, true,  {"privkey","message"} },
-    { "blockchain",         "getspentinfo",           &getspentinfo,           false, {"json"} },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           false, {"json"}, true },
 
     /* Address index */
-    { "addressindex",       "getaddressmempool",      &getaddressmempool,      true,  {"addresses"}  },
-    { "addressindex",       "getaddressutxos",        &getaddressutxos,        false, {"addresses"} },
-    { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       false, {"addresses"} },
-    { "addressindex",       "getaddresstxids",        &getaddresstxids,        false, {"addresses"} },
-    { "addressindex",       "getaddressbalance",      &getaddressbalance,      false, {"addresses"} },
+    { "addressindex",       "getaddressmempool",      &getaddressmempool,      true,  {"addresses"}, true },
+    { "addressindex",       "getaddressutxos",        &getaddressutxos,        false, {"addresses"}, true },
+    { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       false, {"addresses"}, true },
+    { "addressindex",       "getaddresstxids",        &getaddresstxids,        false, {"addresses"}, true },
+    { "addressindex",       "getaddressbalance",      &getaddressbalance,      false, {"addresses"}, true },
+    { "addressindex",       "getaddresssummary",      &getaddresssummary,      false, {"addresses"}, true },
 
     /* Dash features */
     { "dash",               "mnsync",                 &mnsync,                 true,  {} },
@@ -0,0 +1,210 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/responsecache.h"
+
+#include "chainparams.h"
+#include "memusage.h"
+#include "rpc/jsonstream.h"
+#include "rpc/server.h"
+#include "streams.h"
+#include "validation.h"
+#include "version.h"
+
+#include <univalue.h>
+
+CResponseCache responseCache(DEFAULT_RPC_RESPONSE_CACHE_SIZE * 1024 * 1024);
+
+CResponseCache::CResponseCache(size_t nMaxMemoryIn) :
+    nMaxMemory(nMaxMemoryIn),
+    nMemoryUsage(0),
+    nHits(0),
+    nMisses(0),
+    nEvictions(0),
+    nInvalidations(0)
+{
+}
+
+std::string CResponseCache::MakeKey(const std::string& strEndpoint, const std::string& strParams)
+{
+    return strEndpoint + '\0' + strParams;
+}
+
+size_t CResponseCache::EntryUsage(const Entry& entry)
+{
+    // list node, hash map node and bucket, block multimap node, plus the two strings
+    return memusage::MallocUsage(sizeof(Entry) + 2 * sizeof(void*)) +
+           memusage::MallocUsage(sizeof(std::pair<const std::string, list_t::iterator>) + sizeof(void*)) + sizeof(void*) +
+           memusage::MallocUsage(sizeof(std::pair<const uint256, list_t::iterator>) + 4 * sizeof(void*)) +
+           memusage::MallocUsage(entry.strKey.capacity()) * 2 +
+           memusage::MallocUsage(entry.strData.capacity());
+}
+
+void CResponseCache::EraseEntry(list_t::iterator it)
+{
+    AssertLockHeld(cs);
+
+    auto range = mapEntriesByBlock.equal_range(it->hashBlock);
+    for (auto itBlock = range.first; itBlock != range.second; ++itBlock) {
+        if (itBlock->second == it) {
+            mapEntriesByBlock.erase(itBlock);
+            break;
+        }
+    }
+    mapEntries.erase(it->strKey);
+    nMemoryUsage -= EntryUsage(*it);
+    listEntries.erase(it);
+}
+
+void CResponseCache::EvictToSize(size_t nSize)
+{
+    AssertLockHeld(cs);
+
+    while (nMemoryUsage > nSize && !listEntries.empty()) {
+        EraseEntry(std::prev(listEntries.end()));
+        nEvictions++;
+    }
+}
+
+void CResponseCache::SetMaxMemory(size_t nMaxMemoryIn)
+{
+    LOCK(cs);
+    nMaxMemory = nMaxMemoryIn;
+    EvictToSize(nMaxMemory);
+}
+
+bool CResponseCache::IsEnabled() const
+{
+    LOCK(cs);
+    return nMaxMemory != 0;
+}
+
+bool CResponseCache::Get(const std::string& strEndpoint, const std::string& strParams, std::string& strDataRet)
+{
+    LOCK(cs);
+    if (nMaxMemory == 0) {
+        return false;
+    }
+
+    auto it = mapEntries.find(MakeKey(strEndpoint, strParams));
+    if (it == mapEntries.end()) {
+        nMisses++;
+        return false;
+    }
+    listEntries.splice(listEntries.begin(), listEntries, it->second);
+    strDataRet = it->second->strData;
+    nHits++;
+    return true;
+}
+
+void CResponseCache::Put(const std::string& strEndpoint, const std::string& strParams, const uint256& hashBlock, const std::string& strData)
+{
+    Entry entry{MakeKey(strEndpoint, strParams), hashBlock, strData};
+    size_t nUsage = EntryUsage(entry);
+
+    LOCK(cs);
+    if (nUsage > nMaxMemory / 2) {
+        // a single response must not push everything else out
+        return;
+    }
+
+    auto itExisting = mapEntries.find(entry.strKey);
+    if (itExisting != mapEntries.end()) {
+        EraseEntry(itExisting->second);
+    }
+    EvictToSize(nMaxMemory - nUsage);
+
+    listEntries.push_front(std::move(entry));
+    auto it = listEntries.begin();
+    mapEntries.emplace(it->strKey, it);
+    mapEntriesByBlock.emplace(it->hashBlock, it);
+    nMemoryUsage += nUsage;
+}
+
+void CResponseCache::EraseBlock(const uint256& hashBlock)
+{
+    LOCK(cs);
+    auto range = mapEntriesByBlock.equal_range(hashBlock);
+    std::vector<list_t::iterator> vErase;
+    for (auto it = range.first; it != range.second; ++it) {
+        vErase.push_back(it->second);
+    }
+    for (const auto& it : vErase) {
+        EraseEntry(it);
+        nInvalidations++;
+    }
+}
+
+void CResponseCache::Clear()
+{
+    LOCK(cs);
+    listEntries.clear();
+    mapEntries.clear();
+    mapEntriesByBlock.clear();
+    nMemoryUsage = 0;
+}
+
+CResponseCache::Stats CResponseCache::GetStats() const
+{
+    LOCK(cs);
+    return Stats{listEntries.size(), nMemoryUsage, nMaxMemory, nHits, nMisses, nEvictions, nInvalidations};
+}
+
+bool ReadBlockCached(const CBlockIndex* pblockindex, std::string& strBlockRet)
+{
+    const uint256 hashBlock = pblockindex->GetBlockHash();
+    if (responseCache.Get("block", hashBlock.ToString(), strBlockRet)) {
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
+        return false;
+    }
+    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+    ssBlock << block;
+    strBlockRet = ssBlock.str();
+    // the block itself never changes, no matter whether it's on the active chain
+    responseCache.Put("block", hashBlock.ToString(), hashBlock, strBlockRet);
+    return true;
+}
+
+bool GetTransactionCached(const uint256& hash, CTransactionRef& txOut, uint256& hashBlock)
+{
+    std::string strData;
+    if (responseCache.Get("tx", hash.ToString(), strData)) {
+        CDataStream ssTx(strData.data(), strData.data() + strData.size(), SER_NETWORK, PROTOCOL_VERSION);
+        ssTx >> txOut >> hashBlock;
+        return true;
+    }
+
+    if (!GetTransaction(hash, txOut, Params().GetConsensus(), hashBlock, true)) {
+        return false;
+    }
+
+    // mempool transactions and those in blocks off the active chain can still change their block
+    if (!hashBlock.IsNull()) {
+        LOCK(cs_main);
+        BlockMap::const_iterator mi = mapBlockIndex.find(hashBlock);
+        if (mi != mapBlockIndex.end() && chainActive.Contains(mi->second)) {
+            CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
+            ssTx << txOut << hashBlock;
+            responseCache.Put("tx", hash.ToString(), hashBlock, ssTx.str());
+        }
+    }
+    return true;
+}
+
+UniValue JSONResultFromCache(const JSONRPCRequest& request, const std::string& strJson)
+{
+    if (request.streamWriter) {
+        request.streamWriter->Raw(strJson);
+        return NullUniValue;
+    }
+    UniValue result;
+    if (!result.read(strJson)) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Invalid cached response");
+    }
+    return result;
+}
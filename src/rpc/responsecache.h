@@ -0,0 +1,102 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_RESPONSECACHE_H
+#define BITCOIN_RPC_RESPONSECACHE_H
+
+#include "primitives/transaction.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+class CBlockIndex;
+class JSONRPCRequest;
+class UniValue;
+
+/** Default for -rpccachesize, in MiB */
+static const int64_t DEFAULT_RPC_RESPONSE_CACHE_SIZE = 32;
+
+/**
+ * Bounded LRU cache of serialized RPC and REST responses which never change for a given block,
+ * e.g. the serialized block behind getblock and /rest/block/.
+ *
+ * Entries are keyed by endpoint and parameters and tied to the block they were derived from.
+ * They are dropped when that block is disconnected from the active chain, anything else only
+ * leaves the cache when it runs out of memory.
+ */
+class CResponseCache
+{
+public:
+    struct Stats {
+        size_t nEntries;
+        size_t nMemoryUsage;
+        size_t nMaxMemory;
+        uint64_t nHits;
+        uint64_t nMisses;
+        uint64_t nEvictions;
+        uint64_t nInvalidations;
+    };
+
+private:
+    struct Entry {
+        std::string strKey;
+        uint256 hashBlock;
+        std::string strData;
+    };
+    typedef std::list<Entry> list_t;
+
+    mutable CCriticalSection cs;
+    size_t nMaxMemory;
+    size_t nMemoryUsage;
+    // most recently used first
+    list_t listEntries;
+    std::unordered_map<std::string, list_t::iterator> mapEntries;
+    std::multimap<uint256, list_t::iterator> mapEntriesByBlock;
+
+    uint64_t nHits;
+    uint64_t nMisses;
+    uint64_t nEvictions;
+    uint64_t nInvalidations;
+
+    static std::string MakeKey(const std::string& strEndpoint, const std::string& strParams);
+    static size_t EntryUsage(const Entry& entry);
+    void EraseEntry(list_t::iterator it);
+    void EvictToSize(size_t nSize);
+
+public:
+    explicit CResponseCache(size_t nMaxMemoryIn);
+
+    /** Set the memory limit, 0 disables the cache */
+    void SetMaxMemory(size_t nMaxMemoryIn);
+    bool IsEnabled() const;
+
+    bool Get(const std::string& strEndpoint, const std::string& strParams, std::string& strDataRet);
+    /** Store a response derived from hashBlock, which must be on the active chain or not change with it */
+    void Put(const std::string& strEndpoint, const std::string& strParams, const uint256& hashBlock, const std::string& strData);
+    /** Drop everything derived from hashBlock */
+    void EraseBlock(const uint256& hashBlock);
+    void Clear();
+
+    Stats GetStats() const;
+};
+
+extern CResponseCache responseCache;
+
+/** Serialized block, from the response cache if possible. Returns false if it can't be read from disk */
+bool ReadBlockCached(const CBlockIndex* pblockindex, std::string& strBlockRet);
+
+/**
+ * GetTransaction for RPC and REST. Transactions confirmed on the active chain are kept in the
+ * response cache, so repeated lookups don't go to disk.
+ */
+bool GetTransactionCached(const uint256& hash, CTransactionRef& txOut, uint256& hashBlock);
+
+/** Result of an RPC call from a cached JSON document, written as is if the result is streamed */
+UniValue JSONResultFromCache(const JSONRPCRequest& request, const std::string& strJson);
+
+#endif // BITCOIN_RPC_RESPONSECACHE_H
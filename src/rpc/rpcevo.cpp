@@ -7,6 +7,8 @@
 #include "core_io.h"
 #include "init.h"
 #include "messagesigner.h"
+#include "rpc/jsonstream.h"
+#include "rpc/responsecache.h"
 #include "rpc/server.h"
 #include "utilmoneystr.h"
 #include "validation.h"
@@ -944,6 +946,22 @@ UniValue protx_list(const JSONRPCRequest& request)
     }
 
     UniValue ret(UniValue::VARR);
+    // large lists are streamed entry by entry if possible, see JSONRPCRequest::streamWriter.
+    // Only once cs_main is released though, a slow client mustn't hold up validation.
+    CJSONStreamWriter* writer = request.streamWriter;
+    CJSONStreamHold hold(writer);
+    bool fStarted = false;
+    auto addEntry = [&](const CDeterministicMNCPtr& dmn, bool detailed) {
+        if (!writer) {
+            ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+            return;
+        }
+        if (!fStarted) {
+            writer->BeginArray();
+            fStarted = true;
+        }
+        writer->Value(BuildDMNListEntry(pwallet, dmn, detailed));
+    };
 
     LOCK(cs_main);
 
@@ -979,7 +997,7 @@ UniValue protx_list(const JSONRPCRequest& request)
                 CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) ||
                 CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) ||
                 CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
-                ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+                addEntry(dmn, detailed);
             }
         });
 #endif
@@ -1000,12 +1018,19 @@ UniValue protx_list(const JSONRPCRequest& request)
         CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]->GetBlockHash());
         bool onlyValid = type == "valid";
         mnList.ForEachMN(onlyValid, [&](const CDeterministicMNCPtr& dmn) {
-            ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+            addEntry(dmn, detailed);
         });
     } else {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
     }
 
+    if (writer) {
+        if (!fStarted) {
+            writer->BeginArray();
+        }
+        writer->EndArray();
+        return NullUniValue;
+    }
     return ret;
 }
 
@@ -1080,6 +1105,13 @@ UniValue protx_diff(const JSONRPCRequest& request)
     uint256 baseBlockHash = ParseBlock(request.params[1], "baseBlock");
     uint256 blockHash = ParseBlock(request.params[2], "block");
 
+    // the diff between two given blocks never changes
+    const std::string strCacheParams = baseBlockHash.ToString() + "/" + blockHash.ToString();
+    std::string strCached;
+    if (responseCache.Get("protx diff", strCacheParams, strCached)) {
+        return JSONResultFromCache(request, strCached);
+    }
+
     CSimplifiedMNListDiff mnListDiff;
     std::string strError;
     if (!BuildSimplifiedMNListDiff(baseBlockHash, blockHash, mnListDiff, strError)) {
@@ -1088,6 +1120,7 @@ UniValue protx_diff(const JSONRPCRequest& request)
 
     UniValue ret;
     mnListDiff.ToJson(ret);
+    responseCache.Put("protx diff", strCacheParams, blockHash, ret.write());
     return ret;
 }
 
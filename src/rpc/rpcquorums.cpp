@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "responsecache.h"
 #include "server.h"
 #include "validation.h"
 
@@ -65,6 +66,38 @@ UniValue quorum_list(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue BuildQuorumInfo(const llmq::CQuorumCPtr& quorum, bool includeSkShare)
+{
+    UniValue ret(UniValue::VOBJ);
+
+    ret.push_back(Pair("height", quorum->height));
+    ret.push_back(Pair("quorumHash", quorum->qc.quorumHash.ToString()));
+    ret.push_back(Pair("minedBlock", quorum->minedBlockHash.ToString()));
+
+    UniValue membersArr(UniValue::VARR);
+    for (size_t i = 0; i < quorum->members.size(); i++) {
+        auto& dmn = quorum->members[i];
+        UniValue mo(UniValue::VOBJ);
+        mo.push_back(Pair("proTxHash", dmn->proTxHash.ToString()));
+        mo.push_back(Pair("valid", quorum->qc.validMembers[i]));
+        if (quorum->qc.validMembers[i]) {
+            CBLSPublicKey pubKey = quorum->GetPubKeyShare(i);
+            if (pubKey.IsValid()) {
+                mo.push_back(Pair("pubKeyShare", pubKey.ToString()));
+            }
+        }
+        membersArr.push_back(mo);
+    }
+
+    ret.push_back(Pair("members", membersArr));
+    ret.push_back(Pair("quorumPublicKey", quorum->qc.quorumPublicKey.ToString()));
+    CBLSSecretKey skShare = quorum->GetSkShare();
+    if (includeSkShare && skShare.IsValid()) {
+        ret.push_back(Pair("secretKeyShare", skShare.ToString()));
+    }
+    return ret;
+}
+
 void quorum_info_help()
 {
     throw std::runtime_error(
@@ -96,37 +129,21 @@ UniValue quorum_info(const JSONRPCRequest& request)
         includeSkShare = ParseBoolV(request.params[3], "includeSkShare");
     }
 
+    // without the secret key share, the result only depends on the block the commitment was mined in
+    const std::string strCacheParams = strprintf("%d/%s", (int)llmqType, quorumHash.ToString());
+    std::string strCached;
+    if (!includeSkShare && responseCache.Get("quorum info", strCacheParams, strCached)) {
+        return JSONResultFromCache(request, strCached);
+    }
+
     auto quorum = llmq::quorumManager->GetQuorum(llmqType, quorumHash);
     if (!quorum) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "quorum not found");
     }
 
-    UniValue ret(UniValue::VOBJ);
-
-    ret.push_back(Pair("height", quorum->height));
-    ret.push_back(Pair("quorumHash", quorum->qc.quorumHash.ToString()));
-    ret.push_back(Pair("minedBlock", quorum->minedBlockHash.ToString()));
-
-    UniValue membersArr(UniValue::VARR);
-    for (size_t i = 0; i < quorum->members.size(); i++) {
-        auto& dmn = quorum->members[i];
-        UniValue mo(UniValue::VOBJ);
-        mo.push_back(Pair("proTxHash", dmn->proTxHash.ToString()));
-        mo.push_back(Pair("valid", quorum->qc.validMembers[i]));
-        if (quorum->qc.validMembers[i]) {
-            CBLSPublicKey pubKey = quorum->GetPubKeyShare(i);
-            if (pubKey.IsValid()) {
-                mo.push_back(Pair("pubKeyShare", pubKey.ToString()));
-            }
-        }
-        membersArr.push_back(mo);
-    }
-
-    ret.push_back(Pair("members", membersArr));
-    ret.push_back(Pair("quorumPublicKey", quorum->qc.quorumPublicKey.ToString()));
-    CBLSSecretKey skShare = quorum->GetSkShare();
-    if (includeSkShare && skShare.IsValid()) {
-        ret.push_back(Pair("secretKeyShare", skShare.ToString()));
+    UniValue ret = BuildQuorumInfo(quorum, includeSkShare);
+    if (!includeSkShare) {
+        responseCache.Put("quorum info", strCacheParams, quorum->minedBlockHash, ret.write());
     }
 
     return ret;
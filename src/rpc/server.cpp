@@ -7,6 +7,7 @@
 #include "rpc/server.h"
 
 #include "base58.h"
+#include "ctpl.h"
 #include "fs.h"
 #include "init.h"
 #include "random.h"
@@ -27,7 +28,10 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory> // for unique_ptr
+#include <mutex>
 #include <unordered_map>
 
 static bool fRPCRunning = false;
@@ -38,6 +42,9 @@ static CCriticalSection cs_rpcWarmup;
 static RPCTimerInterface* timerInterface = NULL;
 /* Map of name to timer. */
 static std::map<std::string, std::unique_ptr<RPCTimerBase> > deadlineTimers;
+/* Workers for the parallel elements of JSON-RPC batches */
+static std::unique_ptr<ctpl::thread_pool> rpcBatchPool;
+static int nRPCBatchConcurrency = DEFAULT_RPC_BATCH_CONCURRENCY;
 
 static struct CRPCSignals
 {
@@ -364,6 +371,12 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
 bool StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    int nBatchThreads = GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS);
+    nRPCBatchConcurrency = std::max((int)GetArg("-rpcbatchconcurrency", DEFAULT_RPC_BATCH_CONCURRENCY), 1);
+    if (nBatchThreads > 0 && nRPCBatchConcurrency > 1 && !rpcBatchPool) {
+        rpcBatchPool.reset(new ctpl::thread_pool(nBatchThreads));
+        RenameThreadPool(*rpcBatchPool, "dash-rpc-batch");
+    }
     fRPCRunning = true;
     g_rpcSignals.Started();
     return true;
@@ -380,6 +393,11 @@ void StopRPC()
 {
     LogPrint(BCLog::RPC, "Stopping RPC\n");
     deadlineTimers.clear();
+    if (rpcBatchPool) {
+        // Batches still running finish their remaining elements on their own HTTP worker
+        rpcBatchPool->clear_queue();
+        rpcBatchPool->stop(true);
+    }
     DeleteAuthCookie();
     g_rpcSignals.Stopped();
 }
@@ -465,11 +483,79 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
+static bool IsParallelBatchRequest(const UniValue& req)
+{
+    if (!req.isObject())
+        return false;
+    const UniValue& method = find_value(req.get_obj(), "method");
+    if (!method.isStr())
+        return false;
+    const CRPCCommand* pcmd = tableRPC[method.get_str()];
+    return pcmd && pcmd->okParallelBatch;
+}
+
+namespace {
+/**
+ * A run of consecutive parallel-safe elements of a batch. The HTTP worker and up to
+ * -rpcbatchconcurrency - 1 batch workers take elements from it until none are left.
+ * Shared ownership keeps it alive for workers which only get to run after all is done.
+ */
+struct ParallelBatchGroup
+{
+    std::vector<UniValue> vRequests;
+    std::vector<UniValue> vResults;
+    std::atomic<size_t> nNext{0};
+    size_t nDone{0};
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    void Run()
+    {
+        size_t i;
+        while ((i = nNext++) < vRequests.size()) {
+            vResults[i] = JSONRPCExecOne(vRequests[i]);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (++nDone == vRequests.size()) {
+                cond.notify_all();
+            }
+        }
+    }
+};
+} // namespace
+
 std::string JSONRPCExecBatch(const UniValue& vReq)
 {
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    size_t nPos = 0;
+    while (nPos < vReq.size()) {
+        // Consecutive parallel-safe elements run concurrently, everything else runs alone
+        // and in order, so later elements still see the effects of earlier ones
+        size_t nEnd = nPos;
+        while (rpcBatchPool && nEnd < vReq.size() && IsParallelBatchRequest(vReq[nEnd]))
+            nEnd++;
+        if (nEnd - nPos < 2) {
+            ret.push_back(JSONRPCExecOne(vReq[nPos]));
+            nPos++;
+            continue;
+        }
+
+        auto group = std::make_shared<ParallelBatchGroup>();
+        group->vRequests.assign(vReq.getValues().begin() + nPos, vReq.getValues().begin() + nEnd);
+        group->vResults.resize(group->vRequests.size());
+        size_t nHelpers = std::min<size_t>(nRPCBatchConcurrency, group->vRequests.size()) - 1;
+        for (size_t i = 0; i < nHelpers; i++) {
+            rpcBatchPool->push([group](int) { group->Run(); });
+        }
+        group->Run();
+        {
+            std::unique_lock<std::mutex> lock(group->mutex);
+            group->cond.wait(lock, [&group] { return group->nDone == group->vRequests.size(); });
+        }
+
+        for (const UniValue& result : group->vResults)
+            ret.push_back(result);
+        nPos = nEnd;
+    }
 
     return ret.write() + "\n";
 }
@@ -31,6 +31,11 @@ namespace RPCServer
 class CBlockIndex;
 class CNetAddr;
 
+/** Default for -rpcbatchthreads, 0 runs JSON-RPC batches sequentially */
+static const int DEFAULT_RPC_BATCH_THREADS = 4;
+/** Default for -rpcbatchconcurrency, the number of elements of one batch run at the same time */
+static const int DEFAULT_RPC_BATCH_CONCURRENCY = 4;
+
 /** Wrapper for UniValue::VType, which includes typeAny:
  * Used to denote don't care type. Only used by RPCTypeCheckObj */
 struct UniValueType {
@@ -40,6 +45,8 @@ struct UniValueType {
     UniValue::VType type;
 };
 
+class CJSONStreamWriter;
+
 class JSONRPCRequest
 {
 public:
@@ -49,8 +56,13 @@ public:
     bool fHelp;
     std::string URI;
     std::string authUser;
+    /**
+     * Set when the result may be streamed. Handlers of large results can write the result
+     * to it instead of building it as UniValue and then return NullUniValue.
+     */
+    CJSONStreamWriter* streamWriter;
 
-    JSONRPCRequest() { id = NullUniValue; params = NullUniValue; fHelp = false; }
+    JSONRPCRequest() { id = NullUniValue; params = NullUniValue; fHelp = false; streamWriter = nullptr; }
     void parse(const UniValue& valRequest);
 };
 
@@ -139,6 +151,8 @@ public:
     rpcfn_type actor;
     bool okSafeMode;
     std::vector<std::string> argNames;
+    /** Read-only and independent of other requests, may run concurrently with others of a JSON-RPC batch */
+    bool okParallelBatch = false;
 };
 
 /**
@@ -80,15 +80,24 @@ void InitSignatureCache()
             (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
 }
 
+void AddSignatureCacheEntries(const std::vector<uint256>& vEntries)
+{
+    for (uint256 entry : vEntries) {
+        signatureCache.Set(entry);
+    }
+}
+
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
     signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
-    if (signatureCache.Get(entry, !store))
+    if (signatureCache.Get(entry, !store && !pvDeferredEntries))
         return true;
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
         return false;
-    if (store)
+    if (pvDeferredEntries)
+        pvDeferredEntries->push_back(entry);
+    else if (store)
         signatureCache.Set(entry);
     return true;
 }
@@ -44,13 +44,23 @@ class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    std::vector<uint256>* pvDeferredEntries;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, bool storeIn=true) : TransactionSignatureChecker(txToIn, nInIn), store(storeIn) {}
+    /**
+     * If pvDeferredEntriesIn is set, the cache is only looked up: the entries of verified signatures
+     * are appended to it instead of being stored, so the caller can add them with
+     * AddSignatureCacheEntries once it knows the transaction is accepted.
+     */
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, bool storeIn=true, std::vector<uint256>* pvDeferredEntriesIn=NULL) :
+        TransactionSignatureChecker(txToIn, nInIn), store(storeIn), pvDeferredEntries(pvDeferredEntriesIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
 };
 
 void InitSignatureCache();
 
+/** Store entries collected by a CachingTransactionSignatureChecker with deferred entries */
+void AddSignatureCacheEntries(const std::vector<uint256>& vEntries);
+
 #endif // BITCOIN_SCRIPT_SIGCACHE_H
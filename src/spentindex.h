@@ -370,4 +370,41 @@ struct CAddressIndexIteratorHeightKey {
 };
 
 
+/** Running totals of an address, kept in the address summary index */
+struct CAddressSummary {
+    CAmount balance;
+    CAmount received;
+    int64_t txCount;
+    int firstHeight;
+    int lastHeight;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(txCount);
+        READWRITE(firstHeight);
+        READWRITE(lastHeight);
+    }
+
+    CAddressSummary() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+        firstHeight = -1;
+        lastHeight = -1;
+    }
+
+    bool IsNull() const {
+        return txCount == 0;
+    }
+};
+
+
 #endif // BITCOIN_SPENTINDEX_H
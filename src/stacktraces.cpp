@@ -44,6 +44,8 @@
 
 static void PrintCrashInfo(const std::string& s)
 {
+    // the process is about to die, the log writer thread won't get to write the report
+    AbortAsyncLogging();
     LogPrintf("%s", s);
     fprintf(stderr, "%s", s.c_str());
     fflush(stderr);
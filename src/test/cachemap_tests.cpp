@@ -133,4 +133,33 @@ BOOST_AUTO_TEST_CASE(cachemap_test)
     BOOST_CHECK(Compare(cmapTest1, mapTest4));
 }
 
+BOOST_AUTO_TEST_CASE(cachemap_pruned_test)
+{
+    CacheMap<int,int> cmapTest(3);
+    std::vector<CacheMap<int,int>::item_t> vecPruned;
+
+    // nothing is pruned while there is room
+    for(int i = 0; i < 3; ++i) {
+        BOOST_CHECK(cmapTest.Insert(i, i * 10, vecPruned));
+    }
+    BOOST_CHECK(vecPruned.empty());
+
+    // a duplicate key is rejected without pruning anything
+    BOOST_CHECK(!cmapTest.Insert(1, 100, vecPruned));
+    BOOST_CHECK(vecPruned.empty());
+
+    // the oldest item is pruned and reported
+    BOOST_CHECK(cmapTest.Insert(3, 30, vecPruned));
+    BOOST_CHECK(vecPruned.size() == 1);
+    BOOST_CHECK(vecPruned[0].key == 0);
+    BOOST_CHECK(vecPruned[0].value == 0);
+    BOOST_CHECK(!cmapTest.HasKey(0));
+
+    BOOST_CHECK(cmapTest.Insert(4, 40, vecPruned));
+    BOOST_CHECK(vecPruned.size() == 2);
+    BOOST_CHECK(vecPruned[1].key == 1);
+    BOOST_CHECK(vecPruned[1].value == 10);
+    BOOST_CHECK(cmapTest.GetSize() == 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -771,6 +771,42 @@ BOOST_AUTO_TEST_CASE(ccoins_add)
     CheckAddCoin(VALUE2, VALUE3, VALUE3, DIRTY|FRESH, DIRTY|FRESH, true );
 }
 
+void CheckAddFetchedCoin(CAmount cache_value, CAmount fetched_value, CAmount expected_value, char cache_flags, char expected_flags, bool expected_result)
+{
+    SingleEntryCacheTest test(ABSENT, cache_value, cache_flags);
+
+    Coin coin;
+    SetCoinsValue(fetched_value, coin);
+    bool result = test.cache.AddFetchedCoin(OUTPOINT, std::move(coin));
+    test.cache.SelfTest();
+
+    CAmount result_value;
+    char result_flags;
+    GetCoinsMapEntry(test.cache.map(), result_value, result_flags);
+    BOOST_CHECK_EQUAL(result, expected_result);
+    BOOST_CHECK_EQUAL(result_value, expected_value);
+    BOOST_CHECK_EQUAL(result_flags, expected_flags);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_addfetched)
+{
+    /* Check AddFetchedCoin behavior, inserting a coin that was read from the
+     * backing view elsewhere. Existing entries must never be overwritten and
+     * spent coins must never be inserted.
+     *
+     *                  Cache   Fetched Result  Cache        Result       Return
+     *                  Value   Value   Value   Flags        Flags        Value
+     */
+    CheckAddFetchedCoin(ABSENT, VALUE1, VALUE1, NO_ENTRY   , 0          , true );
+    CheckAddFetchedCoin(ABSENT, PRUNED, ABSENT, NO_ENTRY   , NO_ENTRY   , false);
+    CheckAddFetchedCoin(PRUNED, VALUE1, PRUNED, 0          , 0          , false);
+    CheckAddFetchedCoin(PRUNED, VALUE1, PRUNED, DIRTY      , DIRTY      , false);
+    CheckAddFetchedCoin(PRUNED, VALUE1, PRUNED, DIRTY|FRESH, DIRTY|FRESH, false);
+    CheckAddFetchedCoin(VALUE2, VALUE1, VALUE2, 0          , 0          , false);
+    CheckAddFetchedCoin(VALUE2, VALUE1, VALUE2, DIRTY      , DIRTY      , false);
+    CheckAddFetchedCoin(VALUE2, VALUE1, VALUE2, DIRTY|FRESH, DIRTY|FRESH, false);
+}
+
 void CheckWriteCoins(CAmount parent_value, CAmount child_value, CAmount expected_value, char parent_flags, char child_flags, char expected_flags)
 {
     SingleEntryCacheTest test(ABSENT, parent_value, parent_flags);
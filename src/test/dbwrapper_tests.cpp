@@ -320,6 +320,88 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_profiles)
+{
+    std::string strError;
+    CDBOptions defaults = CDBOptions::FromCacheSize(8 << 20);
+    BOOST_CHECK_EQUAL(defaults.nBlockCacheSize, 4 << 20);
+    BOOST_CHECK_EQUAL(defaults.nWriteBufferSize, 2 << 20);
+    BOOST_CHECK_EQUAL(defaults.CacheSize(), 8 << 20);
+
+    ForceSetMultiArgs("-dbprofile", {"chainstate:cache=16,bloombits=0", "llmq:blocksize=16,maxopenfiles=32", "chainstate:writebuffer=1"});
+    BOOST_CHECK(CheckDBProfiles(strError));
+
+    // settings are applied in order, later ones refine "cache"
+    CDBOptions chainstate = GetDBOptions("chainstate", 8 << 20);
+    BOOST_CHECK_EQUAL(chainstate.nBlockCacheSize, 8 << 20);
+    BOOST_CHECK_EQUAL(chainstate.nWriteBufferSize, 1 << 20);
+    BOOST_CHECK_EQUAL(chainstate.nBloomBits, 0);
+    BOOST_CHECK_EQUAL(chainstate.nMaxOpenFiles, defaults.nMaxOpenFiles);
+
+    CDBOptions llmq = GetDBOptions("llmq", 8 << 20);
+    BOOST_CHECK_EQUAL(llmq.nBlockCacheSize, defaults.nBlockCacheSize);
+    BOOST_CHECK_EQUAL(llmq.nBlockSize, 16 << 10);
+    BOOST_CHECK_EQUAL(llmq.nMaxOpenFiles, 32);
+
+    // anonymous and untouched databases keep the defaults
+    BOOST_CHECK_EQUAL(GetDBOptions("", 8 << 20).nBloomBits, defaults.nBloomBits);
+    BOOST_CHECK_EQUAL(GetDBOptions("evodb", 8 << 20).CacheSize(), defaults.CacheSize());
+
+    ForceSetMultiArgs("-dbprofile", {"mempool:cache=16"});
+    BOOST_CHECK(!CheckDBProfiles(strError));
+    ForceSetMultiArgs("-dbprofile", {"evodb:cache"});
+    BOOST_CHECK(!CheckDBProfiles(strError));
+    ForceSetMultiArgs("-dbprofile", {"evodb:size=1"});
+    BOOST_CHECK(!CheckDBProfiles(strError));
+    ForceSetMultiArgs("-dbprofile", {"evodb:cache=-1"});
+    BOOST_CHECK(!CheckDBProfiles(strError));
+
+    ForceSetMultiArgs("-dbprofile", {});
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_stats)
+{
+    {
+        // blocks which can be read in place, like those of memory mapped table files, never enter
+        // the block cache. With the memory env only the ones which had to be copied do
+        CDBWrapper dbw("", (1 << 20), true, false, false, "evodb");
+        for (int i = 0; i < 1000; i++) {
+            BOOST_CHECK(dbw.Write(i, GetRandHash()));
+        }
+        // force the data into table files, so reads go through the block cache
+        dbw.CompactRange(0, 1000);
+
+        uint256 res;
+        for (int n = 0; n < 2; n++) {
+            for (int i = 0; i < 1000; i++) {
+                BOOST_CHECK(dbw.Read(i, res));
+            }
+        }
 
+        std::vector<CDBStats> vStats = GetDBStats();
+        BOOST_CHECK_EQUAL(vStats.size(), 1);
+        CDBStats& stats = vStats[0];
+        BOOST_CHECK_EQUAL(stats.strName, "evodb");
+        BOOST_CHECK_EQUAL(stats.strPath, "");
+        BOOST_CHECK_EQUAL(stats.options.nBlockCacheSize, 1 << 19);
+        // every read looks up one block
+        BOOST_CHECK(stats.nBlockCacheHits + stats.nBlockCacheMisses >= 2000);
+        BOOST_CHECK(stats.nBlockCacheHits > 0);
+        BOOST_CHECK(stats.nBlockCacheMisses > 0);
+        BOOST_CHECK(stats.nBlockCacheUsage > 0);
+        BOOST_CHECK(stats.nMemoryUsage >= stats.nBlockCacheUsage);
+
+        int nFiles = 0;
+        uint64_t nBytes = 0;
+        for (const auto& level : stats.vLevels) {
+            nFiles += level.nFiles;
+            nBytes += level.nBytes;
+        }
+        BOOST_CHECK(nFiles > 0);
+        BOOST_CHECK(nBytes > 0);
+    }
+    // closed databases are gone
+    BOOST_CHECK(GetDBStats().empty());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,165 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "governance/governance.h"
+#include "governance/governance-journal.h"
+#include "random.h"
+#include "util.h"
+
+#include "test/test_dash.h"
+
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_journal_tests, BasicTestingSetup)
+
+typedef std::pair<CGovernanceJournal::RecordType, uint256> record_t;
+
+static std::vector<record_t> ReplayAll(CGovernanceJournal& journal)
+{
+    std::vector<record_t> vecRecords;
+    journal.Replay([&vecRecords](CGovernanceJournal::RecordType type, CDataStream& ssRecord) {
+        uint256 hash;
+        ssRecord >> hash;
+        vecRecords.emplace_back(type, hash);
+    });
+    return vecRecords;
+}
+
+BOOST_AUTO_TEST_CASE(governance_journal_replay)
+{
+    fs::path pathJournal = fs::temp_directory_path() / fs::unique_path("test_dash_governance_%%%%-%%%%.log");
+
+    std::vector<record_t> vecExpected;
+    for (int i = 0; i < 10; i++) {
+        vecExpected.emplace_back(i % 2 ? CGovernanceJournal::RECORD_VOTE : CGovernanceJournal::RECORD_OBJECT, GetRandHash());
+    }
+
+    {
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, true));
+        for (const auto& record : vecExpected) {
+            BOOST_CHECK(journal.Append(record.first, record.second));
+        }
+        BOOST_CHECK(journal.Flush());
+    }
+
+    uint64_t nSize;
+    {
+        // everything is replayed in order and survives reopening
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, false));
+        nSize = journal.GetSize();
+        BOOST_CHECK(ReplayAll(journal) == vecExpected);
+        BOOST_CHECK_EQUAL(journal.GetSize(), nSize);
+    }
+
+    {
+        // a torn write at the end is dropped, appending afterwards still works
+        FILE* file = fsbridge::fopen(pathJournal, "ab");
+        unsigned char garbage[] = {CGovernanceJournal::RECORD_VOTE, 0x20, 0x00, 0x00, 0x00, 0x01, 0x02};
+        fwrite(garbage, 1, sizeof(garbage), file);
+        fclose(file);
+
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, false));
+        BOOST_CHECK(ReplayAll(journal) == vecExpected);
+        BOOST_CHECK_EQUAL(journal.GetSize(), nSize);
+        BOOST_CHECK_EQUAL(fs::file_size(pathJournal), nSize);
+
+        vecExpected.emplace_back(CGovernanceJournal::RECORD_ERASE_OBJECT, GetRandHash());
+        BOOST_CHECK(journal.Append(vecExpected.back().first, vecExpected.back().second));
+        BOOST_CHECK(ReplayAll(journal) == vecExpected);
+    }
+
+    {
+        // a corrupted record cuts off everything from there on
+        FILE* file = fsbridge::fopen(pathJournal, "r+b");
+        fseek(file, nSize / 2, SEEK_SET);
+        fputc(fgetc(file) ^ 0xff, file);
+        fclose(file);
+
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, false));
+        std::vector<record_t> vecReplayed = ReplayAll(journal);
+        BOOST_CHECK(vecReplayed.size() < vecExpected.size());
+        BOOST_CHECK(std::equal(vecReplayed.begin(), vecReplayed.end(), vecExpected.begin()));
+        BOOST_CHECK(ReplayAll(journal) == vecReplayed);
+
+        // and Reset drops everything
+        BOOST_CHECK(journal.Reset());
+        BOOST_CHECK_EQUAL(journal.GetSize(), 0);
+        BOOST_CHECK(ReplayAll(journal).empty());
+    }
+
+    fs::remove(pathJournal);
+}
+
+BOOST_AUTO_TEST_CASE(governance_journal_discard)
+{
+    fs::path pathJournal = fs::temp_directory_path() / fs::unique_path("test_dash_governance_%%%%-%%%%.log");
+
+    std::vector<record_t> vecRecords;
+    for (int i = 0; i < 10; i++) {
+        vecRecords.emplace_back(i % 2 ? CGovernanceJournal::RECORD_REMOVE_VOTES : CGovernanceJournal::RECORD_VOTE, GetRandHash());
+    }
+
+    {
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, true));
+        for (size_t i = 0; i < 6; i++) {
+            BOOST_CHECK(journal.Append(vecRecords[i].first, vecRecords[i].second));
+        }
+        // a snapshot covering the first 6 records is taken here, the rest is appended while it's written
+        uint64_t nSnapshotSize = journal.GetSize();
+        for (size_t i = 6; i < vecRecords.size(); i++) {
+            BOOST_CHECK(journal.Append(vecRecords[i].first, vecRecords[i].second));
+        }
+
+        BOOST_CHECK(journal.Discard(nSnapshotSize));
+        std::vector<record_t> vecTail(vecRecords.begin() + 6, vecRecords.end());
+        BOOST_CHECK(ReplayAll(journal) == vecTail);
+        BOOST_CHECK_EQUAL(journal.GetSize(), fs::file_size(pathJournal));
+
+        // appending still works after the journal was replaced
+        vecTail.emplace_back(CGovernanceJournal::RECORD_OBJECT, GetRandHash());
+        BOOST_CHECK(journal.Append(vecTail.back().first, vecTail.back().second));
+        BOOST_CHECK(journal.Flush());
+        BOOST_CHECK(ReplayAll(journal) == vecTail);
+
+        // discarding nothing keeps everything, discarding everything empties the journal
+        BOOST_CHECK(journal.Discard(0));
+        BOOST_CHECK(ReplayAll(journal) == vecTail);
+        BOOST_CHECK(journal.Discard(journal.GetSize()));
+        BOOST_CHECK_EQUAL(journal.GetSize(), 0);
+        BOOST_CHECK(ReplayAll(journal).empty());
+    }
+
+    fs::remove(pathJournal);
+}
+
+BOOST_AUTO_TEST_CASE(governance_journal_without_snapshot)
+{
+    fs::path pathJournal = fs::temp_directory_path() / fs::unique_path("test_dash_governance_%%%%-%%%%.log");
+
+    {
+        CGovernanceJournal journal;
+        BOOST_CHECK(journal.Open(pathJournal, true));
+        BOOST_CHECK(journal.Append(CGovernanceJournal::RECORD_ERASE_OBJECT, std::make_pair(GetRandHash(), GetTime())));
+        BOOST_CHECK(journal.Flush());
+    }
+    BOOST_CHECK(fs::file_size(pathJournal) > 0);
+
+    // nothing was loaded from governance.dat, so the journal doesn't apply and is dropped
+    CGovernanceManager govman;
+    BOOST_CHECK(govman.OpenJournal(pathJournal, false));
+    govman.ReplayJournal();
+    BOOST_CHECK_EQUAL(fs::file_size(pathJournal), 0);
+    BOOST_CHECK(govman.IsFullDumpNeeded(0));
+
+    fs::remove(pathJournal);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "clientversion.h"
+#include "governance/governance-votedb.h"
+#include "random.h"
+
+#include "test/test_dash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_votedb_tests, BasicTestingSetup)
+
+static CGovernanceVote CreateVote(const COutPoint& outpoint, const uint256& nParentHash, vote_signal_enum_t eSignal, int64_t nTime)
+{
+    CGovernanceVote vote(outpoint, nParentHash, eSignal, VOTE_OUTCOME_YES);
+    vote.SetTime(nTime);
+    return vote;
+}
+
+BOOST_AUTO_TEST_CASE(votedb_add_remove)
+{
+    uint256 nParentHash = GetRandHash();
+    CGovernanceObjectVoteFile fileVotes;
+
+    std::vector<CGovernanceVote> vecVotes;
+    for (int i = 0; i < 10; i++) {
+        vecVotes.push_back(CreateVote(COutPoint(GetRandHash(), i), nParentHash, VOTE_SIGNAL_FUNDING, 1000));
+        fileVotes.AddVote(vecVotes.back());
+        // adding the same vote again is a no-op
+        fileVotes.AddVote(vecVotes.back());
+    }
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 10);
+    for (const auto& vote : vecVotes) {
+        BOOST_CHECK(fileVotes.HasVote(vote.GetHash()));
+    }
+
+    // a newer vote replaces the older one from the same masternode for the same signal only
+    CGovernanceVote voteNewer = CreateVote(vecVotes[3].GetMasternodeOutpoint(), nParentHash, VOTE_SIGNAL_FUNDING, 2000);
+    CGovernanceVote voteOtherSignal = CreateVote(vecVotes[3].GetMasternodeOutpoint(), nParentHash, VOTE_SIGNAL_DELETE, 2000);
+    fileVotes.AddVote(voteNewer);
+    fileVotes.AddVote(voteOtherSignal);
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 11);
+    BOOST_CHECK(!fileVotes.HasVote(vecVotes[3].GetHash()));
+    BOOST_CHECK(fileVotes.HasVote(voteNewer.GetHash()));
+    BOOST_CHECK(fileVotes.HasVote(voteOtherSignal.GetHash()));
+
+    // the index still points to the right votes after removal shifted them
+    for (const auto& vote : {vecVotes[9], voteNewer, voteOtherSignal}) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        BOOST_CHECK(fileVotes.SerializeVoteToStream(vote.GetHash(), ss));
+        CGovernanceVote voteRead;
+        ss >> voteRead;
+        BOOST_CHECK(voteRead.GetHash() == vote.GetHash());
+    }
+
+    fileVotes.RemoveVotesFromMasternode(vecVotes[3].GetMasternodeOutpoint());
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 9);
+    BOOST_CHECK(!fileVotes.HasVote(voteNewer.GetHash()));
+    BOOST_CHECK(!fileVotes.HasVote(voteOtherSignal.GetHash()));
+}
+
+BOOST_AUTO_TEST_CASE(votedb_foreach_and_serialize)
+{
+    uint256 nParentHash = GetRandHash();
+    CGovernanceObjectVoteFile fileVotes;
+    for (int i = 0; i < 25; i++) {
+        fileVotes.AddVote(CreateVote(COutPoint(GetRandHash(), i), nParentHash, VOTE_SIGNAL_FUNDING, 1000 + i));
+    }
+
+    // walking in batches visits every vote exactly once, newest first
+    std::vector<uint256> vecHashes;
+    uint64_t nCursor = CGovernanceObjectVoteFile::CURSOR_BEGIN;
+    int nBatches = 0;
+    do {
+        nCursor = fileVotes.ForEachVote(nCursor, 10, [&vecHashes](const CGovernanceVote& vote) {
+            vecHashes.push_back(vote.GetHash());
+        });
+        nBatches++;
+    } while (nCursor != CGovernanceObjectVoteFile::CURSOR_END);
+    BOOST_CHECK_EQUAL(nBatches, 3);
+    BOOST_CHECK_EQUAL(vecHashes.size(), 25);
+    std::vector<CGovernanceVote> vecVotes = fileVotes.GetVotes();
+    BOOST_CHECK_EQUAL(vecVotes.size(), 25);
+    for (size_t i = 0; i < vecVotes.size(); i++) {
+        BOOST_CHECK(vecVotes[i].GetHash() == vecHashes[i]);
+        BOOST_CHECK_EQUAL(vecVotes[i].GetTimestamp(), 1000 + 24 - (int64_t)i);
+    }
+    BOOST_CHECK_EQUAL(fileVotes.ForEachVote(CGovernanceObjectVoteFile::CURSOR_END, 10, [](const CGovernanceVote& vote) { BOOST_ERROR("no more votes expected"); }), CGovernanceObjectVoteFile::CURSOR_END);
+
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << fileVotes;
+    CGovernanceObjectVoteFile fileVotesRead;
+    ss >> fileVotesRead;
+    BOOST_CHECK_EQUAL(fileVotesRead.GetVoteCount(), 25);
+    for (const auto& nHash : vecHashes) {
+        BOOST_CHECK(fileVotesRead.HasVote(nHash));
+    }
+    // the order survives a round trip
+    std::vector<CGovernanceVote> vecVotesRead = fileVotesRead.GetVotes();
+    BOOST_CHECK_EQUAL(vecVotesRead.size(), 25);
+    for (size_t i = 0; i < vecVotesRead.size(); i++) {
+        BOOST_CHECK(vecVotesRead[i].GetHash() == vecHashes[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(votedb_foreach_with_removal)
+{
+    uint256 nParentHash = GetRandHash();
+    CGovernanceObjectVoteFile fileVotes;
+    std::vector<CGovernanceVote> vecVotes;
+    for (int i = 0; i < 20; i++) {
+        vecVotes.push_back(CreateVote(COutPoint(GetRandHash(), i), nParentHash, VOTE_SIGNAL_FUNDING, 1000 + i));
+        fileVotes.AddVote(vecVotes.back());
+    }
+
+    std::vector<uint256> vecHashes;
+    auto collect = [&vecHashes](const CGovernanceVote& vote) { vecHashes.push_back(vote.GetHash()); };
+
+    // first page: votes 19..12
+    uint64_t nCursor = fileVotes.ForEachVote(CGovernanceObjectVoteFile::CURSOR_BEGIN, 8, collect);
+    BOOST_CHECK_EQUAL(vecHashes.size(), 8);
+
+    // remove an already visited vote, the next vote to visit and a later one, then add a new vote
+    fileVotes.RemoveVotesFromMasternode(vecVotes[15].GetMasternodeOutpoint());
+    fileVotes.RemoveVotesFromMasternode(vecVotes[11].GetMasternodeOutpoint());
+    fileVotes.RemoveVotesFromMasternode(vecVotes[3].GetMasternodeOutpoint());
+    fileVotes.AddVote(CreateVote(COutPoint(GetRandHash(), 20), nParentHash, VOTE_SIGNAL_FUNDING, 2000));
+    BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 18);
+
+    while (nCursor != CGovernanceObjectVoteFile::CURSOR_END) {
+        nCursor = fileVotes.ForEachVote(nCursor, 8, collect);
+    }
+
+    // every remaining older vote was visited exactly once and nothing was repeated
+    std::vector<uint256> vecExpected;
+    for (int i = 19; i >= 0; i--) {
+        if (i < 12 && (i == 11 || i == 3)) continue;
+        vecExpected.push_back(vecVotes[i].GetHash());
+    }
+    BOOST_CHECK_EQUAL(vecHashes.size(), vecExpected.size());
+    BOOST_CHECK(vecHashes == vecExpected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,8 +3,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "hash.h"
+#include "primitives/block.h"
 #include "utilstrencodings.h"
 #include "test/test_dash.h"
+#include "test/test_random.h"
 
 #include <vector>
 
@@ -149,4 +151,38 @@ BOOST_AUTO_TEST_CASE(siphash)
     BOOST_CHECK_EQUAL(SipHashUint256(1, 2, ss.GetHash()), 0x79751e980c2a0a35ULL);
 }
 
+BOOST_AUTO_TEST_CASE(hashx11many)
+{
+    // HashX11Many must match HashX11 for any batch size, including partial groups
+    for (size_t nLen : {0, 1, 80, 200}) {
+        for (size_t nCount = 0; nCount < 20; nCount++) {
+            std::vector<unsigned char> vch(nLen * nCount);
+            for (auto& c : vch) {
+                c = insecure_rand() & 0xff;
+            }
+            std::vector<uint256> vHashes(nCount);
+            HashX11Many(vch.data(), nLen, nCount, vHashes.data());
+            for (size_t i = 0; i < nCount; i++) {
+                const unsigned char* pbegin = vch.data() + i * nLen;
+                BOOST_CHECK(vHashes[i] == HashX11(pbegin, pbegin + nLen));
+            }
+        }
+    }
+
+    std::vector<CBlockHeader> headers(11);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nVersion = 2;
+        headers[i].hashPrevBlock = i ? headers[i - 1].GetHash() : uint256();
+        headers[i].hashMerkleRoot = GetRandHash();
+        headers[i].nTime = 1500000000 + i;
+        headers[i].nBits = 0x1e0ffff0;
+        headers[i].nNonce = i;
+    }
+    std::vector<uint256> vHeaderHashes = CBlockHeader::GetHashes(headers);
+    BOOST_CHECK_EQUAL(vHeaderHashes.size(), headers.size());
+    for (size_t i = 0; i < headers.size(); i++) {
+        BOOST_CHECK(vHeaderHashes[i] == headers[i].GetHash());
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
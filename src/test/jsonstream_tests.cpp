@@ -0,0 +1,127 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include "test/test_dash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(jsonstream_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(jsonstream_matches_univalue)
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.push_back(Pair("str", "quote \" and \\ backslash\n"));
+    inner.push_back(Pair("neg", (int64_t)-42));
+    inner.push_back(Pair("null", NullUniValue));
+    inner.push_back(Pair("empty", UniValue(UniValue::VARR)));
+
+    UniValue arr(UniValue::VARR);
+    arr.push_back(inner);
+    arr.push_back(true);
+    arr.push_back(UniValue(UniValue::VOBJ));
+
+    UniValue expected(UniValue::VOBJ);
+    expected.push_back(Pair("first", 1));
+    expected.push_back(Pair("arr", arr));
+    expected.push_back(Pair("big", (uint64_t)18446744073709551615ULL));
+    expected.push_back(Pair("last", false));
+
+    std::string strStreamed;
+    CJSONStreamWriter writer([&strStreamed](const std::string& strChunk) {
+        BOOST_CHECK(!strChunk.empty());
+        strStreamed += strChunk;
+    }, 4);
+    writer.BeginObject();
+    writer.Pair("first", 1);
+    writer.Key("arr").BeginArray();
+    writer.BeginObject().Fields(inner).EndObject();
+    writer.Value(true);
+    writer.BeginObject().EndObject();
+    writer.EndArray();
+    writer.Pair("big", (uint64_t)18446744073709551615ULL);
+    writer.Key("last").Value(UniValue(false));
+    BOOST_CHECK(!writer.IsComplete());
+    writer.EndObject();
+    BOOST_CHECK(writer.IsComplete());
+    writer.Flush();
+
+    BOOST_CHECK_EQUAL(strStreamed, expected.write());
+    BOOST_CHECK_EQUAL(writer.GetBytesWritten(), strStreamed.size());
+}
+
+BOOST_AUTO_TEST_CASE(jsonstream_chunks)
+{
+    std::vector<std::string> vChunks;
+    CJSONStreamWriter writer([&vChunks](const std::string& strChunk) {
+        vChunks.push_back(strChunk);
+    }, 100);
+
+    UniValue expected(UniValue::VARR);
+    writer.BeginArray();
+    for (int i = 0; i < 1000; i++) {
+        expected.push_back(i);
+        writer.Value(i);
+    }
+    writer.EndArray();
+
+    // nothing is handed out before a chunk is full
+    for (const auto& strChunk : vChunks) {
+        BOOST_CHECK(strChunk.size() >= 100 && strChunk.size() < 110);
+    }
+    std::string strRest = writer.TakeBuffer();
+    BOOST_CHECK(strRest.size() < 100);
+
+    std::string strAll;
+    for (const auto& strChunk : vChunks) {
+        strAll += strChunk;
+    }
+    BOOST_CHECK_EQUAL(strAll + strRest, expected.write());
+
+    // taking the buffer leaves nothing to flush
+    size_t nChunks = vChunks.size();
+    writer.Flush();
+    BOOST_CHECK_EQUAL(vChunks.size(), nChunks);
+}
+
+BOOST_AUTO_TEST_CASE(jsonstream_hold)
+{
+    std::vector<std::string> vChunks;
+    CJSONStreamWriter writer([&vChunks](const std::string& strChunk) {
+        vChunks.push_back(strChunk);
+    }, 100);
+
+    UniValue expected(UniValue::VARR);
+    writer.BeginArray();
+    {
+        CJSONStreamHold hold(&writer);
+        {
+            // holds nest
+            CJSONStreamHold hold2(&writer);
+        }
+        for (int i = 0; i < 1000; i++) {
+            expected.push_back(i);
+            writer.Value(i);
+        }
+        // nothing reaches the sink while held, however much is buffered
+        BOOST_CHECK(vChunks.empty());
+    }
+    // the buffer is passed on with the next write once released
+    expected.push_back(1000);
+    writer.Value(1000);
+    writer.EndArray();
+    BOOST_CHECK_EQUAL(vChunks.size(), 1);
+    writer.Flush();
+    std::string strAll;
+    for (const auto& strChunk : vChunks) {
+        strAll += strChunk;
+    }
+    BOOST_CHECK_EQUAL(strAll, expected.write());
+
+    // without a writer there's nothing to hold
+    CJSONStreamHold holdNothing(nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "util.h"
+
+#include "fs.h"
+#include "random.h"
+#include "utiltime.h"
+#include "test/test_dash.h"
+#include "test/testutil.h"
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+/** Logs into debug.log of a fresh data directory, without timestamps */
+struct LogTestingSetup : public BasicTestingSetup
+{
+    fs::path pathTemp;
+
+    LogTestingSetup()
+    {
+        pathTemp = GetTempPath() / strprintf("test_dash_log_%lu_%i", (unsigned long)GetTime(), (int)(GetRand(100000)));
+        fs::create_directories(pathTemp);
+        ForceSetArg("-datadir", pathTemp.string());
+        ClearDatadirCache();
+
+        // debug.log can only be opened once, later tests move it to their data directory
+        static bool fLogOpened = false;
+        if (!fLogOpened) {
+            OpenDebugLog();
+            fLogOpened = true;
+        } else {
+            fReopenDebugLog = true;
+        }
+        fLogTimestamps = false;
+        fPrintToDebugLog = true;
+    }
+
+    ~LogTestingSetup()
+    {
+        StopAsyncLogging();
+        fPrintToDebugLog = false;
+        fLogTimestamps = DEFAULT_LOGTIMESTAMPS;
+        ForceRemoveArg("-datadir");
+        ClearDatadirCache();
+        boost::system::error_code ec;
+        fs::remove_all(pathTemp, ec);
+    }
+
+    std::vector<std::string> ReadLog()
+    {
+        std::vector<std::string> vLines;
+        std::ifstream file((pathTemp / "debug.log").string());
+        std::string strLine;
+        while (std::getline(file, strLine)) {
+            vLines.push_back(strLine);
+        }
+        return vLines;
+    }
+};
+
+/** Log nCount numbered lines from each of nThreads threads */
+static void LogFromThreads(int nThreads, int nCount)
+{
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++) {
+        threads.emplace_back([t, nCount]() {
+            for (int i = 0; i < nCount; i++) {
+                LogPrintf("thread %d line %d\n", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+/** Check the lines of each thread are complete and in order, returns the number of messages reported as dropped */
+static int CheckLoggedLines(const std::vector<std::string>& vLines, int nThreads, int nCount, bool fAllowGaps)
+{
+    std::map<int, int> mapNext;
+    int nLogged = 0;
+    int nDropped = 0;
+    for (const std::string& strLine : vLines) {
+        int t, i, n;
+        if (sscanf(strLine.c_str(), "thread %d line %d", &t, &i) == 2) {
+            BOOST_CHECK(t >= 0 && t < nThreads);
+            if (fAllowGaps) {
+                BOOST_CHECK(i >= mapNext[t]);
+            } else {
+                BOOST_CHECK_EQUAL(i, mapNext[t]);
+            }
+            mapNext[t] = i + 1;
+            nLogged++;
+        } else if (sscanf(strLine.c_str(), "%d log messages were dropped", &n) == 1) {
+            BOOST_CHECK(fAllowGaps);
+            nDropped += n;
+        }
+    }
+    BOOST_CHECK_EQUAL(nLogged + nDropped, nThreads * nCount);
+    return nDropped;
+}
+
+BOOST_FIXTURE_TEST_SUITE(logging_tests, LogTestingSetup)
+
+BOOST_AUTO_TEST_CASE(async_logging_stop_drains)
+{
+    StartAsyncLogging(16, false);
+    LogFromThreads(4, 1000);
+    StopAsyncLogging();
+    // everything buffered was written by the time StopAsyncLogging returns
+    CheckLoggedLines(ReadLog(), 4, 1000, false);
+
+    // messages are written right away again
+    LogPrintf("synchronous\n");
+    BOOST_CHECK_EQUAL(ReadLog().back(), "synchronous");
+
+    // and the writer can be started again
+    StartAsyncLogging(16, false);
+    LogPrintf("restarted\n");
+    StopAsyncLogging();
+    BOOST_CHECK_EQUAL(ReadLog().back(), "restarted");
+}
+
+BOOST_AUTO_TEST_CASE(async_logging_block)
+{
+    // logging threads wait for room instead of dropping messages
+    StartAsyncLogging(1, false);
+    LogFromThreads(4, 2000);
+    StopAsyncLogging();
+    BOOST_CHECK_EQUAL(CheckLoggedLines(ReadLog(), 4, 2000, false), 0);
+}
+
+BOOST_AUTO_TEST_CASE(async_logging_drop)
+{
+    // whatever doesn't fit is dropped, and the number of dropped messages is reported
+    StartAsyncLogging(1, true);
+    LogFromThreads(4, 2000);
+    StopAsyncLogging();
+    CheckLoggedLines(ReadLog(), 4, 2000, true);
+}
+
+BOOST_AUTO_TEST_CASE(async_logging_abort)
+{
+    StartAsyncLogging(1024, false);
+    LogFromThreads(4, 1000);
+    // like a crash handler would: the buffer is written by the time AbortAsyncLogging returns
+    AbortAsyncLogging();
+    CheckLoggedLines(ReadLog(), 4, 1000, false);
+    LogPrintf("crash report\n");
+    BOOST_CHECK_EQUAL(ReadLog().back(), "crash report");
+
+    // the writer left behind exits by itself, so asynchronous logging can be started again
+    StartAsyncLogging(16, false);
+    LogPrintf("restarted\n");
+    StopAsyncLogging();
+    BOOST_CHECK_EQUAL(ReadLog().back(), "restarted");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
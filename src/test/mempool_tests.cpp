@@ -580,4 +580,28 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolPrioritiseUpdateTest)
+{
+    // Fee deltas are part of mempool.dat, so changing them must count as a mempool update
+    CTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx = CMutableTransaction();
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx.vout[0].nValue = 10 * COIN;
+
+    // a delta for a transaction which is not in the mempool
+    unsigned int nUpdated = pool.GetTransactionsUpdated();
+    pool.PrioritiseTransaction(tx.GetHash(), 1000);
+    BOOST_CHECK(pool.GetTransactionsUpdated() != nUpdated);
+
+    pool.addUnchecked(tx.GetHash(), entry.Fee(10000LL).FromTx(tx));
+    nUpdated = pool.GetTransactionsUpdated();
+    pool.PrioritiseTransaction(tx.GetHash(), 1000);
+    BOOST_CHECK(pool.GetTransactionsUpdated() != nUpdated);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,135 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mempoolindex.h"
+#include "arith_uint256.h"
+#include "primitives/transaction.h"
+
+#include "test/test_dash.h"
+
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(mempoolindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mempoolindex_address)
+{
+    CMempoolAddressIndex index;
+
+    uint160 addr1;
+    uint160 addr2;
+    addr1.SetHex("01");
+    addr2.SetHex("02");
+    uint256 tx1 = uint256S("aa");
+    uint256 tx2 = uint256S("bb");
+
+    // insert out of key order to verify that results come back sorted
+    index.Add(tx2, {
+        {CMempoolAddressDeltaKey(1, addr1, tx2, 1, 0), CMempoolAddressDelta(2, 20)},
+        {CMempoolAddressDeltaKey(1, addr1, tx2, 0, 0), CMempoolAddressDelta(2, 10)},
+        {CMempoolAddressDeltaKey(2, addr2, tx2, 0, 1), CMempoolAddressDelta(2, -5)},
+    });
+    index.Add(tx1, {
+        {CMempoolAddressDeltaKey(1, addr1, tx1, 0, 0), CMempoolAddressDelta(1, 30)},
+    });
+
+    std::vector<CMempoolAddressIndex::Entry> results;
+    index.Get({{addr1, 1}}, results);
+    BOOST_CHECK_EQUAL(results.size(), 3);
+    BOOST_CHECK(results[0].first.txhash == tx1);
+    BOOST_CHECK(results[1].first.txhash == tx2 && results[1].first.index == 0);
+    BOOST_CHECK(results[2].first.txhash == tx2 && results[2].first.index == 1);
+
+    // type is part of the key
+    results.clear();
+    index.Get({{addr2, 1}}, results);
+    BOOST_CHECK(results.empty());
+    index.Get({{addr2, 2}}, results);
+    BOOST_CHECK_EQUAL(results.size(), 1);
+    BOOST_CHECK_EQUAL(results[0].second.amount, -5);
+
+    index.Remove(tx2);
+    results.clear();
+    index.Get({{addr1, 1}, {addr2, 2}}, results);
+    BOOST_CHECK_EQUAL(results.size(), 1);
+    BOOST_CHECK(results[0].first.txhash == tx1);
+
+    // removing unknown txs is a no-op
+    index.Remove(tx2);
+    index.Remove(tx1);
+    results.clear();
+    index.Get({{addr1, 1}}, results);
+    BOOST_CHECK(results.empty());
+}
+
+BOOST_AUTO_TEST_CASE(mempoolindex_busy_address)
+{
+    CMempoolAddressIndex index;
+
+    uint160 addr;
+    addr.SetHex("01");
+    std::vector<uint256> txids;
+    for (int i = 0; i < 1000; i++) {
+        txids.push_back(ArithToUint256(arith_uint256(i + 1)));
+        index.Add(txids.back(), {
+            {CMempoolAddressDeltaKey(1, addr, txids.back(), 0, 0), CMempoolAddressDelta(i, 10)},
+            {CMempoolAddressDeltaKey(1, addr, txids.back(), 0, 1), CMempoolAddressDelta(i, -10)},
+        });
+    }
+
+    // removing a tx only drops its own deltas from the address
+    for (size_t i = 0; i < txids.size(); i += 2) {
+        index.Remove(txids[i]);
+    }
+    std::vector<CMempoolAddressIndex::Entry> results;
+    index.Get({{addr, 1}}, results);
+    BOOST_CHECK_EQUAL(results.size(), txids.size());
+    std::set<uint256> setRemaining;
+    for (size_t i = 0; i < results.size(); i++) {
+        BOOST_CHECK_EQUAL(results[i].first.spending, (int)(i % 2));
+        BOOST_CHECK(results[i].first.txhash == results[i - i % 2].first.txhash);
+        setRemaining.insert(results[i].first.txhash);
+    }
+    for (size_t i = 0; i < txids.size(); i++) {
+        BOOST_CHECK_EQUAL(setRemaining.count(txids[i]), i % 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mempoolindex_spent)
+{
+    CMempoolSpentIndex index;
+
+    CMutableTransaction mtx;
+    mtx.vin.resize(2);
+    mtx.vin[0].prevout = COutPoint(uint256S("01"), 0);
+    mtx.vin[1].prevout = COutPoint(uint256S("01"), 1);
+    CTransaction tx(mtx);
+
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > entries;
+    for (unsigned int i = 0; i < tx.vin.size(); i++) {
+        CSpentIndexKey key(tx.vin[i].prevout.hash, tx.vin[i].prevout.n);
+        entries.emplace_back(key, CSpentIndexValue(tx.GetHash(), i, -1, 100 * (i + 1), 1, uint160()));
+    }
+    index.Add(entries);
+
+    CSpentIndexValue value;
+    BOOST_CHECK(index.Get(CSpentIndexKey(uint256S("01"), 1), value));
+    BOOST_CHECK(value.txid == tx.GetHash());
+    BOOST_CHECK_EQUAL(value.inputIndex, 1);
+    BOOST_CHECK_EQUAL(value.satoshis, 200);
+    BOOST_CHECK(!index.Get(CSpentIndexKey(uint256S("01"), 2), value));
+
+    // entries added by another tx spending the same outpoint must survive
+    CMutableTransaction mtx2(mtx);
+    mtx2.nLockTime = 1;
+    index.Remove(CTransaction(mtx2));
+    BOOST_CHECK(index.Get(CSpentIndexKey(uint256S("01"), 0), value));
+
+    index.Remove(tx);
+    BOOST_CHECK(!index.Get(CSpentIndexKey(uint256S("01"), 0), value));
+    BOOST_CHECK(!index.Get(CSpentIndexKey(uint256S("01"), 1), value));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mpmcqueue.h"
+
+#include "test/test_dash.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(mpmcqueue_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_fifo)
+{
+    CMPMCQueue<int> queue(5);
+    // rounded up to a power of two
+    BOOST_CHECK_EQUAL(queue.Capacity(), 8);
+
+    int n;
+    BOOST_CHECK(!queue.Pop(n));
+    for (int i = 0; i < 8; i++) {
+        BOOST_CHECK(queue.Push(i));
+    }
+    BOOST_CHECK(!queue.Push(8));
+    BOOST_CHECK_EQUAL(queue.SizeApprox(), 8);
+
+    // wrap around a few times
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK(queue.Pop(n));
+        BOOST_CHECK_EQUAL(n, i);
+        BOOST_CHECK(queue.Push(i + 8));
+    }
+    for (int i = 100; i < 108; i++) {
+        BOOST_CHECK(queue.Pop(n));
+        BOOST_CHECK_EQUAL(n, i);
+    }
+    BOOST_CHECK(!queue.Pop(n));
+    BOOST_CHECK_EQUAL(queue.SizeApprox(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(mpmcqueue_threads)
+{
+    const int nProducers = 4;
+    const int nConsumers = 4;
+    const int nItemsPerProducer = 20000;
+
+    CMPMCQueue<int> queue(64);
+    std::atomic<int> nPopped(0);
+    std::atomic<bool> fInOrder(true);
+    std::vector<std::atomic<int>> vSeen(nProducers * nItemsPerProducer);
+    for (auto& seen : vSeen) {
+        seen = 0;
+    }
+
+    std::vector<std::thread> vThreads;
+    for (int p = 0; p < nProducers; p++) {
+        vThreads.emplace_back([&queue, p, nItemsPerProducer]() {
+            for (int i = 0; i < nItemsPerProducer; i++) {
+                while (!queue.Push(p * nItemsPerProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < nConsumers; c++) {
+        vThreads.emplace_back([&]() {
+            // items of every single producer must come out in order
+            std::vector<int> vLast(nProducers, -1);
+            int n;
+            while (nPopped < nProducers * nItemsPerProducer) {
+                if (!queue.Pop(n)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                nPopped++;
+                vSeen[n]++;
+                int p = n / nItemsPerProducer;
+                if (n <= vLast[p]) {
+                    fInOrder = false;
+                }
+                vLast[p] = n;
+            }
+        });
+    }
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+
+    // everything arrived exactly once
+    bool fAllOnce = true;
+    for (const auto& seen : vSeen) {
+        fAllOnce &= seen == 1;
+    }
+    BOOST_CHECK(fAllOnce);
+    BOOST_CHECK(fInOrder);
+    BOOST_CHECK_EQUAL(nPopped, nProducers * nItemsPerProducer);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
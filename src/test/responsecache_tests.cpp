@@ -0,0 +1,105 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "random.h"
+#include "rpc/responsecache.h"
+
+#include "test/test_dash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(responsecache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(responsecache_get_put)
+{
+    CResponseCache cache(1024 * 1024);
+    uint256 hashBlock = GetRandHash();
+    std::string strData;
+
+    BOOST_CHECK(!cache.Get("block", hashBlock.ToString(), strData));
+    cache.Put("block", hashBlock.ToString(), hashBlock, "data1");
+    BOOST_CHECK(cache.Get("block", hashBlock.ToString(), strData));
+    BOOST_CHECK_EQUAL(strData, "data1");
+    // same parameters for another endpoint are a different entry
+    BOOST_CHECK(!cache.Get("blockjson", hashBlock.ToString(), strData));
+
+    // storing again replaces the entry
+    cache.Put("block", hashBlock.ToString(), hashBlock, "data2");
+    BOOST_CHECK(cache.Get("block", hashBlock.ToString(), strData));
+    BOOST_CHECK_EQUAL(strData, "data2");
+
+    CResponseCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nEntries, 1);
+    BOOST_CHECK_EQUAL(stats.nHits, 2);
+    BOOST_CHECK_EQUAL(stats.nMisses, 2);
+    BOOST_CHECK(stats.nMemoryUsage > 0);
+
+    // disabled caches neither store nor return anything
+    cache.SetMaxMemory(0);
+    BOOST_CHECK(!cache.IsEnabled());
+    BOOST_CHECK_EQUAL(cache.GetStats().nEntries, 0);
+    cache.Put("block", hashBlock.ToString(), hashBlock, "data3");
+    BOOST_CHECK(!cache.Get("block", hashBlock.ToString(), strData));
+}
+
+BOOST_AUTO_TEST_CASE(responsecache_erase_block)
+{
+    CResponseCache cache(1024 * 1024);
+    uint256 hashBlock1 = GetRandHash();
+    uint256 hashBlock2 = GetRandHash();
+    std::string strData;
+
+    cache.Put("block", hashBlock1.ToString(), hashBlock1, "block1");
+    cache.Put("tx", "tx1", hashBlock1, "tx1");
+    cache.Put("block", hashBlock2.ToString(), hashBlock2, "block2");
+
+    // only the entries derived from the disconnected block are dropped
+    cache.EraseBlock(hashBlock1);
+    BOOST_CHECK(!cache.Get("block", hashBlock1.ToString(), strData));
+    BOOST_CHECK(!cache.Get("tx", "tx1", strData));
+    BOOST_CHECK(cache.Get("block", hashBlock2.ToString(), strData));
+    BOOST_CHECK_EQUAL(cache.GetStats().nInvalidations, 2);
+
+    cache.EraseBlock(hashBlock2);
+    CResponseCache::Stats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nEntries, 0);
+    BOOST_CHECK_EQUAL(stats.nMemoryUsage, 0);
+}
+
+BOOST_AUTO_TEST_CASE(responsecache_evict)
+{
+    const size_t nMaxMemory = 64 * 1024;
+    CResponseCache cache(nMaxMemory);
+    const std::string strBig(4096, 'x');
+    std::string strData;
+
+    std::vector<uint256> vHashes;
+    for (int i = 0; i < 100; i++) {
+        vHashes.push_back(GetRandHash());
+        cache.Put("block", vHashes.back().ToString(), vHashes.back(), strBig);
+        // keep the first one in use
+        BOOST_CHECK(cache.Get("block", vHashes[0].ToString(), strData));
+        BOOST_CHECK(cache.GetStats().nMemoryUsage <= nMaxMemory);
+    }
+
+    // the least recently used ones went first
+    BOOST_CHECK(cache.Get("block", vHashes.back().ToString(), strData));
+    BOOST_CHECK(!cache.Get("block", vHashes[1].ToString(), strData));
+    CResponseCache::Stats stats = cache.GetStats();
+    BOOST_CHECK(stats.nEvictions > 0);
+    BOOST_CHECK_EQUAL(stats.nEntries + stats.nEvictions, 100);
+
+    // responses larger than half of the cache are not stored at all
+    uint256 hashHuge = GetRandHash();
+    cache.Put("block", hashHuge.ToString(), hashHuge, std::string(nMaxMemory, 'x'));
+    BOOST_CHECK(!cache.Get("block", hashHuge.ToString(), strData));
+    BOOST_CHECK_EQUAL(cache.GetStats().nEntries, stats.nEntries);
+
+    // shrinking the limit evicts right away
+    cache.SetMaxMemory(nMaxMemory / 4);
+    BOOST_CHECK(cache.GetStats().nMemoryUsage <= nMaxMemory / 4);
+    BOOST_CHECK(cache.Get("block", vHashes[0].ToString(), strData));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
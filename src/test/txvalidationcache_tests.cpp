@@ -84,4 +84,58 @@ BOOST_FIXTURE_TEST_CASE(tx_mempool_block_doublespend, TestChain100Setup)
     BOOST_CHECK_EQUAL(mempool.size(), 0);
 }
 
+static CMutableTransaction SpendP2PK(const CKey& key, const COutPoint& prevout, const CScript& scriptPubKey, CAmount nValue, int nOutputs = 1)
+{
+    CMutableTransaction tx;
+    tx.nVersion = 1;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vout.resize(nOutputs);
+    for (auto& out : tx.vout) {
+        out.nValue = nValue / nOutputs;
+        out.scriptPubKey = scriptPubKey;
+    }
+
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(scriptPubKey, tx, 0, SIGHASH_ALL);
+    BOOST_CHECK(key.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    tx.vin[0].scriptSig << vchSig;
+    return tx;
+}
+
+BOOST_FIXTURE_TEST_CASE(tx_mempool_many, TestChain100Setup)
+{
+    CScript scriptPubKey = CScript() <<  ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    CAmount nValue = coinbaseTxns[0].vout[0].nValue - CENT;
+
+    CMutableTransaction parent = SpendP2PK(coinbaseKey, COutPoint(coinbaseTxns[0].GetHash(), 0), scriptPubKey, nValue, 3);
+    CMutableTransaction child = SpendP2PK(coinbaseKey, COutPoint(parent.GetHash(), 0), scriptPubKey, nValue / 3 - CENT);
+    // pays no fee, its script is never verified
+    CMutableTransaction noFee = SpendP2PK(coinbaseKey, COutPoint(parent.GetHash(), 1), scriptPubKey, nValue / 3);
+    CMutableTransaction orphan = SpendP2PK(coinbaseKey, COutPoint(GetRandHash(), 0), scriptPubKey, CENT);
+
+    // children before their parents, they are sorted by AcceptToMemoryPoolMany and admitted in a later round
+    std::vector<CTransactionRef> vtx = {MakeTransactionRef(child), MakeTransactionRef(parent), MakeTransactionRef(noFee), MakeTransactionRef(orphan)};
+    std::vector<CValidationState> vState;
+    std::vector<bool> vAccepted;
+    std::vector<bool> vMissingInputs;
+    BOOST_CHECK_EQUAL(AcceptToMemoryPoolMany(mempool, vState, vtx, true, vAccepted, &vMissingInputs), 2);
+    BOOST_CHECK(vAccepted == std::vector<bool>({true, true, false, false}));
+    BOOST_CHECK(vMissingInputs == std::vector<bool>({false, false, false, true}));
+    BOOST_CHECK_EQUAL(vState[2].GetRejectReason(), "min relay fee not met");
+    BOOST_CHECK_EQUAL(mempool.size(), 2);
+    mempool.clear();
+
+    // a bad signature fails the batch verification, the other transactions of the batch are still accepted
+    CMutableTransaction badSig = SpendP2PK(coinbaseKey, COutPoint(parent.GetHash(), 2), scriptPubKey, nValue / 3 - CENT);
+    badSig.vout[0].nValue -= 1;
+    vtx = {MakeTransactionRef(parent), MakeTransactionRef(badSig), MakeTransactionRef(child)};
+    BOOST_CHECK_EQUAL(AcceptToMemoryPoolMany(mempool, vState, vtx, true, vAccepted, &vMissingInputs), 2);
+    BOOST_CHECK(vAccepted == std::vector<bool>({true, false, true}));
+    BOOST_CHECK(vState[1].IsInvalid());
+    BOOST_CHECK_EQUAL(mempool.size(), 2);
+    mempool.clear();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -11,7 +11,15 @@
 #include "uint256.h"
 #include "ui_interface.h"
 #include "init.h"
-
+#include "util.h"
+#include "ctpl.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
 #include <stdint.h>
 
 #include <boost/thread.hpp>
@@ -22,6 +30,8 @@ static const char DB_BLOCK_FILES = 'f';
 static const char DB_TXINDEX = 't';
 static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_ADDRESSSUMMARYINDEX = 'S';
+static const char DB_ADDRESSSUMMARYBEST = 'Z';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
@@ -55,7 +65,7 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) 
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true, "chainstate")
 {
 }
 
@@ -104,7 +114,7 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, false, "blockindex") {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -232,24 +242,49 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
     return WriteBatch(batch);
 }
 
+/** Position pcursor right after key, or at key if it is not in the database */
+template<typename K>
+static void SeekAfter(CDBIterator& cursor, const K& key)
+{
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    ssKey << key;
+    cursor.Seek(ssKey);
+    if (cursor.Valid() && cursor.GetKey().str() == ssKey.str()) {
+        cursor.Next();
+    }
+}
+
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
                                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+    return ForEachAddressUnspent(addressHash, type, nullptr, [&unspentOutputs](const CAddressUnspentKey& key, const CAddressUnspentValue& value) {
+        unspentOutputs.push_back(std::make_pair(key, value));
+        return true;
+    });
+}
+
+bool CBlockTreeDB::ForEachAddressUnspent(uint160 addressHash, int type, const CAddressUnspentKey* pStartAfter,
+                                         const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& func) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (pStartAfter) {
+        SeekAfter(*pcursor, std::make_pair(DB_ADDRESSUNSPENTINDEX, *pStartAfter));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
             CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
+            if (!pcursor->GetValue(nValue)) {
                 return error("failed to get address unspent value");
             }
+            if (!func(key.second, nValue)) {
+                break;
+            }
+            pcursor->Next();
         } else {
             break;
         }
@@ -275,10 +310,23 @@ bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKe
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                                     int start, int end) {
+    if (start <= 0 || end <= 0) {
+        start = end = 0;
+    }
+    return ForEachAddressIndex(addressHash, type, start, end, nullptr, [&addressIndex](const CAddressIndexKey& key, const CAmount& nValue) {
+        addressIndex.push_back(std::make_pair(key, nValue));
+        return true;
+    });
+}
+
+bool CBlockTreeDB::ForEachAddressIndex(uint160 addressHash, int type, int start, int end, const CAddressIndexKey* pStartAfter,
+                                       const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
+    if (pStartAfter) {
+        SeekAfter(*pcursor, std::make_pair(DB_ADDRESSINDEX, *pStartAfter));
+    } else if (start > 0) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
@@ -287,17 +335,18 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
             if (end > 0 && key.second.blockHeight > end) {
                 break;
             }
             CAmount nValue;
-            if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
+            if (!pcursor->GetValue(nValue)) {
                 return error("failed to get address index value");
             }
+            if (!func(key.second, nValue)) {
+                break;
+            }
+            pcursor->Next();
         } else {
             break;
         }
@@ -306,6 +355,199 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool CBlockTreeDB::ReadAddressSummary(uint160 addressHash, int type, CAddressSummary &summary) {
+    summary.SetNull();
+    if (!Read(std::make_pair(DB_ADDRESSSUMMARYINDEX, CAddressIndexIteratorKey(type, addressHash)), summary)) {
+        // addresses which were never used have no summary
+        summary.SetNull();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::FindLastAddressIndexHeight(uint160 addressHash, int type, int nBeforeHeight, int &nHeightRet) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, nBeforeHeight)));
+    if (pcursor->Valid()) {
+        pcursor->Prev();
+    } else {
+        pcursor->SeekToLast();
+    }
+
+    std::pair<char,CAddressIndexKey> key;
+    if (pcursor->Valid() && pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX &&
+        key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+        nHeightRet = key.second.blockHeight;
+        return true;
+    }
+    return false;
+}
+
+bool CBlockTreeDB::ReadAddressSummaryBestBlock(uint256 &hashBestBlock) {
+    if (!Read(DB_ADDRESSSUMMARYBEST, hashBestBlock)) {
+        hashBestBlock.SetNull();
+        return false;
+    }
+    return true;
+}
+
+bool CBlockTreeDB::EraseAddressSummaryBestBlock() {
+    return Erase(DB_ADDRESSSUMMARYBEST, true);
+}
+
+bool CBlockTreeDB::UpdateAddressSummaryIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, int nHeight, bool fDisconnect, const uint256 &hashBestBlock) {
+    struct AddressDelta {
+        CAmount balance{0};
+        CAmount received{0};
+        std::set<uint256> setTxHashes;
+    };
+
+    // a block usually touches the same address many times, so fold the entries first
+    std::map<std::pair<unsigned int, uint160>, AddressDelta> mapDeltas;
+    for (const auto& entry : vect) {
+        AddressDelta& delta = mapDeltas[std::make_pair(entry.first.type, entry.first.hashBytes)];
+        delta.balance += entry.second;
+        if (entry.second > 0) {
+            delta.received += entry.second;
+        }
+        delta.setTxHashes.insert(entry.first.txhash);
+    }
+
+    CDBBatch batch(*this);
+    for (const auto& pair : mapDeltas) {
+        const int type = pair.first.first;
+        const uint160& addressHash = pair.first.second;
+        const AddressDelta& delta = pair.second;
+        auto key = std::make_pair(DB_ADDRESSSUMMARYINDEX, CAddressIndexIteratorKey(type, addressHash));
+
+        CAddressSummary summary;
+        ReadAddressSummary(addressHash, type, summary);
+
+        if (!fDisconnect) {
+            if (summary.IsNull()) {
+                summary.firstHeight = nHeight;
+            }
+            summary.balance += delta.balance;
+            summary.received += delta.received;
+            summary.txCount += delta.setTxHashes.size();
+            summary.lastHeight = nHeight;
+        } else {
+            summary.balance -= delta.balance;
+            summary.received -= delta.received;
+            summary.txCount -= delta.setTxHashes.size();
+            if (summary.txCount <= 0) {
+                batch.Erase(key);
+                continue;
+            }
+            // the address index entries of this block are already gone at this point
+            if (summary.lastHeight >= nHeight && !FindLastAddressIndexHeight(addressHash, type, nHeight, summary.lastHeight)) {
+                return error("%s: no address index entries left for a used address", __func__);
+            }
+        }
+        batch.Write(key, summary);
+    }
+    // the summaries and the block they correspond to change atomically
+    batch.Write(DB_ADDRESSSUMMARYBEST, hashBestBlock);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::BuildAddressSummaryIndex(int nMaxHeight, const uint256 &hashBestBlock) {
+    static const size_t MAX_BATCH_SIZE = 16 << 20;
+
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+
+    // drop the old summaries or leftovers of an earlier, interrupted build
+    {
+        CDBBatch batch(*this);
+        batch.Erase(DB_ADDRESSSUMMARYBEST);
+        pcursor->Seek(DB_ADDRESSSUMMARYINDEX);
+        while (pcursor->Valid()) {
+            std::pair<char, CAddressIndexIteratorKey> key;
+            if (!pcursor->GetKey(key) || key.first != DB_ADDRESSSUMMARYINDEX) {
+                break;
+            }
+            batch.Erase(key);
+            if (batch.SizeEstimate() > MAX_BATCH_SIZE) {
+                WriteBatch(batch);
+                batch.Clear();
+            }
+            pcursor->Next();
+        }
+        WriteBatch(batch);
+    }
+
+    // address index keys are sorted by address, height and position in the block, so every
+    // address is summarized in a single pass and entries of the same transaction are adjacent
+    CDBBatch batch(*this);
+    CAddressIndexKey lastKey;
+    CAddressSummary summary;
+    size_t nEntries = 0;
+    size_t nAddresses = 0;
+
+    auto writeSummary = [&]() {
+        if (summary.IsNull()) {
+            return;
+        }
+        batch.Write(std::make_pair(DB_ADDRESSSUMMARYINDEX, CAddressIndexIteratorKey(lastKey.type, lastKey.hashBytes)), summary);
+        nAddresses++;
+    };
+
+    pcursor->Seek(DB_ADDRESSINDEX);
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        if (ShutdownRequested()) {
+            return false;
+        }
+
+        std::pair<char,CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX) {
+            break;
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("%s: failed to get address index value", __func__);
+        }
+
+        const CAddressIndexKey& indexKey = key.second;
+        if (indexKey.blockHeight > nMaxHeight) {
+            // left behind by blocks which were written but are not connected (yet)
+            pcursor->Next();
+            continue;
+        }
+        bool fNewAddress = summary.IsNull() || indexKey.type != lastKey.type || indexKey.hashBytes != lastKey.hashBytes;
+        if (fNewAddress) {
+            writeSummary();
+            summary.SetNull();
+            summary.firstHeight = indexKey.blockHeight;
+        }
+        if (fNewAddress || indexKey.txhash != lastKey.txhash || indexKey.blockHeight != lastKey.blockHeight) {
+            summary.txCount++;
+        }
+        summary.balance += nValue;
+        if (nValue > 0) {
+            summary.received += nValue;
+        }
+        summary.lastHeight = indexKey.blockHeight;
+        lastKey = indexKey;
+
+        if (batch.SizeEstimate() > MAX_BATCH_SIZE) {
+            if (!WriteBatch(batch)) {
+                return false;
+            }
+            batch.Clear();
+        }
+        if (++nEntries % 1000000 == 0) {
+            LogPrintf("Building address summary index: %d address index entries, %d addresses done...\n", nEntries, nAddresses);
+        }
+        pcursor->Next();
+    }
+    writeSummary();
+    batch.Write(DB_ADDRESSSUMMARYBEST, hashBestBlock);
+
+    LogPrintf("Built address summary index for %d addresses from %d address index entries\n", nAddresses, nEntries);
+    return WriteBatch(batch, true);
+}
+
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
@@ -344,44 +586,156 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nThreads,
+                                      boost::function<void(size_t)> reserveBlockIndex)
 {
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    // Keys are (DB_BLOCK_INDEX, hash), so the first byte of the serialized hash splits the
+    // records into ranges of roughly equal size which can be read independently.
+    nThreads = std::max(1, std::min(nThreads, 256));
+
+    if (reserveBlockIndex) {
+        // only an estimate, the exact count would need another pass over the records
+        size_t nSize = EstimateSize(std::make_pair(DB_BLOCK_INDEX, uint256()), std::make_pair((char)(DB_BLOCK_INDEX + 1), uint256()));
+        reserveBlockIndex(nSize / BLOCK_INDEX_RECORD_SIZE_ESTIMATE);
+    }
+
+    // Decoded records are handed to the calling thread in batches. At most two batches per
+    // thread are queued, so the loaders never run far ahead of the insertion.
+    std::mutex cs;
+    std::condition_variable cvBatches;
+    std::condition_variable cvSpace;
+    std::deque<std::vector<CDiskBlockIndex>> queueBatches;
+    const size_t nMaxQueued = 2 * nThreads;
+    int nRunning = nThreads;
+    bool fStop = false;
+    std::vector<std::string> vErrors(nThreads);
+
+    auto pushBatch = [&](std::vector<CDiskBlockIndex>& batch) {
+        std::unique_lock<std::mutex> lock(cs);
+        cvSpace.wait(lock, [&]() { return fStop || queueBatches.size() < nMaxQueued; });
+        if (fStop) {
+            return false;
+        }
+        queueBatches.emplace_back(std::move(batch));
+        batch.clear();
+        cvBatches.notify_one();
+        return true;
+    };
+
+    auto loadRange = [&](int nPart) {
+        unsigned int nBegin = nPart * 256 / nThreads;
+        unsigned int nEnd = (nPart + 1) * 256 / nThreads;
+        const Consensus::Params& consensusParams = Params().GetConsensus();
+
+        // The pool's future swallows exceptions, so they are caught here: the calling thread
+        // waits for nRunning to drop to zero and must always be told that this loader is done.
+        std::string strError;
+        try {
+            std::unique_ptr<CDBIterator> pcursor(NewIterator());
+            uint256 seekHash;
+            *seekHash.begin() = (unsigned char)nBegin;
+            pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, seekHash));
+
+            std::vector<CDiskBlockIndex> batch;
+            batch.reserve(BLOCK_INDEX_LOAD_BATCH_SIZE);
+            while (pcursor->Valid()) {
+                std::pair<char, uint256> key;
+                if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX || *key.second.begin() >= nEnd) {
+                    break;
+                }
+                CDiskBlockIndex diskindex;
+                if (!pcursor->GetValue(diskindex)) {
+                    strError = "failed to read value";
+                    break;
+                }
+                if (!CheckProofOfWork(diskindex.GetBlockHash(), diskindex.nBits, consensusParams)) {
+                    // not ToString(), the record has no phashBlock
+                    strError = strprintf("CheckProofOfWork failed: block %s at height %d", diskindex.GetBlockHash().ToString(), diskindex.nHeight);
+                    break;
+                }
+                batch.emplace_back(std::move(diskindex));
+                if (batch.size() == BLOCK_INDEX_LOAD_BATCH_SIZE && !pushBatch(batch)) {
+                    break;
+                }
+                pcursor->Next();
+            }
+            if (strError.empty() && !batch.empty()) {
+                pushBatch(batch);
+            }
+        } catch (const std::exception& e) {
+            strError = strprintf("exception: %s", e.what());
+        } catch (...) {
+            strError = "unknown exception";
+        }
 
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
+        std::lock_guard<std::mutex> lock(cs);
+        if (!strError.empty()) {
+            vErrors[nPart] = strError;
+            fStop = true;
+            cvSpace.notify_all();
+        }
+        nRunning--;
+        cvBatches.notify_one();
+    };
+
+    auto stopLoaders = [&]() {
+        std::lock_guard<std::mutex> lock(cs);
+        fStop = true;
+        cvSpace.notify_all();
+    };
+
+    {
+        ctpl::thread_pool pool(nThreads);
+        RenameThreadPool(pool, "dash-loadidx");
+        for (int i = 0; i < nThreads; i++) {
+            pool.push([&loadRange, i](int) { loadRange(i); });
+        }
 
-    // Load mapBlockIndex
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight        = diskindex.nHeight;
-                pindexNew->nFile          = diskindex.nFile;
-                pindexNew->nDataPos       = diskindex.nDataPos;
-                pindexNew->nUndoPos       = diskindex.nUndoPos;
-                pindexNew->nVersion       = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime          = diskindex.nTime;
-                pindexNew->nBits          = diskindex.nBits;
-                pindexNew->nNonce         = diskindex.nNonce;
-                pindexNew->nStatus        = diskindex.nStatus;
-                pindexNew->nTx            = diskindex.nTx;
-
-                if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits, Params().GetConsensus()))
-                    return error("%s: CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
+        try {
+            while (true) {
+                std::vector<CDiskBlockIndex> batch;
+                {
+                    std::unique_lock<std::mutex> lock(cs);
+                    cvBatches.wait(lock, [&]() { return fStop || !queueBatches.empty() || nRunning == 0; });
+                    if (fStop || queueBatches.empty()) {
+                        break;
+                    }
+                    batch = std::move(queueBatches.front());
+                    queueBatches.pop_front();
+                    cvSpace.notify_one();
+                }
 
-                pcursor->Next();
-            } else {
-                return error("%s: failed to read value", __func__);
+                // Load mapBlockIndex
+                for (const CDiskBlockIndex& diskindex : batch) {
+                    boost::this_thread::interruption_point();
+
+                    // Construct block index object
+                    CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
+                    pindexNew->pprev          = insertBlockIndex(diskindex.hashPrev);
+                    pindexNew->nHeight        = diskindex.nHeight;
+                    pindexNew->nFile          = diskindex.nFile;
+                    pindexNew->nDataPos       = diskindex.nDataPos;
+                    pindexNew->nUndoPos       = diskindex.nUndoPos;
+                    pindexNew->nVersion       = diskindex.nVersion;
+                    pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+                    pindexNew->nTime          = diskindex.nTime;
+                    pindexNew->nBits          = diskindex.nBits;
+                    pindexNew->nNonce         = diskindex.nNonce;
+                    pindexNew->nStatus        = diskindex.nStatus;
+                    pindexNew->nTx            = diskindex.nTx;
+                }
             }
-        } else {
-            break;
+        } catch (...) {
+            // let the loaders finish before the pool joins them, e.g. when interrupted
+            stopLoaders();
+            throw;
         }
+        stopLoaders();
+    }
+
+    for (const auto& strError : vErrors) {
+        if (!strError.empty())
+            return error("%s: %s", __func__, strError);
     }
 
     return true;
@@ -11,6 +11,7 @@
 #include "chain.h"
 #include "spentindex.h"
 
+#include <functional>
 #include <map>
 #include <string>
 #include <utility>
@@ -40,6 +41,10 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Number of block index records a loader thread decodes before handing them on
+static const size_t BLOCK_INDEX_LOAD_BATCH_SIZE = 1024;
+//! Approximate size of a block index record on disk, to estimate their number
+static const size_t BLOCK_INDEX_RECORD_SIZE_ESTIMATE = 150;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -129,16 +134,52 @@ public:
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+    /**
+     * Call func for the unspent outputs of an address in key order until it returns false.
+     * If pStartAfter is set, iteration resumes right after that key.
+     */
+    bool ForEachAddressUnspent(uint160 addressHash, int type, const CAddressUnspentKey* pStartAfter,
+                               const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& func);
     bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    /**
+     * Call func for the address index entries of an address (by height and position in the block)
+     * until it returns false. Entries are limited to the heights start..end where those are positive.
+     * If pStartAfter is set, iteration resumes right after that key instead of at start.
+     */
+    bool ForEachAddressIndex(uint160 addressHash, int type, int start, int end, const CAddressIndexKey* pStartAfter,
+                             const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func);
+    bool ReadAddressSummary(uint160 addressHash, int type, CAddressSummary &summary);
+    /** Read the block the address summaries are up to date with, returns false if there is none */
+    bool ReadAddressSummaryBestBlock(uint256 &hashBestBlock);
+    /** Forget the block the address summaries belong to, so they are rebuilt on the next start */
+    bool EraseAddressSummaryBestBlock();
+    /**
+     * Apply (or undo) the address index entries of the block at nHeight to the address summaries and
+     * record hashBestBlock (the block, or its parent when undoing) in the same batch
+     */
+    bool UpdateAddressSummaryIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, int nHeight, bool fDisconnect, const uint256 &hashBestBlock);
+    /** (Re)build all address summaries from the address index entries up to nMaxHeight, which are those of hashBestBlock */
+    bool BuildAddressSummaryIndex(int nMaxHeight, const uint256 &hashBestBlock);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
-    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /**
+     * Load all block index records. The records are read and their proof of work
+     * is checked on nThreads threads, each iterating over its own range of block
+     * hashes. They are passed on in bounded batches to the calling thread, which
+     * is the only one calling insertBlockIndex. reserveBlockIndex (if set) is told
+     * an estimate of the number of records first.
+     */
+    bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nThreads = 1,
+                            boost::function<void(size_t)> reserveBlockIndex = boost::function<void(size_t)>());
+private:
+    /** Find the height of the last address index entry of an address below nBeforeHeight */
+    bool FindLastAddressIndexHeight(uint160 addressHash, int type, int nBeforeHeight, int &nHeightRet);
 };
 
 #endif // BITCOIN_TXDB_H
@@ -14,6 +14,7 @@
 #include "chainparamsbase.h"
 #include "ctpl.h"
 #include "fs.h"
+#include "mpmcqueue.h"
 #include "random.h"
 #include "serialize.h"
 #include "stacktraces.h"
@@ -42,6 +43,7 @@
 #endif // __linux__
 
 #include <algorithm>
+#include <condition_variable>
 #include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
@@ -415,23 +417,15 @@ static std::string LogThreadNameStr(const std::string &str, std::atomic_bool *fS
     return strThreadLogged;
 }
 
-int LogPrintStr(const std::string &str)
+/** Write a log message, or a batch of them, to the console or debug.log */
+static int LogWriteStr(const std::string &str)
 {
     int ret = 0; // Returns total number of characters written
-    static std::atomic_bool fStartedNewLine(true);
-
-    std::string strThreadLogged = LogThreadNameStr(str, &fStartedNewLine);
-    std::string strTimestamped = LogTimestampStr(strThreadLogged, &fStartedNewLine);
-
-    if (!str.empty() && str[str.size()-1] == '\n')
-        fStartedNewLine = true;
-    else
-        fStartedNewLine = false;
 
     if (fPrintToConsole)
     {
         // print to console
-        ret = fwrite(strTimestamped.data(), 1, strTimestamped.size(), stdout);
+        ret = fwrite(str.data(), 1, str.size(), stdout);
         fflush(stdout);
     }
     else if (fPrintToDebugLog)
@@ -442,8 +436,8 @@ int LogPrintStr(const std::string &str)
         // buffer if we haven't opened the log yet
         if (fileout == NULL) {
             assert(vMsgsBeforeOpenLog);
-            ret = strTimestamped.length();
-            vMsgsBeforeOpenLog->push_back(strTimestamped);
+            ret = str.length();
+            vMsgsBeforeOpenLog->push_back(str);
         }
         else
         {
@@ -455,12 +449,207 @@ int LogPrintStr(const std::string &str)
                     setbuf(fileout, NULL); // unbuffered
             }
 
-            ret = FileWriteStr(strTimestamped, fileout);
+            ret = FileWriteStr(str, fileout);
         }
     }
     return ret;
 }
 
+/**
+ * State of the asynchronous log writer, see StartAsyncLogging.
+ *
+ * Like fileout and mutexDebugLog, the buffer and the mutex are leaked on exit,
+ * so logging from global destructors keeps working.
+ */
+static std::atomic<bool> fLogAsync(false);
+static std::atomic<int> nLogProducers(0);
+static std::atomic<uint64_t> nLogDropped(0);
+static bool fLogDropOnOverflow = false;
+static CMPMCQueue<std::string>* logBuffer = nullptr;
+static std::mutex* mutexLogWriter = nullptr;
+static std::condition_variable* condLogWriter = nullptr;
+static std::atomic<bool> fLogWriterSleeping(false);
+static std::atomic<bool> fStopLogWriter(false);
+static std::atomic<bool> fLogWriterRunning(false);
+static std::thread threadLogWriter;
+static std::thread::id idLogWriter;
+
+/** Maximum size of a single write of the writer thread */
+static const size_t MAX_LOG_BATCH_SIZE = 1024 * 1024;
+
+static void WakeLogWriter()
+{
+    // pairs with the fence in ThreadLogWriter: either the writer sees the new message
+    // before going to sleep, or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (fLogWriterSleeping) {
+        std::lock_guard<std::mutex> lock(*mutexLogWriter);
+        condLogWriter->notify_one();
+    }
+}
+
+/** Report messages dropped since the last call, if any */
+static void AppendLogDropped(std::string& strBatch)
+{
+    uint64_t nDropped = nLogDropped.exchange(0);
+    if (nDropped != 0) {
+        std::atomic_bool fStartedNewLine(true);
+        strBatch += LogTimestampStr(strprintf("%d log messages were dropped because the log buffer was full\n", nDropped), &fStartedNewLine);
+    }
+}
+
+static void ThreadLogWriter()
+{
+    RenameThread("dash-logger");
+
+    std::string strBatch;
+    std::string str;
+    while (true) {
+        while (strBatch.size() < MAX_LOG_BATCH_SIZE && logBuffer->Pop(str)) {
+            strBatch += str;
+        }
+        AppendLogDropped(strBatch);
+        if (!strBatch.empty()) {
+            LogWriteStr(strBatch);
+            strBatch.clear();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(*mutexLogWriter);
+        if (fStopLogWriter && logBuffer->SizeApprox() == 0)
+            break;
+        fLogWriterSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (logBuffer->SizeApprox() == 0 && !fStopLogWriter)
+            condLogWriter->wait_for(lock, std::chrono::milliseconds(100));
+        fLogWriterSleeping = false;
+    }
+    fLogWriterRunning = false;
+}
+
+void StartAsyncLogging(size_t nBufferSize, bool fDropOnOverflow)
+{
+    assert(!fLogAsync && !threadLogWriter.joinable());
+    if (!logBuffer) {
+        mutexLogWriter = new std::mutex();
+        condLogWriter = new std::condition_variable();
+        // a std::thread which is still joinable when the process exits calls std::terminate,
+        // so join the writer on exit() too. Handlers run before the destructors of statics
+        // which were constructed earlier, like the ones used for writing to debug.log.
+        std::atexit(StopAsyncLogging);
+    }
+    // a writer left behind by AbortAsyncLogging exits by itself once it sees fStopLogWriter
+    while (fLogWriterRunning) {
+        std::this_thread::yield();
+    }
+    delete logBuffer;
+    logBuffer = new CMPMCQueue<std::string>(std::max(nBufferSize, (size_t)1));
+    fLogDropOnOverflow = fDropOnOverflow;
+    fStopLogWriter = false;
+    fLogWriterRunning = true;
+    threadLogWriter = std::thread(ThreadLogWriter);
+    // set before fLogAsync, so LogPushStr sees it once it sees fLogAsync
+    idLogWriter = threadLogWriter.get_id();
+    fLogAsync = true;
+}
+
+void StopAsyncLogging()
+{
+    if (!fLogAsync.exchange(false))
+        return;
+    // messages which are being added right now still go through the buffer
+    while (nLogProducers != 0) {
+        std::this_thread::yield();
+    }
+    {
+        std::lock_guard<std::mutex> lock(*mutexLogWriter);
+        fStopLogWriter = true;
+        condLogWriter->notify_one();
+    }
+    threadLogWriter.join();
+}
+
+void AbortAsyncLogging()
+{
+    if (!fLogAsync.exchange(false))
+        return;
+
+    // The writer thread may be the one which crashed, or may never be scheduled again before
+    // the process dies. Don't wait for it, tell it to stop and write the buffer from here.
+    fStopLogWriter = true;
+    if (mutexLogWriter->try_lock()) {
+        condLogWriter->notify_one();
+        mutexLogWriter->unlock();
+    }
+    bool fInWriter = idLogWriter == std::this_thread::get_id();
+    if (threadLogWriter.joinable())
+        threadLogWriter.detach();
+
+    // Messages which are being added right now still go through the buffer, and the writer
+    // may be writing a batch it already took. Give them a moment, but don't hang if one of
+    // them is the crashing thread.
+    int64_t nDeadline = GetTimeMillis() + 1000;
+    std::string str;
+    do {
+        while (logBuffer->Pop(str)) {
+            LogWriteStr(str);
+        }
+        std::this_thread::yield();
+    } while ((nLogProducers != 0 || (!fInWriter && fLogWriterRunning)) && GetTimeMillis() < nDeadline);
+    while (logBuffer->Pop(str)) {
+        LogWriteStr(str);
+    }
+    str.clear();
+    AppendLogDropped(str);
+    if (!str.empty())
+        LogWriteStr(str);
+}
+
+/** Hand the message over to the writer thread, returns false if asynchronous logging is off.
+ * str is moved into the buffer unless it's dropped */
+static bool LogPushStr(std::string& str)
+{
+    nLogProducers++;
+    // the writer thread logs too, e.g. in RenameThread. It must not wait for room in the
+    // buffer only it can make.
+    if (!fLogAsync || std::this_thread::get_id() == idLogWriter) {
+        nLogProducers--;
+        return false;
+    }
+    while (!logBuffer->Push(std::move(str))) {
+        if (fLogDropOnOverflow) {
+            nLogDropped++;
+            break;
+        }
+        WakeLogWriter();
+        std::this_thread::yield();
+    }
+    WakeLogWriter();
+    nLogProducers--;
+    return true;
+}
+
+int LogPrintStr(const std::string &str)
+{
+    static std::atomic_bool fStartedNewLine(true);
+
+    std::string strThreadLogged = LogThreadNameStr(str, &fStartedNewLine);
+    std::string strTimestamped = LogTimestampStr(strThreadLogged, &fStartedNewLine);
+
+    if (!str.empty() && str[str.size()-1] == '\n')
+        fStartedNewLine = true;
+    else
+        fStartedNewLine = false;
+
+    if (!fPrintToConsole && !fPrintToDebugLog)
+        return 0;
+
+    int ret = strTimestamped.size();
+    if (LogPushStr(strTimestamped))
+        return ret;
+    return LogWriteStr(strTimestamped);
+}
+
 /** Interpret string as boolean, for argument parsing */
 static bool InterpretBool(const std::string& strValue)
 {
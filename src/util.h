@@ -53,6 +53,10 @@ static const bool DEFAULT_LOGTIMEMICROS  = false;
 static const bool DEFAULT_LOGIPS         = false;
 static const bool DEFAULT_LOGTIMESTAMPS  = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
+static const bool DEFAULT_LOGASYNC       = true;
+/** Default for -logbuffersize, number of log messages waiting for the writer thread */
+static const int DEFAULT_LOGBUFFERSIZE   = 16384;
+static const char * const DEFAULT_LOGOVERFLOW = "block";
 
 /** Signals for translation. */
 class CTranslationInterface
@@ -151,6 +155,22 @@ bool GetLogCategory(uint64_t *f, const std::string *str);
 /** Send a string to the log output */
 int LogPrintStr(const std::string &str);
 
+/**
+ * Write log messages from a background thread. Logging threads only put their messages into a
+ * lock-free buffer of nBufferSize messages, which the writer thread writes out in batches.
+ * If the buffer is full, messages are dropped and counted if fDropOnOverflow is set, otherwise
+ * the logging thread waits for room.
+ */
+void StartAsyncLogging(size_t nBufferSize, bool fDropOnOverflow);
+/** Write all buffered messages and go back to writing them from the logging threads */
+void StopAsyncLogging();
+/**
+ * Like StopAsyncLogging, but write the buffered messages from the calling thread without waiting
+ * for the writer thread. For crash handlers, so that the crash report and the messages before it
+ * make it into debug.log.
+ */
+void AbortAsyncLogging();
+
 /** Formats a string without throwing exceptions. Instead, it'll return an error string instead of formatted string. */
 template<typename... Args>
 std::string SafeStringFormat(const std::string& fmt, const Args&... args)
@@ -12,6 +12,7 @@
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
+#include "ctpl.h"
 #include "consensus/consensus.h"
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
@@ -23,6 +24,7 @@
 #include "pow.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
+#include "saltedhasher.h"
 #include "script/script.h"
 #include "script/sigcache.h"
 #include "script/standard.h"
@@ -56,6 +58,8 @@
 
 #include <atomic>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -83,6 +87,7 @@ std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = true;
 bool fAddressIndex = false;
+bool fAddressSummaryIndex = false;
 bool fTimestampIndex = false;
 bool fSpentIndex = false;
 bool fHavePruned = false;
@@ -109,6 +114,8 @@ CBlockPolicyEstimator feeEstimator;
 CTxMemPool mempool(&feeEstimator);
 std::map<uint256, int64_t> mapRejectedBlocks GUARDED_BY(cs_main);
 
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
 static void CheckBlockIndex(const Consensus::Params& consensusParams);
 
 /** Constant stuff for coinbase transactions we create: */
@@ -632,7 +639,7 @@ static bool IsCurrentForFeeEstimation()
 
 bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const CTransactionRef& ptx, bool fLimitFree,
                               bool* pfMissingInputs, int64_t nAcceptTime, bool fOverrideMempoolLimit,
-                              const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache, bool fDryRun)
+                              const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache, bool fDryRun, bool fScriptsVerified)
 {
     const CTransaction& tx = *ptx;
     const uint256 hash = tx.GetHash();
@@ -886,7 +893,9 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
         // Check against previous transactions
         // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-        if (!CheckInputs(tx, state, view, true, STANDARD_SCRIPT_VERIFY_FLAGS, true))
+        // Scripts which AcceptToMemoryPoolMany already verified against the standard flags are skipped,
+        // the input amounts are still checked.
+        if (!CheckInputs(tx, state, view, !fScriptsVerified, STANDARD_SCRIPT_VERIFY_FLAGS, true))
             return false; // state filled in by CheckInputs
 
         // Check again against just the consensus-critical mandatory script
@@ -898,7 +907,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
         // There is a similar check in CreateNewBlock() to prevent creating
         // invalid blocks, however allowing such transactions into the mempool
         // can be exploited as a DoS attack.
-        if (!CheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true))
+        if (!fScriptsVerified && !CheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true))
         {
             return error("%s: BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s, %s",
                 __func__, hash.ToString(), FormatStateMessage(state));
@@ -938,10 +947,10 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
 bool AcceptToMemoryPoolWithTime(CTxMemPool& pool, CValidationState &state, const CTransactionRef &tx, bool fLimitFree,
                         bool* pfMissingInputs, int64_t nAcceptTime, bool fOverrideMempoolLimit,
-                        const CAmount nAbsurdFee, bool fDryRun)
+                        const CAmount nAbsurdFee, bool fDryRun, bool fScriptsVerified)
 {
     std::vector<COutPoint> coins_to_uncache;
-    bool res = AcceptToMemoryPoolWorker(pool, state, tx, fLimitFree, pfMissingInputs, nAcceptTime, fOverrideMempoolLimit, nAbsurdFee, coins_to_uncache, fDryRun);
+    bool res = AcceptToMemoryPoolWorker(pool, state, tx, fLimitFree, pfMissingInputs, nAcceptTime, fOverrideMempoolLimit, nAbsurdFee, coins_to_uncache, fDryRun, fScriptsVerified);
     if (!res || fDryRun) {
         if(!res) LogPrint(BCLog::MEMPOOL, "%s: %s %s (%s)\n", __func__, tx->GetHash().ToString(), state.GetRejectReason(), state.GetDebugMessage());
         BOOST_FOREACH(const COutPoint& hashTx, coins_to_uncache)
@@ -959,6 +968,217 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
     return AcceptToMemoryPoolWithTime(pool, state, tx, fLimitFree, pfMissingInputs, GetTime(), fOverrideMempoolLimit, nAbsurdFee, fDryRun);
 }
 
+void GetBatchScriptChecks(const std::vector<CTransactionRef>& vtx, CCoinsViewCache& view, unsigned int flags, bool cacheStore,
+                          std::vector<CScriptCheck>& vChecks)
+{
+    for (const auto& tx : vtx) {
+        if (tx->IsCoinBase() || !view.HaveInputs(*tx)) {
+            // let AcceptToMemoryPool figure out what's wrong
+            continue;
+        }
+        for (unsigned int i = 0; i < tx->vin.size(); i++) {
+            const Coin& coin = view.AccessCoin(tx->vin[i].prevout);
+            vChecks.emplace_back(coin.out.scriptPubKey, coin.out.nValue, *tx, i, flags, cacheStore);
+        }
+        AddCoins(view, *tx, MEMPOOL_HEIGHT);
+    }
+}
+
+bool RunScriptChecks(std::vector<CScriptCheck>& vChecks, CCheckQueue<CScriptCheck>* pqueue)
+{
+    if (pqueue == NULL) {
+        bool fOk = true;
+        for (auto& check : vChecks) {
+            fOk &= check();
+        }
+        return fOk;
+    }
+    CCheckQueueControl<CScriptCheck> control(pqueue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
+CCheckQueue<CScriptCheck>* GetScriptCheckQueue()
+{
+    return nScriptCheckThreads ? &scriptcheckqueue : NULL;
+}
+
+/** Returns the indexes of vtx ordered so that transactions come after their in-batch parents, which are returned in vParents */
+static std::vector<size_t> SortTransactionsByDependency(const std::vector<CTransactionRef>& vtx, std::vector<std::vector<size_t> >& vParents)
+{
+    std::unordered_map<uint256, size_t, StaticSaltedHasher> mapIndex;
+    for (size_t i = 0; i < vtx.size(); i++) {
+        mapIndex.emplace(vtx[i]->GetHash(), i);
+    }
+
+    std::vector<size_t> vParentCount(vtx.size(), 0);
+    std::vector<std::vector<size_t> > vChildren(vtx.size());
+    vParents.assign(vtx.size(), std::vector<size_t>());
+    for (size_t i = 0; i < vtx.size(); i++) {
+        std::set<size_t> setParents;
+        for (const auto& in : vtx[i]->vin) {
+            auto it = mapIndex.find(in.prevout.hash);
+            if (it != mapIndex.end() && it->second != i && setParents.emplace(it->second).second) {
+                vChildren[it->second].emplace_back(i);
+                vParents[i].emplace_back(it->second);
+                vParentCount[i]++;
+            }
+        }
+    }
+
+    std::vector<size_t> vOrder;
+    vOrder.reserve(vtx.size());
+    for (size_t i = 0; i < vtx.size(); i++) {
+        if (vParentCount[i] == 0) {
+            vOrder.emplace_back(i);
+        }
+    }
+    for (size_t j = 0; j < vOrder.size(); j++) {
+        for (size_t child : vChildren[vOrder[j]]) {
+            if (--vParentCount[child] == 0) {
+                vOrder.emplace_back(child);
+            }
+        }
+    }
+    return vOrder;
+}
+
+size_t AcceptToMemoryPoolMany(CTxMemPool& pool, std::vector<CValidationState>& vState, const std::vector<CTransactionRef>& vtx, bool fLimitFree,
+                              std::vector<bool>& vAccepted, std::vector<bool>* pvMissingInputs, const std::vector<int64_t>* pvAcceptTime,
+                              bool fOverrideMempoolLimit, const CAmount nAbsurdFee)
+{
+    vState.assign(vtx.size(), CValidationState());
+    vAccepted.assign(vtx.size(), false);
+    if (pvMissingInputs) {
+        pvMissingInputs->assign(vtx.size(), false);
+    }
+    if (vtx.empty()) {
+        return 0;
+    }
+
+    int64_t nTimeStart = GetTimeMicros();
+    std::vector<std::vector<size_t> > vParents;
+    std::vector<size_t> vRound = SortTransactionsByDependency(vtx, vParents);
+
+    // Transactions whose outcome is not known yet. Transactions which can't pass the cheap checks
+    // because one of their in-batch parents is not in the mempool yet are retried in the next round.
+    std::vector<bool> vPending(vtx.size(), false);
+    for (size_t i : vRound) {
+        vPending[i] = true;
+    }
+
+    // Inputs which were not cached before and are only needed by rejected transactions get uncached
+    // at the end, just like AcceptToMemoryPool does
+    std::vector<std::vector<COutPoint> > vCoinsToUncache(vtx.size());
+
+    size_t nAccepted = 0;
+    size_t nChecks = 0;
+    int64_t nTimeChecks = 0;
+    int nRounds = 0;
+    while (!vRound.empty()) {
+        nRounds++;
+        std::vector<size_t> vBatch;
+        std::vector<size_t> vDeferred;
+        std::vector<CScriptCheck> vChecks;
+        // range of vChecks of each transaction
+        std::vector<std::pair<size_t, size_t> > vCheckRange(vtx.size());
+        // signature cache entries collected by each check, only stored for accepted transactions
+        std::vector<std::vector<uint256> > vSigCacheEntries;
+        {
+            LOCK(cs_main);
+
+            // Run all checks except for the scripts first, so that nothing is verified for transactions
+            // which are non-standard, pay too little fee or miss inputs
+            for (size_t i : vRound) {
+                CValidationState state;
+                bool fMissingInputs = false;
+                if (AcceptToMemoryPoolWithTime(pool, state, vtx[i], fLimitFree, &fMissingInputs, GetTime(), fOverrideMempoolLimit, nAbsurdFee, true)) {
+                    vBatch.emplace_back(i);
+                    continue;
+                }
+                bool fParentPending = false;
+                for (size_t j : vParents[i]) {
+                    fParentPending |= vPending[j];
+                }
+                if (fMissingInputs && fParentPending) {
+                    vDeferred.emplace_back(i);
+                    continue;
+                }
+                vState[i] = state;
+                if (pvMissingInputs) {
+                    (*pvMissingInputs)[i] = fMissingInputs;
+                }
+                vPending[i] = false;
+            }
+
+            if (nScriptCheckThreads && !vBatch.empty()) {
+                size_t nInputs = 0;
+                for (size_t i : vBatch) {
+                    nInputs += vtx[i]->vin.size();
+                }
+                // the checks point into vSigCacheEntries, so it must not be resized later on
+                vSigCacheEntries.resize(nInputs);
+                vChecks.reserve(nInputs);
+
+                LOCK(pool.cs);
+                CCoinsView dummy;
+                CCoinsViewCache view(&dummy);
+                CCoinsViewMemPool viewMemPool(pcoinsTip, pool);
+                view.SetBackend(viewMemPool);
+                for (size_t i : vBatch) {
+                    vCheckRange[i].first = vChecks.size();
+                    for (unsigned int j = 0; j < vtx[i]->vin.size(); j++) {
+                        const COutPoint& prevout = vtx[i]->vin[j].prevout;
+                        if (!pcoinsTip->HaveCoinInCache(prevout)) {
+                            vCoinsToUncache[i].emplace_back(prevout);
+                        }
+                        const Coin& coin = view.AccessCoin(prevout);
+                        vChecks.emplace_back(coin.out.scriptPubKey, coin.out.nValue, *vtx[i], j, STANDARD_SCRIPT_VERIFY_FLAGS, false, &vSigCacheEntries[vChecks.size()]);
+                    }
+                    vCheckRange[i].second = vChecks.size();
+                }
+                view.SetBackend(dummy);
+            }
+        }
+
+        // cs_main is not required here, but callers might still hold it. If any check fails, every
+        // transaction of the batch has its scripts verified by AcceptToMemoryPool again to find out which.
+        int64_t nTimeChecksStart = GetTimeMicros();
+        bool fScriptsVerified = !vChecks.empty() && RunScriptChecks(vChecks, &scriptcheckqueue);
+        nTimeChecks += GetTimeMicros() - nTimeChecksStart;
+        nChecks += vChecks.size();
+
+        for (size_t i : vBatch) {
+            bool fMissingInputs = false;
+            LOCK(cs_main);
+            int64_t nAcceptTime = pvAcceptTime ? (*pvAcceptTime)[i] : GetTime();
+            if (AcceptToMemoryPoolWithTime(pool, vState[i], vtx[i], fLimitFree, &fMissingInputs, nAcceptTime, fOverrideMempoolLimit, nAbsurdFee, false, fScriptsVerified)) {
+                vAccepted[i] = true;
+                nAccepted++;
+                if (fScriptsVerified) {
+                    for (size_t j = vCheckRange[i].first; j < vCheckRange[i].second; j++) {
+                        AddSignatureCacheEntries(vSigCacheEntries[j]);
+                    }
+                }
+            } else {
+                for (const auto& outpoint : vCoinsToUncache[i]) {
+                    pcoinsTip->Uncache(outpoint);
+                }
+            }
+            if (pvMissingInputs) {
+                (*pvMissingInputs)[i] = fMissingInputs;
+            }
+            vPending[i] = false;
+        }
+
+        vRound = std::move(vDeferred);
+    }
+
+    LogPrint(BCLog::MEMPOOL, "%s: accepted %u of %u transactions in %d rounds, %u script checks: %.2fms, total: %.2fms\n", __func__,
+        nAccepted, vtx.size(), nRounds, nChecks, 0.001 * nTimeChecks, 0.001 * (GetTimeMicros() - nTimeStart));
+    return nAccepted;
+}
+
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes)
 {
     if (!fTimestampIndex)
@@ -996,6 +1216,130 @@ bool GetAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool ForEachAddressIndex(uint160 addressHash, int type, int start, int end, const CAddressIndexKey* pStartAfter,
+                         const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ForEachAddressIndex(addressHash, type, start, end, pStartAfter, func))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool ForEachAddressUnspent(uint160 addressHash, int type, const CAddressUnspentKey* pStartAfter,
+                           const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& func)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ForEachAddressUnspent(addressHash, type, pStartAfter, func))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool GetAddressSummary(uint160 addressHash, int type, CAddressSummary &summary)
+{
+    if (!fAddressSummaryIndex)
+        return error("address summary index not enabled");
+
+    if (!pblocktree->ReadAddressSummary(addressHash, type, summary))
+        return error("unable to get summary for address");
+
+    return true;
+}
+
+/** Build the address summaries of the chain ending at pindex from the address index */
+static bool RebuildAddressSummaryIndex(const CBlockIndex* pindex)
+{
+    // Summaries are only built from the address index, the block files are not touched
+    LogPrintf("Building address summary index from the address index, this may take a while...\n");
+    return pblocktree->BuildAddressSummaryIndex(pindex ? pindex->nHeight : -1, pindex ? pindex->GetBlockHash() : uint256());
+}
+
+static const CBlockIndex* GetAddressSummaryBestBlock()
+{
+    uint256 hashBestBlock;
+    if (!pblocktree->ReadAddressSummaryBestBlock(hashBestBlock))
+        return NULL;
+    BlockMap::const_iterator it = mapBlockIndex.find(hashBestBlock);
+    return it == mapBlockIndex.end() ? NULL : it->second;
+}
+
+/**
+ * Apply (or undo) the address index entries of a connected (or disconnected) block to the address summaries.
+ * Unlike the address index, these are increments, so a block must be applied exactly once: blocks which are
+ * connected or disconnected again after an unclean shutdown (the chainstate is flushed later than the block
+ * tree) are skipped. Summaries which don't belong to the parent (or the block) at all are never rebuilt here,
+ * under cs_main in the middle of block processing: they are marked for a rebuild by ReconcileAddressSummaryIndex
+ * on the next start and the update fails, which aborts the node.
+ */
+static bool UpdateAddressSummaryIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex, const CBlockIndex* pindex, bool fDisconnect)
+{
+    AssertLockHeld(cs_main);
+
+    const CBlockIndex* pindexBest = GetAddressSummaryBestBlock();
+    const CBlockIndex* pindexNew = fDisconnect ? pindex->pprev : pindex;
+    const CBlockIndex* pindexExpected = fDisconnect ? pindex : pindex->pprev;
+
+    if (pindexBest != pindexExpected) {
+        bool fDone = pindexBest && (fDisconnect ? pindexNew->GetAncestor(pindexBest->nHeight) == pindexBest
+                                                : pindexBest->GetAncestor(pindexNew->nHeight) == pindexNew);
+        if (fDone) {
+            LogPrintf("%s: address summaries at block %s already include %s of block %s, skipping\n", __func__,
+                pindexBest->GetBlockHash().ToString(), fDisconnect ? "the undo" : "the connect", pindex->GetBlockHash().ToString());
+            return true;
+        }
+        LogPrintf("%s: Warning: address summaries are at block %s instead of %s, they will be rebuilt on the next start\n", __func__,
+            pindexBest ? pindexBest->GetBlockHash().ToString() : "(none)", pindexExpected->GetBlockHash().ToString());
+        pblocktree->EraseAddressSummaryBestBlock();
+        return false;
+    }
+
+    return pblocktree->UpdateAddressSummaryIndex(addressIndex, pindex->nHeight, fDisconnect, pindexNew->GetBlockHash());
+}
+
+/** Make sure the address summaries belong to the chain tip, e.g. after an unclean shutdown */
+static bool ReconcileAddressSummaryIndex()
+{
+    const CBlockIndex* pindexTip = chainActive.Tip();
+    if (!pindexTip)
+        return true;
+
+    // Summaries ahead of the tip on the same chain are fine, those blocks are skipped when they are connected again
+    const CBlockIndex* pindexBest = GetAddressSummaryBestBlock();
+    if (pindexBest && pindexBest->GetAncestor(pindexTip->nHeight) == pindexTip)
+        return true;
+
+    LogPrintf("%s: address summaries are at block %s, chain tip is %s\n", __func__,
+        pindexBest ? pindexBest->GetBlockHash().ToString() : "(none)", pindexTip->GetBlockHash().ToString());
+    return RebuildAddressSummaryIndex(pindexTip);
+}
+
+bool SetAddressSummaryIndex(bool fEnable)
+{
+    LOCK(cs_main);
+
+    if (fEnable == fAddressSummaryIndex) {
+        if (fEnable && !ReconcileAddressSummaryIndex())
+            return error("%s: failed to rebuild the address summary index", __func__);
+        return true;
+    }
+
+    if (fEnable) {
+        if (!fAddressIndex)
+            return error("%s: the address summary index requires the address index", __func__);
+
+        if (!RebuildAddressSummaryIndex(chainActive.Tip()))
+            return error("%s: failed to build the address summary index", __func__);
+    }
+
+    fAddressSummaryIndex = fEnable;
+    return pblocktree->WriteFlag("addresssummaryindex", fAddressSummaryIndex);
+}
+
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
@@ -1385,7 +1729,7 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight)
 
 bool CScriptCheck::operator()() {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore), &error)) {
+    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore, pvSigCacheEntries), &error)) {
         return false;
     }
     return true;
@@ -1624,8 +1968,10 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 }
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
- *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state. */
-static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view)
+ *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state.
+ *  The address, address summary and address unspent indexes are only updated if fUpdateIndexes is set,
+ *  which must not be done for views which are thrown away (e.g. in VerifyDB). */
+static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view, bool fUpdateIndexes)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
 
@@ -1762,8 +2108,12 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
 
                     } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
                         uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
+
+                        // undo spending activity
+                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
+
+                        // restore unspent index
+                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
                     } else {
                         continue;
                     }
@@ -1777,11 +2127,15 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
-    if (fAddressIndex) {
+    if (fAddressIndex && fUpdateIndexes) {
         if (!pblocktree->EraseAddressIndex(addressIndex)) {
             AbortNode(state, "Failed to delete address index");
             return DISCONNECT_FAILED;
         }
+        if (fAddressSummaryIndex && !UpdateAddressSummaryIndex(addressIndex, pindex, true)) {
+            AbortNode(state, "Failed to update address summary index");
+            return DISCONNECT_FAILED;
+        }
         if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             AbortNode(state, "Failed to write address unspent index");
             return DISCONNECT_FAILED;
@@ -1822,13 +2176,166 @@ void static FlushBlockFile(bool fFinalize = false)
 
 bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
-
 void ThreadScriptCheck() {
     RenameThread("dash-scriptch");
     scriptcheckqueue.Thread();
 }
 
+/**
+ * Header hashing threads: X11 hashes of large header batches are split across these,
+ * before ProcessNewBlockHeaders takes cs_main.
+ */
+static ctpl::thread_pool headerHashPool;
+/** Smallest number of headers per thread worth handing off to the pool */
+static const size_t MIN_HEADERS_PER_HASH_THREAD = 64;
+
+void StartHeaderHashThreads(int nThreads)
+{
+    if (nThreads <= 0)
+        return;
+    headerHashPool.resize(nThreads);
+    RenameThreadPool(headerHashPool, "dash-hdrhash");
+}
+
+void StopHeaderHashThreads()
+{
+    headerHashPool.stop(true);
+}
+
+std::vector<uint256> HashBlockHeaders(const std::vector<CBlockHeader>& headers)
+{
+    std::vector<uint256> vHashes(headers.size());
+    size_t nThreads = std::min<size_t>(headerHashPool.size(), headers.size() / MIN_HEADERS_PER_HASH_THREAD);
+    if (nThreads <= 1) {
+        CBlockHeader::GetHashes(headers.data(), headers.size(), vHashes.data());
+        return vHashes;
+    }
+
+    size_t nPerThread = (headers.size() + nThreads - 1) / nThreads;
+    std::vector<std::future<void>> vFutures;
+    for (size_t nBegin = 0; nBegin < headers.size(); nBegin += nPerThread) {
+        size_t nCount = std::min(nPerThread, headers.size() - nBegin);
+        vFutures.emplace_back(headerHashPool.push([&headers, &vHashes, nBegin, nCount](int) {
+            CBlockHeader::GetHashes(&headers[nBegin], nCount, &vHashes[nBegin]);
+        }));
+    }
+    for (auto& f : vFutures) {
+        f.get();
+    }
+    return vHashes;
+}
+
+/**
+ * Input prefetcher: reads the coins spent by a block from the coins database
+ * in parallel and inserts them into pcoinsTip before ConnectBlock runs, so the
+ * serial input loop in ConnectBlock mostly hits the cache instead of LevelDB.
+ */
+static ctpl::thread_pool inputPrefetchPool;
+static std::atomic<bool> fInputPrefetchEnabled(false);
+static uint64_t nPrefetchInputs = 0;
+static uint64_t nPrefetchCacheHits = 0;
+static uint64_t nPrefetchFetched = 0;
+
+void StartInputPrefetch(int nThreads)
+{
+    if (nThreads <= 0)
+        return;
+    inputPrefetchPool.resize(nThreads);
+    RenameThreadPool(inputPrefetchPool, "dash-prefetch");
+    fInputPrefetchEnabled = true;
+}
+
+void StopInputPrefetch()
+{
+    fInputPrefetchEnabled = false;
+    inputPrefetchPool.stop(true);
+}
+
+/**
+ * Load all inputs of block which are neither created inside the block itself
+ * nor already cached into pcoinsTip. Must be called with cs_main held, which
+ * guarantees that pcoinsdbview can't be flushed to while we read from it and
+ * thus that the fetched coins are not stale.
+ */
+static void PrefetchBlockInputs(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    if (!fInputPrefetchEnabled || block.vtx.size() <= 1)
+        return;
+
+    int64_t nTimeStart = GetTimeMicros();
+
+    std::unordered_set<uint256, StaticSaltedHasher> setBlockTxids;
+    setBlockTxids.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        setBlockTxids.emplace(tx->GetHash());
+    }
+
+    std::vector<COutPoint> vToFetch;
+    size_t nInputs = 0;
+    size_t nCacheHits = 0;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase())
+            continue;
+        for (const auto& txin : tx->vin) {
+            if (setBlockTxids.count(txin.prevout.hash))
+                continue;
+            nInputs++;
+            if (pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                nCacheHits++;
+                continue;
+            }
+            vToFetch.emplace_back(txin.prevout);
+        }
+    }
+
+    size_t nFetched = 0;
+    if (!vToFetch.empty()) {
+        size_t nThreads = std::max<size_t>(1, inputPrefetchPool.size());
+        size_t nPerThread = (vToFetch.size() + nThreads - 1) / nThreads;
+        std::vector<std::vector<std::pair<COutPoint, Coin>>> vResults((vToFetch.size() + nPerThread - 1) / nPerThread);
+        std::vector<std::future<void>> vFutures;
+        vFutures.reserve(vResults.size());
+        for (size_t i = 0; i < vResults.size(); i++) {
+            size_t nBegin = i * nPerThread;
+            size_t nEnd = std::min(nBegin + nPerThread, vToFetch.size());
+            auto& vResult = vResults[i];
+            vFutures.emplace_back(inputPrefetchPool.push([&vToFetch, &vResult, nBegin, nEnd](int) {
+                // Prefetching is best-effort, ConnectBlock will read whatever we miss here
+                try {
+                    vResult.reserve(nEnd - nBegin);
+                    for (size_t j = nBegin; j < nEnd; j++) {
+                        Coin coin;
+                        if (pcoinsdbview->GetCoin(vToFetch[j], coin)) {
+                            vResult.emplace_back(vToFetch[j], std::move(coin));
+                        }
+                    }
+                } catch (const std::exception& e) {
+                    LogPrint(BCLog::BENCHMARK, "PrefetchBlockInputs: %s\n", e.what());
+                }
+            }));
+        }
+        for (auto& f : vFutures) {
+            f.wait();
+        }
+        for (auto& vResult : vResults) {
+            for (auto& p : vResult) {
+                if (pcoinsTip->AddFetchedCoin(p.first, std::move(p.second)))
+                    nFetched++;
+            }
+        }
+    }
+
+    nPrefetchInputs += nInputs;
+    nPrefetchCacheHits += nCacheHits;
+    nPrefetchFetched += nFetched;
+
+    int64_t nTimeEnd = GetTimeMicros();
+    LogPrint(BCLog::BENCHMARK, "  - Prefetch inputs: %.2fms (%u inputs, %u cached, %u fetched) [cache hit ratio %.2f%%, %u fetched total]\n",
+        (nTimeEnd - nTimeStart) * 0.001, nInputs, nCacheHits, nFetched,
+        nPrefetchInputs ? 100.0 * nPrefetchCacheHits / nPrefetchInputs : 0.0, nPrefetchFetched);
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -1905,9 +2412,10 @@ static int64_t nTimeTotal = 0;
 
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins.
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
- *  can fail if those validity checks fail (among other reasons). */
+ *  can fail if those validity checks fail (among other reasons).
+ *  The transaction, address, spent and timestamp indexes are only written if fUpdateIndexes is set. */
 static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false)
+                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false, bool fUpdateIndexes = true)
 {
     AssertLockHeld(cs_main);
     assert(pindex);
@@ -2326,25 +2834,30 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         setDirtyBlockIndex.insert(pindex);
     }
 
-    if (fTxIndex)
+    // the indexes are only written when connecting to the tip, not when reconnecting on a throwaway view (VerifyDB)
+    if (fTxIndex && fUpdateIndexes)
         if (!pblocktree->WriteTxIndex(vPos))
             return AbortNode(state, "Failed to write transaction index");
 
-    if (fAddressIndex) {
+    if (fAddressIndex && fUpdateIndexes) {
         if (!pblocktree->WriteAddressIndex(addressIndex)) {
             return AbortNode(state, "Failed to write address index");
         }
 
+        if (fAddressSummaryIndex && !UpdateAddressSummaryIndex(addressIndex, pindex, false)) {
+            return AbortNode(state, "Failed to write address summary index");
+        }
+
         if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             return AbortNode(state, "Failed to write address unspent index");
         }
     }
 
-    if (fSpentIndex)
+    if (fSpentIndex && fUpdateIndexes)
         if (!pblocktree->UpdateSpentIndex(spentIndex))
             return AbortNode(state, "Failed to write transaction index");
 
-    if (fTimestampIndex)
+    if (fTimestampIndex && fUpdateIndexes)
         if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
             return AbortNode(state, "Failed to write timestamp index");
 
@@ -2569,7 +3082,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
         auto dbTx = evoDb->BeginTransaction();
 
         CCoinsViewCache view(pcoinsTip);
-        if (DisconnectBlock(block, state, pindexDelete, view) != DISCONNECT_OK)
+        if (DisconnectBlock(block, state, pindexDelete, view, true) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
@@ -2705,6 +3218,8 @@ bool static ConnectTip(CValidationState& state, const CChainParams& chainparams,
     {
         auto dbTx = evoDb->BeginTransaction();
 
+        PrefetchBlockInputs(blockConnecting);
+
         CCoinsViewCache view(pcoinsTip);
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams);
         GetMainSignals().BlockChecked(blockConnecting, state);
@@ -3143,10 +3658,9 @@ bool ResetBlockFailureFlags(CBlockIndex *pindex) {
     return true;
 }
 
-CBlockIndex* AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus = BLOCK_VALID_TREE)
+static CBlockIndex* AddToBlockIndex(const CBlockHeader& block, const uint256& hash, enum BlockStatus nStatus = BLOCK_VALID_TREE)
 {
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator it = mapBlockIndex.find(hash);
     if (it != mapBlockIndex.end())
         return it->second;
@@ -3188,6 +3702,11 @@ CBlockIndex* AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus
     return pindexNew;
 }
 
+CBlockIndex* AddToBlockIndex(const CBlockHeader& block, enum BlockStatus nStatus = BLOCK_VALID_TREE)
+{
+    return AddToBlockIndex(block, block.GetHash(), nStatus);
+}
+
 /** Mark a block as having its data received and checked (up to BLOCK_VALID_TRANSACTIONS). */
 bool ReceivedBlockTransactions(const CBlock &block, CValidationState& state, CBlockIndex *pindexNew, const CDiskBlockPos& pos)
 {
@@ -3322,16 +3841,16 @@ bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigne
     return true;
 }
 
-bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+static bool CheckBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true)
 {
     // Check proof of work matches claimed amount
-    if (fCheckPOW && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams))
+    if (fCheckPOW && !CheckProofOfWork(hash, block.nBits, consensusParams))
         return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
 
     // Check DevNet
     if (!consensusParams.hashDevnetGenesisBlock.IsNull() &&
             block.hashPrevBlock == consensusParams.hashGenesisBlock &&
-            block.GetHash() != consensusParams.hashDevnetGenesisBlock) {
+            hash != consensusParams.hashDevnetGenesisBlock) {
         return state.DoS(100, error("CheckBlockHeader(): wrong devnet genesis"),
                          REJECT_INVALID, "devnet-genesis");
     }
@@ -3339,6 +3858,11 @@ bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const
     return true;
 }
 
+bool CheckBlockHeader(const CBlockHeader& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW)
+{
+    return CheckBlockHeader(block, block.GetHash(), state, consensusParams, fCheckPOW);
+}
+
 bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW, bool fCheckMerkleRoot)
 {
     // These are checks that are independent of context.
@@ -3514,11 +4038,10 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, const Co
     return true;
 }
 
-static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+static bool AcceptBlockHeader(const CBlockHeader& block, const uint256& hash, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex, bool fHeaderChecked = false)
 {
     AssertLockHeld(cs_main);
     // Check for duplicate
-    uint256 hash = block.GetHash();
     BlockMap::iterator miSelf = mapBlockIndex.find(hash);
     CBlockIndex *pindex = NULL;
 
@@ -3535,7 +4058,7 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
             return true;
         }
 
-        if (!CheckBlockHeader(block, state, chainparams.GetConsensus()))
+        if (!fHeaderChecked && !CheckBlockHeader(block, hash, state, chainparams.GetConsensus()))
             return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, hash.ToString(), FormatStateMessage(state));
 
         // Get prev block index
@@ -3561,13 +4084,13 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
 
         if (llmq::chainLocksHandler->HasConflictingChainLock(pindexPrev->nHeight + 1, hash)) {
             if (pindex == NULL) {
-                AddToBlockIndex(block, BLOCK_CONFLICT_CHAINLOCK);
+                AddToBlockIndex(block, hash, BLOCK_CONFLICT_CHAINLOCK);
             }
             return state.DoS(10, error("%s: header %s conflicts with chainlock", __func__, hash.ToString()), REJECT_INVALID, "bad-chainlock");
         }
     }
     if (pindex == NULL)
-        pindex = AddToBlockIndex(block);
+        pindex = AddToBlockIndex(block, hash);
 
     if (ppindex)
         *ppindex = pindex;
@@ -3580,14 +4103,38 @@ static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state
     return true;
 }
 
+static bool AcceptBlockHeader(const CBlockHeader& block, CValidationState& state, const CChainParams& chainparams, CBlockIndex** ppindex)
+{
+    return AcceptBlockHeader(block, block.GetHash(), state, chainparams, ppindex);
+}
+
 // Exposed wrapper for AcceptBlockHeader
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex)
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex, const std::vector<uint256>* pvHeaderHashes)
 {
+    // Phase 1, without cs_main: hash all headers (unless the caller already did so) and
+    // run the context-free checks, so that only the index updates hold the lock
+    std::vector<uint256> vHeaderHashes;
+    if (!pvHeaderHashes) {
+        vHeaderHashes = HashBlockHeaders(headers);
+        pvHeaderHashes = &vHeaderHashes;
+    }
+    assert(pvHeaderHashes->size() == headers.size());
+
+    CValidationState stateCheck;
+    size_t nFirstInvalid = headers.size();
+    for (size_t i = 0; i < headers.size(); i++) {
+        if (!CheckBlockHeader(headers[i], (*pvHeaderHashes)[i], stateCheck, chainparams.GetConsensus())) {
+            nFirstInvalid = i;
+            break;
+        }
+    }
+
+    // Phase 2, with cs_main: connect the headers preceding the first invalid one to the index
     {
         LOCK(cs_main);
-        for (const CBlockHeader& header : headers) {
+        for (size_t i = 0; i < nFirstInvalid; i++) {
             CBlockIndex *pindex = NULL; // Use a temp pindex instead of ppindex to avoid a const_cast
-            if (!AcceptBlockHeader(header, state, chainparams, &pindex)) {
+            if (!AcceptBlockHeader(headers[i], (*pvHeaderHashes)[i], state, chainparams, &pindex, true)) {
                 return false;
             }
             if (ppindex) {
@@ -3595,6 +4142,10 @@ bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& headers, CValidatio
             }
         }
     }
+    if (nFirstInvalid != headers.size()) {
+        state = stateCheck;
+        return error("%s: Consensus::CheckBlockHeader: %s, %s", __func__, (*pvHeaderHashes)[nFirstInvalid].ToString(), FormatStateMessage(state));
+    }
     NotifyHeaderTip();
     return true;
 }
@@ -3952,8 +4503,11 @@ CBlockIndex * InsertBlockIndex(uint256 hash)
 
 bool static LoadBlockIndexDB(const CChainParams& chainparams)
 {
-    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
+    int64_t nStart = GetTimeMillis();
+    int nThreads = std::max(1, std::min(GetNumCores(), MAX_BLOCK_INDEX_LOAD_THREADS));
+    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex, nThreads, [](size_t nRecords) { mapBlockIndex.reserve(nRecords + 1); }))
         return false;
+    LogPrintf("%s: loaded %u block index entries using %d threads in %dms\n", __func__, mapBlockIndex.size(), nThreads, GetTimeMillis() - nStart);
 
     boost::this_thread::interruption_point();
 
@@ -3971,10 +4525,32 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
         }
     }
     sort(vSortedByHeight.begin(), vSortedByHeight.end());
-    BOOST_FOREACH(const PAIRTYPE(int, CBlockIndex*)& item, vSortedByHeight)
+
+    // The work of each block only depends on its own header, so compute it in parallel
+    // and only do the (cheap) accumulation along the chain serially below
+    std::vector<arith_uint256> vBlockProof(vSortedByHeight.size());
     {
-        CBlockIndex* pindex = item.second;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        ctpl::thread_pool pool(nThreads);
+        RenameThreadPool(pool, "dash-loadidx");
+        size_t nPerThread = (vSortedByHeight.size() + nThreads - 1) / nThreads;
+        std::vector<std::future<void>> vFutures;
+        for (size_t nBegin = 0; nBegin < vSortedByHeight.size(); nBegin += nPerThread) {
+            size_t nEnd = std::min(nBegin + nPerThread, vSortedByHeight.size());
+            vFutures.emplace_back(pool.push([&vSortedByHeight, &vBlockProof, nBegin, nEnd](int) {
+                for (size_t i = nBegin; i < nEnd; i++) {
+                    vBlockProof[i] = GetBlockProof(*vSortedByHeight[i].second);
+                }
+            }));
+        }
+        for (auto& f : vFutures) {
+            f.get();
+        }
+    }
+
+    for (size_t i = 0; i < vSortedByHeight.size(); i++)
+    {
+        CBlockIndex* pindex = vSortedByHeight[i].second;
+        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + vBlockProof[i];
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
         // We can link the chain of blocks for which we've received transactions at some point.
         // Pruned nodes may have deleted the block.
@@ -4053,6 +4629,10 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     pblocktree->ReadFlag("addressindex", fAddressIndex);
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Check whether we have an address summary index
+    pblocktree->ReadFlag("addresssummaryindex", fAddressSummaryIndex);
+    LogPrintf("%s: address summary index %s\n", __func__, fAddressSummaryIndex ? "enabled" : "disabled");
+
     // Check whether we have a timestamp index
     pblocktree->ReadFlag("timestampindex", fTimestampIndex);
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
@@ -4146,7 +4726,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         }
         // check level 3: check for inconsistencies during memory-only disconnect of tip blocks
         if (nCheckLevel >= 3 && pindex == pindexState && (coins.DynamicMemoryUsage() + pcoinsTip->DynamicMemoryUsage()) <= nCoinCacheUsage) {
-            DisconnectResult res = DisconnectBlock(block, state, pindex, coins);
+            DisconnectResult res = DisconnectBlock(block, state, pindex, coins, false);
             if (res == DISCONNECT_FAILED) {
                 return error("VerifyDB(): *** irrecoverable inconsistency in block data at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             }
@@ -4174,7 +4754,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             CBlock block;
             if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
-            if (!ConnectBlock(block, state, pindex, coins, chainparams, false))
+            if (!ConnectBlock(block, state, pindex, coins, chainparams, false, false))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         }
     }
@@ -4253,6 +4833,10 @@ bool InitBlockIndex(const CChainParams& chainparams)
     fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
     pblocktree->WriteFlag("addressindex", fAddressIndex);
 
+    // Use the provided setting for -addresssummaryindex in the new database
+    fAddressSummaryIndex = fAddressIndex && GetBoolArg("-addresssummaryindex", DEFAULT_ADDRESSSUMMARYINDEX);
+    pblocktree->WriteFlag("addresssummaryindex", fAddressSummaryIndex);
+
     // Use the provided setting for -timestampindex in the new database
     fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
     pblocktree->WriteFlag("timestampindex", fTimestampIndex);
@@ -4633,6 +5217,7 @@ bool LoadMempool(void)
     int64_t skipped = 0;
     int64_t failed = 0;
     int64_t nNow = GetTime();
+    int64_t nStart = GetTimeMicros();
 
     try {
         uint64_t version;
@@ -4642,30 +5227,43 @@ bool LoadMempool(void)
         }
         uint64_t num;
         file >> num;
-        while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
-            if (amountdelta) {
-                mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
-            }
-            CValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
-                LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(mempool, state, tx, true, NULL, nTime);
-                if (state.IsValid()) {
-                    ++count;
+
+        std::vector<CTransactionRef> vtxChunk;
+        std::vector<int64_t> vTimeChunk;
+        vtxChunk.reserve(std::min(num, (uint64_t)MEMPOOL_LOAD_CHUNK_SIZE));
+        vTimeChunk.reserve(std::min(num, (uint64_t)MEMPOOL_LOAD_CHUNK_SIZE));
+
+        while (num) {
+            // Read the next chunk. Transactions were dumped sorted by ancestor count, so
+            // parents always come before their children, also across chunk boundaries.
+            vtxChunk.clear();
+            vTimeChunk.clear();
+            while (num && vtxChunk.size() < MEMPOOL_LOAD_CHUNK_SIZE) {
+                num--;
+                CTransactionRef tx;
+                int64_t nTime;
+                int64_t nFeeDelta;
+                file >> tx;
+                file >> nTime;
+                file >> nFeeDelta;
+
+                CAmount amountdelta = nFeeDelta;
+                if (amountdelta) {
+                    mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
+                }
+                if (nTime + nExpiryTimeout > nNow) {
+                    vtxChunk.emplace_back(std::move(tx));
+                    vTimeChunk.emplace_back(nTime);
                 } else {
-                    ++failed;
+                    ++skipped;
                 }
-            } else {
-                ++skipped;
             }
+
+            std::vector<CValidationState> vState;
+            std::vector<bool> vAccepted;
+            size_t nAccepted = AcceptToMemoryPoolMany(mempool, vState, vtxChunk, true, vAccepted, NULL, &vTimeChunk);
+            count += nAccepted;
+            failed += vtxChunk.size() - nAccepted;
             if (ShutdownRequested())
                 return false;
         }
@@ -4680,19 +5278,30 @@ bool LoadMempool(void)
         return false;
     }
 
-    LogPrintf("Imported mempool transactions from disk: %i successes, %i failed, %i expired\n", count, failed, skipped);
+    LogPrintf("Imported mempool transactions from disk: %i successes, %i failed, %i expired (%gs)\n", count, failed, skipped, (GetTimeMicros() - nStart) * 0.000001);
     return true;
 }
 
-void DumpMempool(void)
+static CCriticalSection cs_dumpMempool;
+//! Value of CTxMemPool::GetTransactionsUpdated() at the time of the last successful dump
+static unsigned int nLastDumpTransactionsUpdated = 0;
+
+void DumpMempool(bool fOnlyIfChanged)
 {
+    LOCK(cs_dumpMempool);
+
     int64_t start = GetTimeMicros();
 
     std::map<uint256, CAmount> mapDeltas;
     std::vector<TxMempoolInfo> vinfo;
+    unsigned int nTransactionsUpdated;
 
     {
         LOCK(mempool.cs);
+        nTransactionsUpdated = mempool.GetTransactionsUpdated();
+        if (fOnlyIfChanged && nTransactionsUpdated == nLastDumpTransactionsUpdated) {
+            return;
+        }
         for (const auto &i : mempool.mapDeltas) {
             mapDeltas[i.first] = i.second;
         }
@@ -4724,8 +5333,13 @@ void DumpMempool(void)
         FileCommit(file.Get());
         file.fclose();
         RenameOver(GetDataDir() / "mempool.dat.new", GetDataDir() / "mempool.dat");
+        nLastDumpTransactionsUpdated = nTransactionsUpdated;
         int64_t last = GetTimeMicros();
-        LogPrintf("Dumped mempool: %gs to copy, %gs to dump\n", (mid-start)*0.000001, (last-mid)*0.000001);
+        if (fOnlyIfChanged) {
+            LogPrint(BCLog::MEMPOOL, "Dumped mempool: %gs to copy, %gs to dump\n", (mid-start)*0.000001, (last-mid)*0.000001);
+        } else {
+            LogPrintf("Dumped mempool: %gs to copy, %gs to dump\n", (mid-start)*0.000001, (last-mid)*0.000001);
+        }
     } catch (const std::exception& e) {
         LogPrintf("Failed to dump mempool: %s. Continuing anyway.\n", e.what());
     }
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 #include <exception>
+#include <functional>
 #include <map>
 #include <set>
 #include <stdint.h>
@@ -48,6 +49,9 @@ class CValidationInterface;
 class CValidationState;
 struct ChainTxData;
 
+template <typename T>
+class CCheckQueue;
+
 struct LockPoints;
 
 /** Default for accepting alerts from the P2P network. */
@@ -74,6 +78,11 @@ static const unsigned int DEFAULT_DESCENDANT_LIMIT = 25;
 static const unsigned int DEFAULT_DESCENDANT_SIZE_LIMIT = 101;
 /** Default for -mempoolexpiry, expiration time for mempool transactions in hours */
 static const unsigned int DEFAULT_MEMPOOL_EXPIRY = 336;
+/** Default for -mempooldumpinterval, seconds between periodic dumps of the mempool to disk (0 = only at shutdown).
+ *  Off by default, every dump rewrites the whole mempool.dat. */
+static const unsigned int DEFAULT_MEMPOOL_DUMP_INTERVAL = 0;
+/** Number of transactions from mempool.dat which get their scripts verified in parallel before being added to the mempool */
+static const unsigned int MEMPOOL_LOAD_CHUNK_SIZE = 1000;
 /** The maximum size of a blk?????.dat file (since 0.8) */
 static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** The pre-allocation chunk size for blk?????.dat files (since 0.8) */
@@ -85,6 +94,12 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Maximum number of threads used to load the block index at startup */
+static const int MAX_BLOCK_INDEX_LOAD_THREADS = 16;
+/** Maximum number of input prefetch threads allowed */
+static const int MAX_INPUT_PREFETCH_THREADS = 16;
+/** -inputprefetchthreads default (number of threads reading block inputs ahead of ConnectBlock, 0 = disabled) */
+static const int DEFAULT_INPUT_PREFETCH_THREADS = 4;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -135,6 +150,7 @@ static const unsigned int DEFAULT_BYTES_PER_SIGOP = 20;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
 static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
+static const bool DEFAULT_ADDRESSSUMMARYINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
@@ -169,6 +185,8 @@ extern std::atomic_bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressSummaryIndex;
+extern bool fSpentIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern unsigned int nBytesPerSigOp;
@@ -252,8 +270,9 @@ bool ProcessNewBlock(const CChainParams& chainparams, const std::shared_ptr<cons
  * @param[out] state This may be set to an Error state if any error occurred processing them
  * @param[in]  chainparams The params for the chain we want to connect to
  * @param[out] ppindex If set, the pointer will be set to point to the last new block index object for the given headers
+ * @param[in]  pvHeaderHashes If set, the hashes of the headers as computed by HashBlockHeaders
  */
-bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL);
+bool ProcessNewBlockHeaders(const std::vector<CBlockHeader>& block, CValidationState& state, const CChainParams& chainparams, const CBlockIndex** ppindex=NULL, const std::vector<uint256>* pvHeaderHashes=NULL);
 
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
@@ -273,6 +292,16 @@ bool LoadBlockIndex(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Start the threads used by HashBlockHeaders */
+void StartHeaderHashThreads(int nThreads);
+/** Stop the header hashing threads */
+void StopHeaderHashThreads();
+/** Compute the hashes of a batch of headers, split across the header hashing threads if there are enough of them */
+std::vector<uint256> HashBlockHeaders(const std::vector<CBlockHeader>& headers);
+/** Start the threads that load a block's inputs into pcoinsTip before it is connected */
+void StartInputPrefetch(int nThreads);
+/** Stop the input prefetch threads */
+void StopInputPrefetch();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Format a string that describes several potential problems detected by the core.
@@ -339,7 +368,35 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 /** (try to) add transaction to memory pool with a specified acceptance time **/
 bool AcceptToMemoryPoolWithTime(CTxMemPool& pool, CValidationState &state, const CTransactionRef &tx, bool fLimitFree,
                                 bool* pfMissingInputs, int64_t nAcceptTime, bool fOverrideMempoolLimit=false,
-                                const CAmount nAbsurdFee=0, bool fDryRun=false);
+                                const CAmount nAbsurdFee=0, bool fDryRun=false, bool fScriptsVerified=false);
+
+/**
+ * (try to) add a batch of transactions to memory pool.
+ * All checks except for the scripts are run first. The scripts of the transactions which pass them
+ * are verified in parallel on the script check threads, before the transactions are submitted through
+ * AcceptToMemoryPool, parents first. Transactions spending outputs of other transactions of the batch
+ * are handled in later rounds, once their parents are in the mempool. Signatures are only stored in the
+ * signature cache for accepted transactions.
+ * vState, vAccepted, pvMissingInputs and pvAcceptTime are indexed like vtx.
+ * Returns the number of accepted transactions.
+ */
+size_t AcceptToMemoryPoolMany(CTxMemPool& pool, std::vector<CValidationState>& vState, const std::vector<CTransactionRef>& vtx, bool fLimitFree,
+                              std::vector<bool>& vAccepted, std::vector<bool>* pvMissingInputs, const std::vector<int64_t>* pvAcceptTime = NULL,
+                              bool fOverrideMempoolLimit=false, const CAmount nAbsurdFee=0);
+
+/**
+ * Create script checks for all transactions of vtx (which must be ordered parents first) whose inputs
+ * are available in view. Outputs of each transaction are added to view, so later transactions of the
+ * batch may spend them.
+ */
+void GetBatchScriptChecks(const std::vector<CTransactionRef>& vtx, CCoinsViewCache& view, unsigned int flags, bool cacheStore,
+                          std::vector<CScriptCheck>& vChecks);
+
+/** Run script checks on the threads of pqueue, or serially if pqueue is NULL. Returns whether all checks succeeded. */
+bool RunScriptChecks(std::vector<CScriptCheck>& vChecks, CCheckQueue<CScriptCheck>* pqueue);
+
+/** The queue of the script verification threads, or NULL if there are none (-par=1) */
+CCheckQueue<CScriptCheck>* GetScriptCheckQueue();
 
 bool GetUTXOCoin(const COutPoint& outpoint, Coin& coin);
 int GetUTXOHeight(const COutPoint& outpoint);
@@ -449,13 +506,15 @@ private:
     unsigned int nIn;
     unsigned int nFlags;
     bool cacheStore;
+    std::vector<uint256>* pvSigCacheEntries;
     ScriptError error;
 
 public:
-    CScriptCheck(): ptxTo(0), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
-    CScriptCheck(const CScript& scriptPubKeyIn, const CAmount amountIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn) :
+    CScriptCheck(): ptxTo(0), nIn(0), nFlags(0), cacheStore(false), pvSigCacheEntries(NULL), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
+    CScriptCheck(const CScript& scriptPubKeyIn, const CAmount amountIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn,
+                 std::vector<uint256>* pvSigCacheEntriesIn = NULL) :
         scriptPubKey(scriptPubKeyIn),
-        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR) { }
+        ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), pvSigCacheEntries(pvSigCacheEntriesIn), error(SCRIPT_ERR_UNKNOWN_ERROR) { }
 
     bool operator()();
 
@@ -465,6 +524,7 @@ public:
         std::swap(nIn, check.nIn);
         std::swap(nFlags, check.nFlags);
         std::swap(cacheStore, check.cacheStore);
+        std::swap(pvSigCacheEntries, check.pvSigCacheEntries);
         std::swap(error, check.error);
     }
 
@@ -478,6 +538,14 @@ bool GetAddressIndex(uint160 addressHash, int type,
                      int start = 0, int end = 0);
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
+/** Visit address index entries or unspent outputs without collecting them, see CBlockTreeDB */
+bool ForEachAddressIndex(uint160 addressHash, int type, int start, int end, const CAddressIndexKey* pStartAfter,
+                         const std::function<bool(const CAddressIndexKey&, const CAmount&)>& func);
+bool ForEachAddressUnspent(uint160 addressHash, int type, const CAddressUnspentKey* pStartAfter,
+                           const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& func);
+bool GetAddressSummary(uint160 addressHash, int type, CAddressSummary &summary);
+/** Build the address summary index from the address index or drop it, if the setting changed */
+bool SetAddressSummaryIndex(bool fEnable);
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
@@ -570,8 +638,8 @@ static const unsigned int REJECT_CONFLICT = 0x102;
 /** Get block file info entry for one block file */
 CBlockFileInfo* GetBlockFileInfo(size_t n);
 
-/** Dump the mempool to disk. */
-void DumpMempool();
+/** Dump the mempool to disk. If fOnlyIfChanged is set, skip the dump when the mempool didn't change since the last one. */
+void DumpMempool(bool fOnlyIfChanged = false);
 
 /** Load the mempool from disk. */
 bool LoadMempool();
@@ -0,0 +1,63 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "wallet/coinindex.h"
+
+#include "privatesend/privatesend.h"
+
+#include <tuple>
+
+bool CWalletCoinIndex::CoinKey::operator<(const CoinKey& other) const
+{
+    return std::tie(nType, nValue, nRounds, dest) < std::tie(other.nType, other.nValue, other.nRounds, other.dest);
+}
+
+int CWalletCoinIndex::GetCoinType(CAmount nValue)
+{
+    if (CPrivateSend::IsDenominatedAmount(nValue)) return COIN_TYPE_DENOMINATED;
+    if (CPrivateSend::IsCollateralAmount(nValue)) return COIN_TYPE_COLLATERAL;
+    if (nValue == 1000 * COIN) return COIN_TYPE_MASTERNODE;
+    return COIN_TYPE_OTHER;
+}
+
+bool CWalletCoinIndex::Add(const COutPoint& outpoint, const CTxOut& txout, int nRounds)
+{
+    CoinKey key{GetCoinType(txout.nValue), txout.nValue, nRounds, CNoDestination()};
+    if (!ExtractDestination(txout.scriptPubKey, key.dest)) {
+        key.dest = CNoDestination();
+    }
+
+    if (!mapCoinKeys.emplace(outpoint, key).second) {
+        return false;
+    }
+    setCoins.emplace(key, outpoint);
+    return true;
+}
+
+bool CWalletCoinIndex::Remove(const COutPoint& outpoint)
+{
+    auto it = mapCoinKeys.find(outpoint);
+    if (it == mapCoinKeys.end()) {
+        return false;
+    }
+    setCoins.erase(std::make_pair(it->second, outpoint));
+    mapCoinKeys.erase(it);
+    return true;
+}
+
+void CWalletCoinIndex::Clear()
+{
+    setCoins.clear();
+    mapCoinKeys.clear();
+}
+
+bool CWalletCoinIndex::GetKey(const COutPoint& outpoint, CoinKey& keyRet) const
+{
+    auto it = mapCoinKeys.find(outpoint);
+    if (it == mapCoinKeys.end()) {
+        return false;
+    }
+    keyRet = it->second;
+    return true;
+}
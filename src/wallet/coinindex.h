@@ -0,0 +1,106 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_WALLET_COININDEX_H
+#define BITCOIN_WALLET_COININDEX_H
+
+#include "amount.h"
+#include "primitives/transaction.h"
+#include "pubkey.h"
+#include "script/standard.h"
+
+#include <limits>
+#include <map>
+#include <set>
+
+/**
+ * Index of the wallet's unspent outputs ordered by coin type, amount, PrivateSend rounds
+ * and destination.
+ *
+ * CWallet keeps it in sync with setWalletUTXO, so coin selection and mixing only visit
+ * the outputs of the kind they are looking for instead of scanning the whole wallet.
+ * Everything that changes with the chain (depth, trust, locks) is still checked by the
+ * callers on the outputs returned from here.
+ */
+class CWalletCoinIndex
+{
+public:
+    enum CoinType : int {
+        COIN_TYPE_OTHER = 0,
+        COIN_TYPE_DENOMINATED = 1,
+        COIN_TYPE_COLLATERAL = 2,
+        COIN_TYPE_MASTERNODE = 3, // exactly 1000 DASH
+    };
+
+    struct CoinKey {
+        int nType;
+        CAmount nValue;
+        // real (uncapped) PrivateSend rounds, see CWallet::GetRealOutpointPrivateSendRounds
+        int nRounds;
+        CTxDestination dest;
+
+        bool operator<(const CoinKey& other) const;
+    };
+
+    static int GetCoinType(CAmount nValue);
+
+private:
+    typedef std::pair<CoinKey, COutPoint> entry_t;
+
+    std::set<entry_t> setCoins;
+    std::map<COutPoint, CoinKey> mapCoinKeys;
+
+    static entry_t LowerBound(int nType, CAmount nValue, int nRounds)
+    {
+        return std::make_pair(CoinKey{nType, nValue, nRounds, CNoDestination()}, COutPoint(uint256(), 0));
+    }
+
+public:
+    /// Add an output, returns false if it was already indexed
+    bool Add(const COutPoint& outpoint, const CTxOut& txout, int nRounds);
+    /// Remove an output, returns false if it was not indexed
+    bool Remove(const COutPoint& outpoint);
+    void Clear();
+
+    bool Contains(const COutPoint& outpoint) const { return mapCoinKeys.count(outpoint) != 0; }
+    bool GetKey(const COutPoint& outpoint, CoinKey& keyRet) const;
+    size_t Size() const { return mapCoinKeys.size(); }
+
+    /// Call func(outpoint, key) for every output of nType, or only for those of nValue if it's not negative
+    template<typename Callable>
+    void ForEachCoin(int nType, Callable&& func, CAmount nValue = -1) const
+    {
+        auto it = setCoins.lower_bound(LowerBound(nType, nValue < 0 ? std::numeric_limits<CAmount>::min() : nValue, std::numeric_limits<int>::min()));
+        for (; it != setCoins.end() && it->first.nType == nType; ++it) {
+            if (nValue >= 0 && it->first.nValue != nValue) {
+                break;
+            }
+            func(it->second, it->first);
+        }
+    }
+
+    /// Call func(outpoint, key) for every output of nType with nRoundsMin <= rounds <= nRoundsMax,
+    /// skipping all outputs out of range for every amount
+    template<typename Callable>
+    void ForEachCoinInRounds(int nType, int nRoundsMin, int nRoundsMax, Callable&& func) const
+    {
+        auto it = setCoins.lower_bound(LowerBound(nType, std::numeric_limits<CAmount>::min(), std::numeric_limits<int>::min()));
+        while (it != setCoins.end() && it->first.nType == nType) {
+            CAmount nValue = it->first.nValue;
+            it = setCoins.lower_bound(LowerBound(nType, nValue, nRoundsMin));
+            for (; it != setCoins.end() && it->first.nType == nType && it->first.nValue == nValue; ++it) {
+                if (it->first.nRounds > nRoundsMax) {
+                    break;
+                }
+                func(it->second, it->first);
+            }
+            if (nValue == std::numeric_limits<CAmount>::max()) {
+                break;
+            }
+            it = setCoins.lower_bound(LowerBound(nType, nValue + 1, std::numeric_limits<int>::min()));
+        }
+    }
+};
+
+#endif // BITCOIN_WALLET_COININDEX_H
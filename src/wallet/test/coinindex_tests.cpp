@@ -0,0 +1,91 @@
+// Copyright (c) 2019 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "privatesend/privatesend.h"
+#include "random.h"
+#include "wallet/coinindex.h"
+
+#include "test/test_dash.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(coinindex_tests, BasicTestingSetup)
+
+static CTxOut CreateTxOut(CAmount nValue)
+{
+    uint256 hash = GetRandHash();
+    return CTxOut(nValue, GetScriptForDestination(CKeyID(uint160(std::vector<unsigned char>(hash.begin(), hash.begin() + 20)))));
+}
+
+BOOST_AUTO_TEST_CASE(coinindex_types)
+{
+    CPrivateSend::InitStandardDenominations();
+
+    BOOST_CHECK_EQUAL(CWalletCoinIndex::GetCoinType(CPrivateSend::GetSmallestDenomination()), CWalletCoinIndex::COIN_TYPE_DENOMINATED);
+    BOOST_CHECK_EQUAL(CWalletCoinIndex::GetCoinType(CPrivateSend::GetCollateralAmount()), CWalletCoinIndex::COIN_TYPE_COLLATERAL);
+    BOOST_CHECK_EQUAL(CWalletCoinIndex::GetCoinType(1000 * COIN), CWalletCoinIndex::COIN_TYPE_MASTERNODE);
+    BOOST_CHECK_EQUAL(CWalletCoinIndex::GetCoinType(5 * COIN), CWalletCoinIndex::COIN_TYPE_OTHER);
+}
+
+BOOST_AUTO_TEST_CASE(coinindex_queries)
+{
+    CPrivateSend::InitStandardDenominations();
+    std::vector<CAmount> vecDenoms = CPrivateSend::GetStandardDenominations();
+
+    CWalletCoinIndex coinIndex;
+    std::map<COutPoint, std::pair<CAmount, int> > mapExpected;
+    for (int i = 0; i < 200; i++) {
+        COutPoint outpoint(GetRandHash(), i);
+        CAmount nValue = vecDenoms[i % vecDenoms.size()];
+        int nRounds = i % 8;
+        BOOST_CHECK(coinIndex.Add(outpoint, CreateTxOut(nValue), nRounds));
+        BOOST_CHECK(!coinIndex.Add(outpoint, CreateTxOut(nValue), nRounds));
+        mapExpected.emplace(outpoint, std::make_pair(nValue, nRounds));
+    }
+    COutPoint outpointOther(GetRandHash(), 0);
+    BOOST_CHECK(coinIndex.Add(outpointOther, CreateTxOut(5 * COIN), -2));
+    BOOST_CHECK(coinIndex.Add(COutPoint(GetRandHash(), 0), CreateTxOut(CPrivateSend::GetCollateralAmount()), -3));
+    BOOST_CHECK_EQUAL(coinIndex.Size(), 202);
+
+    // all coins of a type
+    size_t nCount = 0;
+    coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_DENOMINATED, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+        BOOST_CHECK(mapExpected.count(outpoint));
+        nCount++;
+    });
+    BOOST_CHECK_EQUAL(nCount, 200);
+
+    // coins of a single amount
+    nCount = 0;
+    coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_DENOMINATED, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+        BOOST_CHECK_EQUAL(key.nValue, vecDenoms[1]);
+        BOOST_CHECK_EQUAL(mapExpected[outpoint].first, vecDenoms[1]);
+        nCount++;
+    }, vecDenoms[1]);
+    BOOST_CHECK_EQUAL(nCount, 200 / vecDenoms.size());
+
+    // coins within a range of rounds, over all amounts
+    size_t nExpected = 0;
+    for (const auto& pair : mapExpected) {
+        if (pair.second.second >= 2 && pair.second.second <= 4) nExpected++;
+    }
+    nCount = 0;
+    coinIndex.ForEachCoinInRounds(CWalletCoinIndex::COIN_TYPE_DENOMINATED, 2, 4, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+        BOOST_CHECK(key.nRounds >= 2 && key.nRounds <= 4);
+        BOOST_CHECK_EQUAL(mapExpected[outpoint].second, key.nRounds);
+        nCount++;
+    });
+    BOOST_CHECK_EQUAL(nCount, nExpected);
+
+    // removed coins are gone from all queries
+    BOOST_CHECK(coinIndex.Remove(outpointOther));
+    BOOST_CHECK(!coinIndex.Remove(outpointOther));
+    BOOST_CHECK(!coinIndex.Contains(outpointOther));
+    coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_OTHER, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+        BOOST_ERROR("no other coins expected");
+    });
+    BOOST_CHECK_EQUAL(coinIndex.Size(), 201);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -524,6 +524,22 @@ BOOST_FIXTURE_TEST_CASE(coin_mark_dirty_immature_credit, TestChain100Setup)
     BOOST_CHECK_EQUAL(wtx.GetImmatureCredit(), 500*COIN);
 }
 
+// Check that outputs which become ours after their transaction was added to the
+// wallet (e.g. importprivkey without rescan) are found by coin selection.
+BOOST_FIXTURE_TEST_CASE(coin_index_key_added_later, TestChain100Setup)
+{
+    CWallet wallet;
+    CWalletTx wtx(&wallet, MakeTransactionRef(coinbaseTxns.back()));
+    LOCK2(cs_main, wallet.cs_wallet);
+    wtx.hashBlock = chainActive.Tip()->GetBlockHash();
+    wtx.nIndex = 0;
+    wallet.AddToWallet(wtx);
+    BOOST_CHECK_EQUAL(wallet.CountInputsWithAmount(500*COIN), 0);
+
+    wallet.AddKeyPubKey(coinbaseKey, coinbaseKey.GetPubKey());
+    BOOST_CHECK_EQUAL(wallet.CountInputsWithAmount(500*COIN), 1);
+}
+
 static int64_t AddTx(CWallet& wallet, uint32_t lockTime, int64_t mockTime, int64_t blockTime)
 {
     CMutableTransaction tx;
@@ -42,6 +42,7 @@
 #include "llmq/quorums_chainlocks.h"
 
 #include <assert.h>
+#include <limits>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
@@ -52,6 +53,7 @@ CFeeRate payTxFee(DEFAULT_TRANSACTION_FEE);
 unsigned int nTxConfirmTarget = DEFAULT_TX_CONFIRM_TARGET;
 bool bSpendZeroConfChange = DEFAULT_SPEND_ZEROCONF_CHANGE;
 bool bBIP69Enabled = true;
+bool fCheckBalanceCache = DEFAULT_CHECK_BALANCE_CACHE;
 
 const char * DEFAULT_WALLET_DAT = "wallet.dat";
 
@@ -276,6 +278,7 @@ bool CWallet::AddHDPubKey(const CExtPubKey &extPubKey, bool fInternal)
     hdPubKey.hdchainID = hdChainCurrent.GetID();
     hdPubKey.nChangeIndex = fInternal ? 1 : 0;
     mapHdPubKeys[extPubKey.pubkey.GetID()] = hdPubKey;
+    fWalletUTXOsStale = true;
 
     // check if we need to remove from watch-only
     CScript script;
@@ -297,6 +300,7 @@ bool CWallet::AddKeyPubKey(const CKey& secret, const CPubKey &pubkey)
     AssertLockHeld(cs_wallet); // mapKeyMetadata
     if (!CCryptoKeyStore::AddKeyPubKey(secret, pubkey))
         return false;
+    fWalletUTXOsStale = true;
 
     // check if we need to remove from watch-only
     CScript script;
@@ -367,6 +371,10 @@ bool CWallet::AddCScript(const CScript& redeemScript)
 {
     if (!CCryptoKeyStore::AddCScript(redeemScript))
         return false;
+    {
+        LOCK(cs_wallet);
+        fWalletUTXOsStale = true;
+    }
     if (!fFileBacked)
         return true;
     return CWalletDB(strWalletFile).WriteCScript(Hash160(redeemScript), redeemScript);
@@ -392,6 +400,10 @@ bool CWallet::AddWatchOnly(const CScript& dest)
 {
     if (!CCryptoKeyStore::AddWatchOnly(dest))
         return false;
+    {
+        LOCK(cs_wallet);
+        fWalletUTXOsStale = true;
+    }
     const CKeyMetadata& meta = mapKeyMetadata[CScriptID(dest)];
     UpdateTimeFirstKey(meta.nCreateTime);
     NotifyWatchonlyChanged(true);
@@ -711,6 +723,7 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
     setWalletUTXO.erase(outpoint);
+    coinIndex.Remove(outpoint);
 
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
@@ -718,6 +731,73 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 }
 
 
+void CWallet::AddWalletUTXO(const COutPoint& outpoint, const CTxOut& txout) const
+{
+    AssertLockHeld(cs_wallet);
+
+    if (!setWalletUTXO.insert(outpoint).second) {
+        return;
+    }
+
+    int nRounds;
+    switch (CWalletCoinIndex::GetCoinType(txout.nValue)) {
+        case CWalletCoinIndex::COIN_TYPE_DENOMINATED:
+            nRounds = GetRealOutpointPrivateSendRounds(outpoint);
+            break;
+        case CWalletCoinIndex::COIN_TYPE_COLLATERAL:
+            nRounds = -3;
+            break;
+        default:
+            nRounds = -2;
+            break;
+    }
+    coinIndex.Add(outpoint, txout, nRounds);
+}
+
+void CWallet::UpdateWalletUTXOs() const
+{
+    AssertLockHeld(cs_wallet);
+
+    if (!fWalletUTXOsStale) {
+        return;
+    }
+    fWalletUTXOsStale = false;
+
+    size_t nAdded = 0;
+    for (const auto& pair : mapWallet) {
+        for (unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
+            COutPoint outpoint(pair.first, i);
+            if (!setWalletUTXO.count(outpoint) && IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
+                AddWalletUTXO(outpoint, pair.second.tx->vout[i]);
+                nAdded++;
+            }
+        }
+    }
+
+    if (nAdded > 0) {
+        fAnonymizableTallyCached = false;
+        fAnonymizableTallyCachedNonDenom = false;
+        // anonymized and denominated balances are computed from the wallet UTXOs
+        mapBalanceCache.clear();
+        LogPrint(BCLog::SELECTCOINS, "CWallet::%s -- added %d outputs which became ours\n", __func__, nAdded);
+    }
+}
+
+void CWallet::AddUnspentPrevouts(const CTransaction& tx)
+{
+    AssertLockHeld(cs_wallet);
+
+    for (const auto& txin : tx.vin) {
+        auto it = mapWallet.find(txin.prevout.hash);
+        if (it == mapWallet.end() || txin.prevout.n >= it->second.tx->vout.size()) continue;
+
+        const CTxOut& txout = it->second.tx->vout[txin.prevout.n];
+        if (IsMine(txout) && !IsSpent(txin.prevout.hash, txin.prevout.n)) {
+            AddWalletUTXO(txin.prevout, txout);
+        }
+    }
+}
+
 void CWallet::AddToSpends(const uint256& wtxid)
 {
     assert(mapWallet.count(wtxid));
@@ -1027,6 +1107,7 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         BOOST_FOREACH(PAIRTYPE(const uint256, CWalletTx)& item, mapWallet)
             item.second.MarkDirty();
+        InvalidateBalanceCache();
     }
 
     fAnonymizableTallyCached = false;
@@ -1057,7 +1138,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
         auto mnList = deterministicMNManager->GetListAtChainTip();
         for(unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
             if (IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
-                setWalletUTXO.insert(COutPoint(hash, i));
+                AddWalletUTXO(COutPoint(hash, i), wtx.tx->vout[i]);
                 if (deterministicMNManager->IsProTxWithCollateral(wtx.tx, i) || mnList.HasMNByCollateral(COutPoint(hash, i))) {
                     LockCoin(COutPoint(hash, i));
                 }
@@ -1090,6 +1171,12 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
             wtx.fFromMe = wtxIn.fFromMe;
             fUpdated = true;
         }
+        // Outputs might have become ours since the transaction was added (e.g. imported keys)
+        for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+            if (!setWalletUTXO.count(COutPoint(hash, i)) && IsMine(wtx.tx->vout[i]) && !IsSpent(hash, i)) {
+                AddWalletUTXO(COutPoint(hash, i), wtx.tx->vout[i]);
+            }
+        }
     }
 
     //// debug print
@@ -1117,6 +1204,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 
     return true;
 }
@@ -1241,11 +1329,13 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
                 if (mapWallet.count(txin.prevout.hash))
                     mapWallet[txin.prevout.hash].MarkDirty();
             }
+            AddUnspentPrevouts(*wtx.tx);
         }
     }
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 
     return true;
 }
@@ -1305,11 +1395,13 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
                 if (mapWallet.count(txin.prevout.hash))
                     mapWallet[txin.prevout.hash].MarkDirty();
             }
+            AddUnspentPrevouts(*wtx.tx);
         }
     }
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 }
 
 void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pindex, int posInBlock) {
@@ -1329,6 +1421,7 @@ void CWallet::SyncTransaction(const CTransactionRef& ptx, const CBlockIndex *pin
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 }
 
 void CWallet::TransactionAddedToMempool(const CTransactionRef& ptx) {
@@ -1357,6 +1450,9 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexDisconnected) {
     LOCK2(cs_main, cs_wallet);
 
+    // Depth of everything in the wallet changes on reorg
+    InvalidateBalanceCache();
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         // NOTE: do NOT pass pindex here
         SyncTransaction(ptx);
@@ -2331,20 +2427,59 @@ void CWallet::ResendWalletTransactions(int64_t nBestBlockTime, CConnman* connman
  */
 
 
+void CWallet::InvalidateBalanceCache()
+{
+    AssertLockHeld(cs_wallet);
+    mapBalanceCache.clear();
+}
+
+CAmount CWallet::GetCachedBalance(BalanceType type, isminefilter filter, const std::function<CAmount()>& computeBalance) const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    // Depth, maturity and trust of wallet transactions change without the wallet itself changing
+    uint256 hashTip = chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256();
+    unsigned int nMempoolRemoved = mempool.GetTransactionsRemoved();
+    if (hashTip != hashBalanceCacheTip || nMempoolRemoved != nBalanceCacheMempoolRemoved ||
+        privateSendClient.nPrivateSendRounds != nBalanceCachePrivateSendRounds) {
+        mapBalanceCache.clear();
+        hashBalanceCacheTip = hashTip;
+        nBalanceCacheMempoolRemoved = nMempoolRemoved;
+        nBalanceCachePrivateSendRounds = privateSendClient.nPrivateSendRounds;
+    }
+
+    auto key = std::make_pair(type, filter);
+    auto it = mapBalanceCache.find(key);
+    if (it == mapBalanceCache.end()) {
+        return mapBalanceCache.emplace(key, computeBalance()).first->second;
+    }
+
+    if (fCheckBalanceCache) {
+        CAmount nBalance = computeBalance();
+        if (nBalance != it->second) {
+            LogPrintf("CWallet::%s -- ERROR: cached balance %s differs from full scan %s (type=%d, filter=%d)\n", __func__,
+                      FormatMoney(it->second), FormatMoney(nBalance), type, filter);
+            assert(false);
+        }
+    }
+
+    return it->second;
+}
+
 CAmount CWallet::GetBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_AVAILABLE, ISMINE_SPENDABLE, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             if (pcoin->IsTrusted())
                 nTotal += pcoin->GetAvailableCredit();
         }
-    }
-
-    return nTotal;
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetAnonymizableBalance(bool fSkipDenominated, bool fSkipUnconfirmed) const
@@ -2373,22 +2508,22 @@ CAmount CWallet::GetAnonymizedBalance() const
 {
     if(fLiteMode) return 0;
 
-    CAmount nTotal = 0;
-
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
+    return GetCachedBalance(BALANCE_ANONYMIZED, ISMINE_SPENDABLE, [this]() {
+        CAmount nTotal = 0;
+        std::set<uint256> setWalletTxesCounted;
+        for (const auto& outpoint : setWalletUTXO) {
 
-    std::set<uint256> setWalletTxesCounted;
-    for (const auto& outpoint : setWalletUTXO) {
-
-        if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
-
-        const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end() || !it->second.IsTrusted()) continue;
+            if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
 
-        nTotal += it->second.GetAnonymizedCredit();
-    }
+            const auto it = mapWallet.find(outpoint.hash);
+            if (it == mapWallet.end() || !it->second.IsTrusted()) continue;
 
-    return nTotal;
+            nTotal += it->second.GetAnonymizedCredit();
+        }
+        return nTotal;
+    });
 }
 
 // Note: calculated including unconfirmed,
@@ -2401,6 +2536,7 @@ float CWallet::GetAverageAnonymizedRounds() const
     int nCount = 0;
 
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
     for (const auto& outpoint : setWalletUTXO) {
         if(!IsDenominated(outpoint)) continue;
 
@@ -2422,6 +2558,7 @@ CAmount CWallet::GetNormalizedAnonymizedBalance() const
     CAmount nTotal = 0;
 
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
     for (const auto& outpoint : setWalletUTXO) {
         const auto it = mapWallet.find(outpoint.hash);
         if (it == mapWallet.end()) continue;
@@ -2441,159 +2578,181 @@ CAmount CWallet::GetDenominatedBalance(bool unconfirmed) const
 {
     if(fLiteMode) return 0;
 
-    CAmount nTotal = 0;
-
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
+    return GetCachedBalance(unconfirmed ? BALANCE_DENOMINATED_UNCONFIRMED : BALANCE_DENOMINATED_CONFIRMED, ISMINE_SPENDABLE, [this, unconfirmed]() {
+        CAmount nTotal = 0;
+        std::set<uint256> setWalletTxesCounted;
+        for (const auto& outpoint : setWalletUTXO) {
+            if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
 
-    std::set<uint256> setWalletTxesCounted;
-    for (const auto& outpoint : setWalletUTXO) {
-        if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
-
-        const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
-
-        nTotal += it->second.GetDenominatedCredit(unconfirmed);
-    }
+            const auto it = mapWallet.find(outpoint.hash);
+            if (it == mapWallet.end()) continue;
 
-    return nTotal;
+            nTotal += it->second.GetDenominatedCredit(unconfirmed);
+        }
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetUnconfirmedBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_UNCONFIRMED, ISMINE_SPENDABLE, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && !pcoin->IsLockedByInstantSend() && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableCredit();
         }
-    }
-    return nTotal;
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetImmatureBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_IMMATURE, ISMINE_SPENDABLE, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             nTotal += pcoin->GetImmatureCredit();
         }
-    }
-    return nTotal;
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetWatchOnlyBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_AVAILABLE, ISMINE_WATCH_ONLY, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             if (pcoin->IsTrusted())
                 nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
-    }
-
-    return nTotal;
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetUnconfirmedWatchOnlyBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_UNCONFIRMED, ISMINE_WATCH_ONLY, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             if (!pcoin->IsTrusted() && pcoin->GetDepthInMainChain() == 0 && !pcoin->IsLockedByInstantSend() && pcoin->InMempool())
                 nTotal += pcoin->GetAvailableWatchOnlyCredit();
         }
-    }
-    return nTotal;
+        return nTotal;
+    });
 }
 
 CAmount CWallet::GetImmatureWatchOnlyBalance() const
 {
-    CAmount nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
+    LOCK2(cs_main, cs_wallet);
+    return GetCachedBalance(BALANCE_IMMATURE, ISMINE_WATCH_ONLY, [this]() {
+        CAmount nTotal = 0;
         for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         {
             const CWalletTx* pcoin = &(*it).second;
             nTotal += pcoin->GetImmatureWatchOnlyCredit();
         }
-    }
-    return nTotal;
+        return nTotal;
+    });
 }
 
-void CWallet::AvailableCoins(std::vector<COutput>& vCoins, bool fOnlySafe, const CCoinControl *coinControl, bool fIncludeZeroValue, AvailableCoinsType nCoinType, bool fUseInstantSend) const
+void CWallet::AddAvailableCoin(std::vector<COutput>& vCoins, const COutPoint& outpoint, bool fOnlySafe, const CCoinControl *coinControl, bool fIncludeZeroValue, bool fIncludeLocked, bool fUseInstantSend) const
 {
-    vCoins.clear();
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
 
-    {
-        LOCK2(cs_main, cs_wallet);
-        int nInstantSendConfirmationsRequired = Params().GetConsensus().nInstantSendConfirmationsRequired;
+    std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
+    if (it == mapWallet.end())
+        return;
 
-        for (std::map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-        {
-            const uint256& wtxid = it->first;
-            const CWalletTx* pcoin = &(*it).second;
+    const CWalletTx* pcoin = &(*it).second;
+    unsigned int i = outpoint.n;
 
-            if (!CheckFinalTx(*pcoin))
-                continue;
+    if (!CheckFinalTx(*pcoin))
+        return;
 
-            if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0)
-                continue;
+    if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0)
+        return;
 
-            int nDepth = pcoin->GetDepthInMainChain();
-            // do not use IX for inputs that have less then nInstantSendConfirmationsRequired blockchain confirmations
-            if (fUseInstantSend && nDepth < nInstantSendConfirmationsRequired)
-                continue;
+    int nDepth = pcoin->GetDepthInMainChain();
+    // do not use IX for inputs that have less then nInstantSendConfirmationsRequired blockchain confirmations
+    if (fUseInstantSend && nDepth < Params().GetConsensus().nInstantSendConfirmationsRequired)
+        return;
 
-            // We should not consider coins which aren't at least in our mempool
-            // It's possible for these to be conflicted via ancestors which we may never be able to detect
-            if (nDepth == 0 && !pcoin->InMempool())
-                continue;
+    // We should not consider coins which aren't at least in our mempool
+    // It's possible for these to be conflicted via ancestors which we may never be able to detect
+    if (nDepth == 0 && !pcoin->InMempool())
+        return;
 
-            bool safeTx = pcoin->IsTrusted();
+    bool safeTx = pcoin->IsTrusted();
 
-            if (fOnlySafe && !safeTx) {
-                continue;
-            }
+    if (fOnlySafe && !safeTx) {
+        return;
+    }
 
-            for (unsigned int i = 0; i < pcoin->tx->vout.size(); i++) {
-                bool found = false;
-                if(nCoinType == ONLY_DENOMINATED) {
-                    found = CPrivateSend::IsDenominatedAmount(pcoin->tx->vout[i].nValue);
-                } else if(nCoinType == ONLY_NONDENOMINATED) {
-                    if (CPrivateSend::IsCollateralAmount(pcoin->tx->vout[i].nValue)) continue; // do not use collateral amounts
-                    found = !CPrivateSend::IsDenominatedAmount(pcoin->tx->vout[i].nValue);
-                } else if(nCoinType == ONLY_1000) {
-                    found = pcoin->tx->vout[i].nValue == 1000*COIN;
-                } else if(nCoinType == ONLY_PRIVATESEND_COLLATERAL) {
-                    found = CPrivateSend::IsCollateralAmount(pcoin->tx->vout[i].nValue);
-                } else {
-                    found = true;
-                }
-                if(!found) continue;
-
-                isminetype mine = IsMine(pcoin->tx->vout[i]);
-                if (!(IsSpent(wtxid, i)) && mine != ISMINE_NO &&
-                    (!IsLockedCoin((*it).first, i) || nCoinType == ONLY_1000) &&
-                    (pcoin->tx->vout[i].nValue > 0 || fIncludeZeroValue) &&
-                    (!coinControl || !coinControl->HasSelected() || coinControl->fAllowOtherInputs || coinControl->IsSelected(COutPoint((*it).first, i))))
-                        vCoins.push_back(COutput(pcoin, i, nDepth,
-                                                 ((mine & ISMINE_SPENDABLE) != ISMINE_NO) ||
-                                                  (coinControl && coinControl->fAllowWatchOnly && (mine & ISMINE_WATCH_SOLVABLE) != ISMINE_NO),
-                                                 (mine & (ISMINE_SPENDABLE | ISMINE_WATCH_SOLVABLE)) != ISMINE_NO, safeTx));
-            }
-        }
+    isminetype mine = IsMine(pcoin->tx->vout[i]);
+    if (!(IsSpent(outpoint.hash, i)) && mine != ISMINE_NO &&
+        (!IsLockedCoin(outpoint.hash, i) || fIncludeLocked) &&
+        (pcoin->tx->vout[i].nValue > 0 || fIncludeZeroValue) &&
+        (!coinControl || !coinControl->HasSelected() || coinControl->fAllowOtherInputs || coinControl->IsSelected(outpoint)))
+            vCoins.push_back(COutput(pcoin, i, nDepth,
+                                     ((mine & ISMINE_SPENDABLE) != ISMINE_NO) ||
+                                      (coinControl && coinControl->fAllowWatchOnly && (mine & ISMINE_WATCH_SOLVABLE) != ISMINE_NO),
+                                     (mine & (ISMINE_SPENDABLE | ISMINE_WATCH_SOLVABLE)) != ISMINE_NO, safeTx));
+}
+
+void CWallet::AvailableCoins(std::vector<COutput>& vCoins, bool fOnlySafe, const CCoinControl *coinControl, bool fIncludeZeroValue, AvailableCoinsType nCoinType, bool fUseInstantSend) const
+{
+    vCoins.clear();
+
+    {
+        LOCK2(cs_main, cs_wallet);
+        UpdateWalletUTXOs();
+
+        // Only visit the unspent outputs of the requested kind
+        std::vector<int> vecCoinTypes;
+        switch (nCoinType) {
+            case ONLY_DENOMINATED:
+                vecCoinTypes = {CWalletCoinIndex::COIN_TYPE_DENOMINATED};
+                break;
+            case ONLY_NONDENOMINATED:
+                // do not use collateral amounts
+                vecCoinTypes = {CWalletCoinIndex::COIN_TYPE_OTHER, CWalletCoinIndex::COIN_TYPE_MASTERNODE};
+                break;
+            case ONLY_1000:
+                vecCoinTypes = {CWalletCoinIndex::COIN_TYPE_MASTERNODE};
+                break;
+            case ONLY_PRIVATESEND_COLLATERAL:
+                vecCoinTypes = {CWalletCoinIndex::COIN_TYPE_COLLATERAL};
+                break;
+            default:
+                vecCoinTypes = {CWalletCoinIndex::COIN_TYPE_OTHER, CWalletCoinIndex::COIN_TYPE_DENOMINATED,
+                                CWalletCoinIndex::COIN_TYPE_COLLATERAL, CWalletCoinIndex::COIN_TYPE_MASTERNODE};
+                break;
+        }
+
+        for (int nType : vecCoinTypes) {
+            coinIndex.ForEachCoin(nType, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+                AddAvailableCoin(vCoins, outpoint, fOnlySafe, coinControl, fIncludeZeroValue, nCoinType == ONLY_1000, fUseInstantSend);
+            });
+        }
+
+        // Return coins in the same order as a walk over mapWallet would
+        std::sort(vCoins.begin(), vCoins.end(), [](const COutput& a, const COutput& b) {
+            return a.tx->GetHash() < b.tx->GetHash() || (a.tx->GetHash() == b.tx->GetHash() && a.i < b.i);
+        });
     }
 }
 
@@ -3037,6 +3196,7 @@ bool CWallet::SelectPSInOutPairsByDenominations(int nDenom, CAmount nValueMin, C
 bool CWallet::SelectCoinsGroupedByAddresses(std::vector<CompactTallyItem>& vecTallyRet, bool fSkipDenominated, bool fAnonymizable, bool fSkipUnconfirmed, int nMaxOupointsPerAddress) const
 {
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
 
     isminefilter filter = ISMINE_SPENDABLE;
 
@@ -3056,12 +3216,37 @@ bool CWallet::SelectCoinsGroupedByAddresses(std::vector<CompactTallyItem>& vecTa
 
     CAmount nSmallestDenom = CPrivateSend::GetSmallestDenomination();
 
+    // Only visit the kinds of outputs we are going to tally
+    std::vector<int> vecCoinTypes{CWalletCoinIndex::COIN_TYPE_OTHER};
+    if (!fSkipDenominated) {
+        vecCoinTypes.push_back(CWalletCoinIndex::COIN_TYPE_DENOMINATED);
+    }
+    if (!fAnonymizable) {
+        // collaterals are never anonymizable
+        vecCoinTypes.push_back(CWalletCoinIndex::COIN_TYPE_COLLATERAL);
+    }
+    if (!fAnonymizable || !fMasternodeMode) {
+        vecCoinTypes.push_back(CWalletCoinIndex::COIN_TYPE_MASTERNODE);
+    }
+
+    std::vector<std::pair<COutPoint, const CWalletCoinIndex::CoinKey*> > vecCandidates;
+    for (int nType : vecCoinTypes) {
+        coinIndex.ForEachCoin(nType, [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+            if (key.dest.type() == typeid(CNoDestination)) return;
+            // ignore outputs that are 10 times smaller then the smallest denomination
+            // otherwise they will just lead to higher fee / lower priority
+            if (fAnonymizable && key.nValue <= nSmallestDenom/10) return;
+            vecCandidates.emplace_back(outpoint, &key);
+        });
+    }
+    // keep the outpoint order of vecOutPoints, it matters when nMaxOupointsPerAddress is set
+    std::sort(vecCandidates.begin(), vecCandidates.end());
+
     // Tally
     std::map<CTxDestination, CompactTallyItem> mapTally;
-    std::set<uint256> setWalletTxesCounted;
-    for (const auto& outpoint : setWalletUTXO) {
-
-        if (!setWalletTxesCounted.emplace(outpoint.hash).second) continue;
+    for (const auto& candidate : vecCandidates) {
+        const COutPoint& outpoint = candidate.first;
+        const CWalletCoinIndex::CoinKey& key = *candidate.second;
 
         std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
         if (it == mapWallet.end()) continue;
@@ -3071,38 +3256,23 @@ bool CWallet::SelectCoinsGroupedByAddresses(std::vector<CompactTallyItem>& vecTa
         if(wtx.IsCoinBase() && wtx.GetBlocksToMaturity() > 0) continue;
         if(fSkipUnconfirmed && !wtx.IsTrusted()) continue;
 
-        for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
-            CTxDestination txdest;
-            if (!ExtractDestination(wtx.tx->vout[i].scriptPubKey, txdest)) continue;
-
-            isminefilter mine = ::IsMine(*this, txdest);
-            if(!(mine & filter)) continue;
-
-            auto itTallyItem = mapTally.find(txdest);
-            if (nMaxOupointsPerAddress != -1 && itTallyItem != mapTally.end() && itTallyItem->second.vecOutPoints.size() >= nMaxOupointsPerAddress) continue;
+        isminefilter mine = ::IsMine(*this, key.dest);
+        if(!(mine & filter)) continue;
 
-            if(IsSpent(outpoint.hash, i) || IsLockedCoin(outpoint.hash, i)) continue;
+        auto itTallyItem = mapTally.find(key.dest);
+        if (nMaxOupointsPerAddress != -1 && itTallyItem != mapTally.end() && itTallyItem->second.vecOutPoints.size() >= nMaxOupointsPerAddress) continue;
 
-            if(fSkipDenominated && CPrivateSend::IsDenominatedAmount(wtx.tx->vout[i].nValue)) continue;
+        if(IsSpent(outpoint.hash, outpoint.n) || IsLockedCoin(outpoint.hash, outpoint.n)) continue;
 
-            if(fAnonymizable) {
-                // ignore collaterals
-                if(CPrivateSend::IsCollateralAmount(wtx.tx->vout[i].nValue)) continue;
-                if(fMasternodeMode && wtx.tx->vout[i].nValue == 1000*COIN) continue;
-                // ignore outputs that are 10 times smaller then the smallest denomination
-                // otherwise they will just lead to higher fee / lower priority
-                if(wtx.tx->vout[i].nValue <= nSmallestDenom/10) continue;
-                // ignore anonymized
-                if(GetCappedOutpointPrivateSendRounds(COutPoint(outpoint.hash, i)) >= privateSendClient.nPrivateSendRounds) continue;
-            }
+        // ignore anonymized
+        if(fAnonymizable && key.nRounds >= privateSendClient.nPrivateSendRounds) continue;
 
-            if (itTallyItem == mapTally.end()) {
-                itTallyItem = mapTally.emplace(txdest, CompactTallyItem()).first;
-                itTallyItem->second.txdest = txdest;
-            }
-            itTallyItem->second.nAmount += wtx.tx->vout[i].nValue;
-            itTallyItem->second.vecOutPoints.emplace_back(outpoint.hash, i);
+        if (itTallyItem == mapTally.end()) {
+            itTallyItem = mapTally.emplace(key.dest, CompactTallyItem()).first;
+            itTallyItem->second.txdest = key.dest;
         }
+        itTallyItem->second.nAmount += key.nValue;
+        itTallyItem->second.vecOutPoints.emplace_back(outpoint);
     }
 
     // construct resulting vector
@@ -3143,28 +3313,41 @@ bool CWallet::SelectPrivateCoins(CAmount nValueMin, CAmount nValueMax, std::vect
     nValueRet = 0;
 
     std::vector<COutput> vCoins;
-    AvailableCoins(vCoins, true, coinControl, false, nPrivateSendRoundsMin < 0 ? ONLY_NONDENOMINATED : ONLY_DENOMINATED);
+    {
+        LOCK2(cs_main, cs_wallet);
+        UpdateWalletUTXOs();
+
+        // Rounds are capped by the current settings, translate the requested range into real rounds
+        int nRoundsCap = privateSendClient.nPrivateSendRounds;
+        int nRealRoundsMax = nPrivateSendRoundsMax >= nRoundsCap ? std::numeric_limits<int>::max() : nPrivateSendRoundsMax;
+        auto addCoin = [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
+            //do not allow inputs less than 1/10th of minimum value
+            if(key.nValue < nValueMin/10) return;
+            if(key.nValue > nValueMax) return;
+            AddAvailableCoin(vCoins, outpoint, true, coinControl, false, false, false);
+        };
+
+        if (nPrivateSendRoundsMin < 0) {
+            // non-denominated inputs, collaterals are never selected
+            if (nPrivateSendRoundsMin <= -2 && nPrivateSendRoundsMax >= -2) {
+                coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_OTHER, addCoin);
+                if (!fMasternodeMode) {
+                    coinIndex.ForEachCoin(CWalletCoinIndex::COIN_TYPE_MASTERNODE, addCoin);
+                }
+            }
+        } else if (nPrivateSendRoundsMin <= nRoundsCap) {
+            coinIndex.ForEachCoinInRounds(CWalletCoinIndex::COIN_TYPE_DENOMINATED, nPrivateSendRoundsMin, nRealRoundsMax, addCoin);
+        }
+    }
 
     //order the array so largest nondenom are first, then denominations, then very small inputs.
     std::sort(vCoins.rbegin(), vCoins.rend(), CompareByPriority());
 
     for (const auto& out : vCoins)
     {
-        //do not allow inputs less than 1/10th of minimum value
-        if(out.tx->tx->vout[out.i].nValue < nValueMin/10) continue;
-        //do not allow collaterals to be selected
-        if(CPrivateSend::IsCollateralAmount(out.tx->tx->vout[out.i].nValue)) continue;
-        if(fMasternodeMode && out.tx->tx->vout[out.i].nValue == 1000*COIN) continue; //masternode input
-
         if(nValueRet + out.tx->tx->vout[out.i].nValue <= nValueMax){
-            CTxIn txin = CTxIn(out.tx->GetHash(),out.i);
-
-            int nRounds = GetCappedOutpointPrivateSendRounds(txin.prevout);
-            if(nRounds > nPrivateSendRoundsMax) continue;
-            if(nRounds < nPrivateSendRoundsMin) continue;
-
             nValueRet += out.tx->tx->vout[out.i].nValue;
-            vecTxInRet.push_back(txin);
+            vecTxInRet.emplace_back(out.tx->GetHash(), out.i);
         }
     }
 
@@ -3251,15 +3434,15 @@ int CWallet::CountInputsWithAmount(CAmount nInputAmount) const
     CAmount nTotal = 0;
 
     LOCK2(cs_main, cs_wallet);
+    UpdateWalletUTXOs();
 
-    for (const auto& outpoint : setWalletUTXO) {
+    coinIndex.ForEachCoin(CWalletCoinIndex::GetCoinType(nInputAmount), [&](const COutPoint& outpoint, const CWalletCoinIndex::CoinKey& key) {
         const auto it = mapWallet.find(outpoint.hash);
-        if (it == mapWallet.end()) continue;
-        if (it->second.tx->vout[outpoint.n].nValue != nInputAmount) continue;
-        if (it->second.GetDepthInMainChain() < 0) continue;
+        if (it == mapWallet.end()) return;
+        if (it->second.GetDepthInMainChain() < 0) return;
 
         nTotal++;
-    }
+    }, nInputAmount);
 
     return nTotal;
 }
@@ -3901,7 +4084,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
         for (auto& pair : mapWallet) {
             for(unsigned int i = 0; i < pair.second.tx->vout.size(); ++i) {
                 if (IsMine(pair.second.tx->vout[i]) && !IsSpent(pair.first, i)) {
-                    setWalletUTXO.insert(COutPoint(pair.first, i));
+                    AddWalletUTXO(COutPoint(pair.first, i), pair.second.tx->vout[i]);
                 }
             }
         }
@@ -3941,8 +4124,18 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
     AssertLockHeld(cs_wallet); // mapWallet
     vchDefaultKey = CPubKey();
     DBErrors nZapSelectTxRet = CWalletDB(strWalletFile,"cr+").ZapSelectTx(vHashIn, vHashOut);
-    for (uint256 hash : vHashOut)
-        mapWallet.erase(hash);
+    for (uint256 hash : vHashOut) {
+        std::map<uint256, CWalletTx>::iterator it = mapWallet.find(hash);
+        if (it == mapWallet.end())
+            continue;
+        CTransactionRef tx = it->second.tx;
+        mapWallet.erase(it);
+        for (unsigned int i = 0; i < tx->vout.size(); i++) {
+            setWalletUTXO.erase(COutPoint(hash, i));
+            coinIndex.Remove(COutPoint(hash, i));
+        }
+        AddUnspentPrevouts(*tx);
+    }
 
     if (nZapSelectTxRet == DB_NEED_REWRITE)
     {
@@ -4544,6 +4737,7 @@ void CWallet::LockCoin(const COutPoint& output)
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 }
 
 void CWallet::UnlockCoin(const COutPoint& output)
@@ -4555,6 +4749,7 @@ void CWallet::UnlockCoin(const COutPoint& output)
 
     fAnonymizableTallyCached = false;
     fAnonymizableTallyCachedNonDenom = false;
+    InvalidateBalanceCache();
 }
 
 void CWallet::UnlockAllCoins()
@@ -4586,6 +4781,7 @@ void CWallet::ListProTxCoins(std::vector<COutPoint>& vOutpts)
     auto mnList = deterministicMNManager->GetListAtChainTip();
 
     AssertLockHeld(cs_wallet);
+    UpdateWalletUTXOs();
     for (const auto &o : setWalletUTXO) {
         if (mapWallet.count(o.hash)) {
             const auto &p = mapWallet[o.hash];
@@ -4828,6 +5024,7 @@ std::string CWallet::GetWalletHelpString(bool showDebug)
     {
         strUsage += HelpMessageGroup(_("Wallet debugging/testing options:"));
 
+        strUsage += HelpMessageOpt("-checkbalancecache", strprintf("Compare cached wallet balances against a full wallet scan on every call (default: %u)", DEFAULT_CHECK_BALANCE_CACHE));
         strUsage += HelpMessageOpt("-dblogsize=<n>", strprintf("Flush wallet database activity from memory to disk log every <n> megabytes (default: %u)", DEFAULT_WALLET_DBLOGSIZE));
         strUsage += HelpMessageOpt("-flushwallet", strprintf("Run a thread to flush wallet periodically (default: %u)", DEFAULT_FLUSHWALLET));
         strUsage += HelpMessageOpt("-privdb", strprintf("Sets the DB_PRIVATE flag in the wallet db environment (default: %u)", DEFAULT_WALLET_PRIVDB));
@@ -5161,6 +5358,7 @@ bool CWallet::ParameterInteraction()
     }
     nTxConfirmTarget = GetArg("-txconfirmtarget", DEFAULT_TX_CONFIRM_TARGET);
     bSpendZeroConfChange = GetBoolArg("-spendzeroconfchange", DEFAULT_SPEND_ZEROCONF_CHANGE);
+    fCheckBalanceCache = GetBoolArg("-checkbalancecache", DEFAULT_CHECK_BALANCE_CACHE);
 
     if (IsArgSet("-walletbackupsdir")) {
         if (!fs::is_directory(GetArg("-walletbackupsdir", ""))) {
@@ -5364,12 +5562,17 @@ void CWallet::NotifyTransactionLock(const CTransaction &tx, const llmq::CInstant
     // Only notify UI if this transaction is in this wallet
     std::map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(tx.GetHash());
     if (mi != mapWallet.end()){
+        InvalidateBalanceCache();
         NotifyISLockReceived();
     }
 }
 
 void CWallet::NotifyChainLock(const CBlockIndex* pindexChainLock, const llmq::CChainLockSig& clsig)
 {
+    {
+        LOCK(cs_wallet);
+        InvalidateBalanceCache();
+    }
     NotifyChainLockReceived(pindexChainLock->nHeight);
 }
 
@@ -16,6 +16,7 @@
 #include "utilstrencodings.h"
 #include "validationinterface.h"
 #include "script/ismine.h"
+#include "wallet/coinindex.h"
 #include "wallet/crypter.h"
 #include "wallet/walletdb.h"
 #include "wallet/rpcwallet.h"
@@ -25,6 +26,7 @@
 #include <algorithm>
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <map>
 #include <set>
 #include <stdexcept>
@@ -42,6 +44,7 @@ extern CFeeRate payTxFee;
 extern unsigned int nTxConfirmTarget;
 extern bool bSpendZeroConfChange;
 extern bool bBIP69Enabled;
+extern bool fCheckBalanceCache;
 
 static const unsigned int DEFAULT_KEYPOOL_SIZE = 1000;
 //! -paytxfee default
@@ -62,6 +65,8 @@ static const bool DEFAULT_SPEND_ZEROCONF_CHANGE = true;
 static const bool DEFAULT_WALLET_REJECT_LONG_CHAINS = false;
 //! -txconfirmtarget default
 static const unsigned int DEFAULT_TX_CONFIRM_TARGET = 6;
+//! -checkbalancecache default
+static const bool DEFAULT_CHECK_BALANCE_CACHE = false;
 static const bool DEFAULT_WALLETBROADCAST = true;
 static const bool DEFAULT_DISABLE_WALLET = false;
 
@@ -699,6 +704,28 @@ private:
     mutable bool fAnonymizableTallyCachedNonDenom;
     mutable std::vector<CompactTallyItem> vecAnonymizableTallyCachedNonDenom;
 
+    enum BalanceType {
+        BALANCE_AVAILABLE,
+        BALANCE_UNCONFIRMED,
+        BALANCE_IMMATURE,
+        BALANCE_ANONYMIZED,
+        BALANCE_DENOMINATED_CONFIRMED,
+        BALANCE_DENOMINATED_UNCONFIRMED,
+    };
+
+    /**
+     * Balances by type and IsMine filter, valid until the wallet changes (see InvalidateBalanceCache)
+     * or the chain tip, the wallet transactions in the mempool or the PrivateSend rounds setting do.
+     */
+    mutable std::map<std::pair<BalanceType, isminefilter>, CAmount> mapBalanceCache;
+    mutable uint256 hashBalanceCacheTip;
+    mutable unsigned int nBalanceCacheMempoolRemoved;
+    mutable int nBalanceCachePrivateSendRounds;
+
+    /* Return the cached balance or run computeBalance (a full scan) to fill the cache */
+    CAmount GetCachedBalance(BalanceType type, isminefilter filter, const std::function<CAmount()>& computeBalance) const;
+    void InvalidateBalanceCache();
+
     /**
      * Used to keep track of spent outpoints, and
      * detect and report conflicts (double-spends or
@@ -709,7 +736,20 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid);
     void AddToSpends(const uint256& wtxid);
 
-    std::set<COutPoint> setWalletUTXO;
+    mutable std::set<COutPoint> setWalletUTXO;
+    /* Same outputs as setWalletUTXO, ordered by coin type, amount, PrivateSend rounds and destination */
+    mutable CWalletCoinIndex coinIndex;
+    /* Keys or scripts were added, outputs of transactions already in the wallet may have become ours */
+    mutable bool fWalletUTXOsStale;
+
+    /* Add an unspent output to setWalletUTXO and coinIndex */
+    void AddWalletUTXO(const COutPoint& outpoint, const CTxOut& txout) const;
+    /* Add outputs which became ours since their transaction was added to setWalletUTXO and coinIndex, if fWalletUTXOsStale */
+    void UpdateWalletUTXOs() const;
+    /* Add the wallet outputs spent by tx back to setWalletUTXO and coinIndex if nothing else spends them */
+    void AddUnspentPrevouts(const CTransaction& tx);
+    /* Append outpoint to vCoins if it passes the AvailableCoins checks */
+    void AddAvailableCoin(std::vector<COutput>& vCoins, const COutPoint& outpoint, bool fOnlySafe, const CCoinControl *coinControl, bool fIncludeZeroValue, bool fIncludeLocked, bool fUseInstantSend) const;
 
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
@@ -813,8 +853,13 @@ public:
         fScanningWallet = false;
         fAnonymizableTallyCached = false;
         fAnonymizableTallyCachedNonDenom = false;
+        fWalletUTXOsStale = false;
         vecAnonymizableTallyCached.clear();
         vecAnonymizableTallyCachedNonDenom.clear();
+        mapBalanceCache.clear();
+        hashBalanceCacheTip.SetNull();
+        nBalanceCacheMempoolRemoved = 0;
+        nBalanceCachePrivateSendRounds = 0;
     }
 
     std::map<uint256, CWalletTx> mapWallet;
@@ -45,3 +45,13 @@ bool CZMQAbstractNotifier::NotifyInstantSendDoubleSpendAttempt(const CTransactio
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyRecoveredSig(const llmq::CRecoveredSig& /*recoveredSig*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyMasternodeListChanged(bool /*undo*/, const CDeterministicMNListDiff& /*diff*/)
+{
+    return true;
+}
@@ -8,6 +8,7 @@
 #include "zmqconfig.h"
 
 class CBlockIndex;
+class CDeterministicMNListDiff;
 class CGovernanceObject;
 class CGovernanceVote;
 class CZMQAbstractNotifier;
@@ -15,6 +16,7 @@ class CZMQAbstractNotifier;
 namespace llmq {
     class CChainLockSig;
     class CInstantSendLock;
+    class CRecoveredSig;
 }
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
@@ -46,6 +48,8 @@ public:
     virtual bool NotifyGovernanceVote(const CGovernanceVote &vote);
     virtual bool NotifyGovernanceObject(const CGovernanceObject &object);
     virtual bool NotifyInstantSendDoubleSpendAttempt(const CTransaction &currentTx, const CTransaction &previousTx);
+    virtual bool NotifyRecoveredSig(const llmq::CRecoveredSig &recoveredSig);
+    virtual bool NotifyMasternodeListChanged(bool undo, const CDeterministicMNListDiff &diff);
 
 
 protected:
@@ -6,6 +6,7 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include "validationinterface.h"
+#include "llmq/quorums_signing.h"
 #include <string>
 #include <map>
 #include <list>
@@ -13,7 +14,10 @@
 class CBlockIndex;
 class CZMQAbstractNotifier;
 
-class CZMQNotificationInterface : public CValidationInterface
+/** Default for -zmqpubqueuesize, messages waiting for the ZMQ sender thread */
+static const int DEFAULT_ZMQ_PUBLISH_QUEUE_SIZE = 10000;
+
+class CZMQNotificationInterface : public CValidationInterface, public llmq::CRecoveredSigsListener
 {
 public:
     virtual ~CZMQNotificationInterface();
@@ -34,6 +38,11 @@ protected:
     void NotifyGovernanceVote(const CGovernanceVote& vote) override;
     void NotifyGovernanceObject(const CGovernanceObject& object) override;
     void NotifyInstantSendDoubleSpendAttempt(const CTransaction &currentTx, const CTransaction &previousTx) override;
+    void NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff) override;
+
+public:
+    // CRecoveredSigsListener
+    void HandleNewRecoveredSig(const llmq::CRecoveredSig& recoveredSig) override;
 
 
 private:
@@ -8,6 +8,14 @@
 #include "validation.h"
 #include "util.h"
 
+#include "evo/deterministicmns.h"
+#include "llmq/quorums_signing.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
 static const char *MSG_HASHBLOCK     = "hashblock";
@@ -20,6 +28,8 @@ static const char *MSG_HASHISCON     = "hashinstantsenddoublespend";
 static const char *MSG_RAWBLOCK      = "rawblock";
 static const char *MSG_RAWCHAINLOCK  = "rawchainlock";
 static const char *MSG_RAWCLSIG      = "rawchainlocksig";
+static const char *MSG_RAWRECSIG     = "rawrecoveredsig";
+static const char *MSG_RAWMNLISTDIFF = "rawmnlistdiff";
 static const char *MSG_RAWTX         = "rawtx";
 static const char *MSG_RAWTXLOCK     = "rawtxlock";
 static const char *MSG_RAWTXLOCKSIG  = "rawtxlocksig";
@@ -70,6 +80,148 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+struct CZMQPendingMessage
+{
+    void *psocket;
+    const char *command;
+    std::shared_ptr<const std::string> data;
+    uint32_t nSequence;
+};
+
+static std::mutex csPublishQueue;
+static std::condition_variable condPublishQueue;
+static std::condition_variable condPublishQueueEmpty;
+static std::deque<CZMQPendingMessage> publishQueue;
+static size_t nMaxPublishQueueSize = 0;
+static bool fSending = false;
+static bool fSenderRunning = false;
+static bool fStopSender = false;
+static std::thread threadSender;
+
+static void ThreadZMQSender()
+{
+    std::unique_lock<std::mutex> lock(csPublishQueue);
+    while (true)
+    {
+        condPublishQueue.wait(lock, [] { return fStopSender || !publishQueue.empty(); });
+        if (publishQueue.empty())
+            break; // stopping and everything has been sent
+
+        CZMQPendingMessage msg = std::move(publishQueue.front());
+        publishQueue.pop_front();
+        fSending = true;
+        lock.unlock();
+
+        unsigned char msgseq[sizeof(uint32_t)];
+        WriteLE32(&msgseq[0], msg.nSequence);
+        zmq_send_multipart(msg.psocket, msg.command, strlen(msg.command), msg.data->data(), msg.data->size(), msgseq, (size_t)sizeof(uint32_t), (void*)0);
+
+        lock.lock();
+        fSending = false;
+        if (publishQueue.empty())
+            condPublishQueueEmpty.notify_all();
+    }
+}
+
+// Wait until nothing refers to any socket anymore, so sockets can be closed
+static void WaitForPublishQueue()
+{
+    std::unique_lock<std::mutex> lock(csPublishQueue);
+    condPublishQueueEmpty.wait(lock, [] { return !fSenderRunning || (publishQueue.empty() && !fSending); });
+}
+
+void CZMQAbstractPublishNotifier::StartSenderThread(size_t nMaxQueueSize)
+{
+    std::unique_lock<std::mutex> lock(csPublishQueue);
+    assert(!fSenderRunning);
+    nMaxPublishQueueSize = nMaxQueueSize;
+    fSenderRunning = true;
+    fStopSender = false;
+    threadSender = std::thread(&TraceThread<void (*)()>, "zmqpub", &ThreadZMQSender);
+}
+
+void CZMQAbstractPublishNotifier::StopSenderThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(csPublishQueue);
+        if (!fSenderRunning || fStopSender)
+            return;
+        fStopSender = true;
+        condPublishQueue.notify_all();
+    }
+    threadSender.join();
+    std::unique_lock<std::mutex> lock(csPublishQueue);
+    fSenderRunning = false;
+    condPublishQueueEmpty.notify_all();
+}
+
+// rawblock, rawchainlock and rawchainlocksig all publish the same block, which is only read and serialized once
+static std::mutex csLastBlock;
+static uint256 hashLastBlock;
+static std::shared_ptr<const std::string> lastBlockData;
+
+static std::shared_ptr<const std::string> GetSerializedBlock(const CBlockIndex *pindex)
+{
+    {
+        std::unique_lock<std::mutex> lock(csLastBlock);
+        if (lastBlockData && hashLastBlock == pindex->GetBlockHash())
+            return lastBlockData;
+    }
+
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    {
+        LOCK(cs_main);
+        CBlock block;
+        if(!ReadBlockFromDisk(block, pindex, consensusParams))
+        {
+            zmqError("Can't read block from disk");
+            return nullptr;
+        }
+
+        ss << block;
+    }
+
+    auto data = std::make_shared<const std::string>(ss.str());
+    std::unique_lock<std::mutex> lock(csLastBlock);
+    hashLastBlock = pindex->GetBlockHash();
+    lastBlockData = data;
+    return data;
+}
+
+// same for rawtx, rawtxlock and rawtxlocksig
+static std::mutex csLastTx;
+static uint256 hashLastTx;
+static std::shared_ptr<const std::string> lastTxData;
+
+static std::shared_ptr<const std::string> GetSerializedTransaction(const CTransaction &transaction)
+{
+    {
+        std::unique_lock<std::mutex> lock(csLastTx);
+        if (lastTxData && hashLastTx == transaction.GetHash())
+            return lastTxData;
+    }
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << transaction;
+
+    auto data = std::make_shared<const std::string>(ss.str());
+    std::unique_lock<std::mutex> lock(csLastTx);
+    hashLastTx = transaction.GetHash();
+    lastTxData = data;
+    return data;
+}
+
+template <typename T>
+static std::shared_ptr<const std::string> AppendSerialized(const std::shared_ptr<const std::string>& data, const T& obj)
+{
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << obj;
+    auto ret = std::make_shared<std::string>(*data);
+    ret->append(ss.begin(), ss.end());
+    return ret;
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -130,6 +282,8 @@ void CZMQAbstractPublishNotifier::Shutdown()
 
     if (count == 1)
     {
+        WaitForPublishQueue();
+
         LogPrint(BCLog::ZMQ, "Close socket at address %s\n", address);
         int linger = 0;
         zmq_setsockopt(psocket, ZMQ_LINGER, &linger, sizeof(linger));
@@ -140,19 +294,29 @@ void CZMQAbstractPublishNotifier::Shutdown()
 }
 
 bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* data, size_t size)
+{
+    return SendMessage(command, std::make_shared<const std::string>((const char*)data, size));
+}
+
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const std::shared_ptr<const std::string>& data)
 {
     assert(psocket);
 
-    /* send three parts, command & data & a LE 4byte sequence number */
-    unsigned char msgseq[sizeof(uint32_t)];
-    WriteLE32(&msgseq[0], nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), (void*)0);
-    if (rc == -1)
-        return false;
+    std::unique_lock<std::mutex> lock(csPublishQueue);
 
-    /* increment memory only sequence number after sending */
-    nSequence++;
+    /* increment memory only sequence number, also for dropped messages. Notifications can come
+       from several threads, this happens under csPublishQueue so sequence numbers are queued in order */
+    uint32_t nMsgSequence = nSequence++;
+    if (!fSenderRunning || fStopSender)
+        return false;
+    if (publishQueue.size() >= nMaxPublishQueueSize)
+    {
+        LogPrint(BCLog::ZMQ, "zmq: Publish queue full, dropping %s message %d\n", command, nMsgSequence);
+        return true;
+    }
 
+    publishQueue.push_back(CZMQPendingMessage{psocket, command, data, nMsgSequence});
+    condPublishQueue.notify_one();
     return true;
 }
 
@@ -234,92 +398,71 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-    }
+    auto data = GetSerializedBlock(pindex);
+    if (!data)
+        return false;
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, data);
 }
 
 bool CZMQPublishRawChainLockNotifier::NotifyChainLock(const CBlockIndex *pindex, const llmq::CChainLockSig& clsig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-    }
+    auto data = GetSerializedBlock(pindex);
+    if (!data)
+        return false;
 
-    return SendMessage(MSG_RAWCHAINLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWCHAINLOCK, data);
 }
 
 bool CZMQPublishRawChainLockSigNotifier::NotifyChainLock(const CBlockIndex *pindex, const llmq::CChainLockSig& clsig)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawchainlocksig %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
-        {
-            zmqError("Can't read block from disk");
-            return false;
-        }
-
-        ss << block;
-        ss << clsig;
-    }
+    auto data = GetSerializedBlock(pindex);
+    if (!data)
+        return false;
 
-    return SendMessage(MSG_RAWCLSIG, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWCLSIG, AppendSerialized(data, clsig));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTX, GetSerializedTransaction(transaction));
 }
 
 bool CZMQPublishRawTransactionLockNotifier::NotifyTransactionLock(const CTransaction &transaction, const llmq::CInstantSendLock& islock)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtxlock %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    return SendMessage(MSG_RAWTXLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWTXLOCK, GetSerializedTransaction(transaction));
 }
 
 bool CZMQPublishRawTransactionLockSigNotifier::NotifyTransactionLock(const CTransaction &transaction, const llmq::CInstantSendLock& islock)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtxlocksig %s\n", hash.GetHex());
+    return SendMessage(MSG_RAWTXLOCKSIG, AppendSerialized(GetSerializedTransaction(transaction), islock));
+}
+
+bool CZMQPublishRawRecoveredSigNotifier::NotifyRecoveredSig(const llmq::CRecoveredSig &recoveredSig)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawrecoveredsig %s\n", recoveredSig.GetHash().ToString());
     CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
-    ss << transaction;
-    ss << islock;
-    return SendMessage(MSG_RAWTXLOCKSIG, &(*ss.begin()), ss.size());
+    ss << recoveredSig;
+    return SendMessage(MSG_RAWRECSIG, &(*ss.begin()), ss.size());
+}
+
+bool CZMQPublishRawMasternodeListDiffNotifier::NotifyMasternodeListChanged(bool undo, const CDeterministicMNListDiff &diff)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish rawmnlistdiff %s, undo=%d\n", diff.blockHash.ToString(), undo);
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << diff;
+    ss << undo;
+    return SendMessage(MSG_RAWMNLISTDIFF, &(*ss.begin()), ss.size());
 }
 
 bool CZMQPublishRawGovernanceVoteNotifier::NotifyGovernanceVote(const CGovernanceVote &vote)
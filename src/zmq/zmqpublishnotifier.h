@@ -7,6 +7,8 @@
 
 #include "zmqabstractnotifier.h"
 
+#include <memory>
+
 class CBlockIndex;
 class CGovernanceVote;
 class CGovernanceObject;
@@ -14,17 +16,26 @@ class CGovernanceObject;
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
-    uint32_t nSequence; //!< upcounting per message sequence number
+    uint32_t nSequence; //!< upcounting per message sequence number, guarded by csPublishQueue
 
 public:
+    CZMQAbstractPublishNotifier() : nSequence(0) { }
 
-    /* send zmq multipart message
+    /* queue zmq multipart message for the sender thread
        parts:
           * command
           * data
           * message sequence number
+       messages which don't fit into the queue are dropped, but still use up a sequence
+       number, so subscribers can tell that they missed something
     */
     bool SendMessage(const char *command, const void* data, size_t size);
+    bool SendMessage(const char *command, const std::shared_ptr<const std::string>& data);
+
+    /* all sockets are only written to from a single sender thread, so notifications
+       never wait for zmq_send. StopSenderThread sends what is left in the queue */
+    static void StartSenderThread(size_t nMaxQueueSize);
+    static void StopSenderThread();
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
@@ -90,6 +101,18 @@ public:
     bool NotifyChainLock(const CBlockIndex *pindex, const llmq::CChainLockSig& clsig) override;
 };
 
+class CZMQPublishRawRecoveredSigNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyRecoveredSig(const llmq::CRecoveredSig &recoveredSig) override;
+};
+
+class CZMQPublishRawMasternodeListDiffNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyMasternodeListChanged(bool undo, const CDeterministicMNListDiff &diff) override;
+};
+
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier
 {
 public:
@@ -129,6 +129,17 @@ class AddressIndexTest(BitcoinTestFramework):
         assert_equal(len(txidsmany), 4)
         assert_equal(txidsmany[3], sent_txid)
 
+        # Check that txids can be paged through with a cursor
+        self.log.info("Testing paged txids...")
+        paged_txids = []
+        page = self.nodes[1].getaddresstxids({"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 3})
+        assert_equal(len(page["txids"]), 3)
+        paged_txids += page["txids"]
+        page = self.nodes[1].getaddresstxids({"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 3, "cursor": page["cursor"]})
+        assert("cursor" not in page)
+        paged_txids += page["txids"]
+        assert_equal(paged_txids, txidsmany)
+
         # Check that balances are correct
         self.log.info("Testing balances...")
         balance0 = self.nodes[1].getaddressbalance("93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB")
@@ -184,6 +195,20 @@ class AddressIndexTest(BitcoinTestFramework):
         deltasAll = self.nodes[1].getaddressdeltas({"addresses": [address2]})
         assert_equal(len(deltasAll), len(deltas))
 
+        # Check that paging through the deltas returns all of them in order
+        paged_deltas = []
+        cursor = None
+        while True:
+            params = {"addresses": [address2], "limit": 1}
+            if cursor is not None:
+                params["cursor"] = cursor
+            page = self.nodes[1].getaddressdeltas(params)
+            paged_deltas += page["deltas"]
+            if "cursor" not in page:
+                break
+            cursor = page["cursor"]
+        assert_equal(paged_deltas, deltasAll)
+
         # Check that deltas can be returned from range of block heights
         deltas = self.nodes[1].getaddressdeltas({"addresses": [address2], "start": 113, "end": 113})
         assert_equal(len(deltas), 1)
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# Copyright (c) 2019 The Dash Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#
+# Test the address summary index: getaddresssummary after sends and spends,
+# reorgs, restarts and the rebuild from the address index
+#
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import *
+from test_framework.mininode import COIN
+
+class AddressSummaryIndexTest(BitcoinTestFramework):
+
+    def __init__(self):
+        super().__init__()
+        self.setup_clean_chain = True
+        self.num_nodes = 2
+        self.index_args = ["-addressindex", "-addresssummaryindex"]
+
+    def setup_network(self):
+        self.nodes = []
+        # Node 0 is the miner, node 1 maintains the indexes
+        self.nodes.append(start_node(0, self.options.tmpdir))
+        self.nodes.append(start_node(1, self.options.tmpdir, self.index_args))
+        connect_nodes(self.nodes[0], 1)
+
+        self.is_network_split = False
+        self.sync_all()
+
+    def restart_node1(self, extra_args):
+        stop_node(self.nodes[1], 1)
+        self.nodes[1] = start_node(1, self.options.tmpdir, extra_args)
+        connect_nodes(self.nodes[0], 1)
+        sync_blocks(self.nodes)
+
+    def get_summaries(self, addresses):
+        summaries = self.nodes[1].getaddresssummary({"addresses": addresses})
+        assert "next" not in summaries
+        assert_equal([s["address"] for s in summaries["summaries"]], addresses)
+        return summaries["summaries"]
+
+    def check_summary(self, summary, balance, received, txcount, firstheight, lastheight):
+        assert_equal(summary["balance"], balance)
+        assert_equal(summary["received"], received)
+        assert_equal(summary["txcount"], txcount)
+        assert_equal(summary["firstheight"], firstheight)
+        assert_equal(summary["lastheight"], lastheight)
+        # getaddressbalance is served from the same summary
+        balance = self.nodes[1].getaddressbalance(summary["address"])
+        assert_equal(balance["balance"], summary["balance"])
+        assert_equal(balance["received"], summary["received"])
+
+    def run_test(self):
+        self.log.info("Mining blocks...")
+        self.nodes[0].generate(105)
+        self.sync_all()
+
+        address = self.nodes[1].getnewaddress()
+        unused = self.nodes[1].getnewaddress()
+        external = "yMNJePdcKvXtWWQnFYHNeJ5u8TF2v1dfK4"
+
+        self.log.info("Testing summaries after sends...")
+        self.nodes[0].sendtoaddress(address, 10)
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        address_summary, unused_summary = self.get_summaries([address, unused])
+        self.check_summary(address_summary, 10 * COIN, 10 * COIN, 1, 106, 106)
+        self.check_summary(unused_summary, 0, 0, 0, -1, -1)
+
+        self.log.info("Testing summaries after spending...")
+        # node 1 only has the coin received above, so all of it is spent
+        self.nodes[1].sendtoaddress(external, 4)
+        self.sync_all()
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        address_summary, external_summary = self.get_summaries([address, external])
+        self.check_summary(address_summary, 0, 10 * COIN, 2, 106, 107)
+        self.check_summary(external_summary, 4 * COIN, 4 * COIN, 1, 107, 107)
+        expected = self.get_summaries([address, external, unused])
+
+        self.log.info("Testing paging...")
+        page = self.nodes[1].getaddresssummary({"addresses": [address, external, unused], "limit": 2})
+        assert_equal(page["summaries"], expected[:2])
+        assert_equal(page["next"], 2)
+        page = self.nodes[1].getaddresssummary({"addresses": [address, external, unused], "start": page["next"]})
+        assert_equal(page["summaries"], expected[2:])
+        assert "next" not in page
+        assert_raises_jsonrpc(-8, "Invalid start or limit", self.nodes[1].getaddresssummary, {"addresses": [address], "limit": 0})
+
+        self.log.info("Testing reorgs...")
+        best_hash = self.nodes[1].getbestblockhash()
+        self.nodes[1].invalidateblock(best_hash)
+        address_summary, external_summary = self.get_summaries([address, external])
+        self.check_summary(address_summary, 10 * COIN, 10 * COIN, 1, 106, 106)
+        self.check_summary(external_summary, 0, 0, 0, -1, -1)
+
+        self.nodes[1].reconsiderblock(best_hash)
+        assert_equal(self.nodes[1].getbestblockhash(), best_hash)
+        assert_equal(self.get_summaries([address, external, unused]), expected)
+
+        self.log.info("Testing restarts...")
+        self.restart_node1(self.index_args)
+        assert_equal(self.get_summaries([address, external, unused]), expected)
+
+        self.log.info("Testing the rebuild from the address index...")
+        self.restart_node1(["-addressindex"])
+        assert_raises_jsonrpc(-5, "No information available for address", self.nodes[1].getaddresssummary, {"addresses": [external]})
+
+        # blocks connected while the summaries are disabled are picked up by the rebuild
+        self.nodes[0].sendtoaddress(external, 6)
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        self.restart_node1(self.index_args)
+        address_summary, external_summary = self.get_summaries([address, external])
+        self.check_summary(address_summary, 0, 10 * COIN, 2, 106, 107)
+        self.check_summary(external_summary, 10 * COIN, 10 * COIN, 2, 107, 108)
+        expected = self.get_summaries([address, external, unused])
+
+        self.log.info("Testing blocks connected again after the summaries...")
+        # the chainstate is rebuilt while the summaries stay at the tip, so every block is skipped
+        self.restart_node1(self.index_args + ["-reindex-chainstate"])
+        assert_equal(self.nodes[1].getblockcount(), 108)
+        assert_equal(self.get_summaries([address, external, unused]), expected)
+
+if __name__ == '__main__':
+    AddressSummaryIndexTest().main()
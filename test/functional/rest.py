@@ -328,5 +328,23 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(json_string)
         assert_equal(json_obj['bestblockhash'], bb_hash)
 
+        # masternode list and list diff
+        json_string = http_get_call(url.hostname, url.port, '/rest/mnlist/'+bb_hash+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['blockHash'], bb_hash)
+        assert_equal(len(json_obj['mnList']), 0)
+
+        genesis_hash = self.nodes[0].getblockhash(0)
+        json_string = http_get_call(url.hostname, url.port, '/rest/mnlistdiff/'+genesis_hash+'/'+bb_hash+self.FORMAT_SEPARATOR+'json')
+        assert_equal(json.loads(json_string), self.nodes[0].protx('diff', genesis_hash, bb_hash))
+        response = http_get_call(url.hostname, url.port, '/rest/mnlistdiff/'+genesis_hash+'/'+bb_hash+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+
+        # no ChainLocks or InstantSend locks without quorums
+        response = http_get_call(url.hostname, url.port, '/rest/chainlock'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/islock/'+txs[0]+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+
 if __name__ == '__main__':
     RESTTest ().main ()
@@ -77,6 +77,7 @@ BASE_SCRIPTS= [
     'signrawtransactions.py',
     'disconnect_ban.py',
     'addressindex.py',
+    'addresssummaryindex.py',
     'timestampindex.py',
     'spentindex.py',
     'decodescript.py',
@@ -23,8 +23,13 @@ class ZMQTest (BitcoinTestFramework):
         self.zmqSubSocket.setsockopt(zmq.SUBSCRIBE, b"hashblock")
         self.zmqSubSocket.setsockopt(zmq.SUBSCRIBE, b"hashtx")
         self.zmqSubSocket.connect("tcp://127.0.0.1:%i" % self.port)
+        # masternode list diffs are published on their own socket, so they don't interleave with the above
+        self.zmqMNListSocket = self.zmqContext.socket(zmq.SUB)
+        self.zmqMNListSocket.setsockopt(zmq.SUBSCRIBE, b"rawmnlistdiff")
+        self.zmqMNListSocket.connect("tcp://127.0.0.1:%i" % (self.port + 1))
         return start_nodes(self.num_nodes, self.options.tmpdir, extra_args=[
-            ['-zmqpubhashtx=tcp://127.0.0.1:'+str(self.port), '-zmqpubhashblock=tcp://127.0.0.1:'+str(self.port)],
+            ['-zmqpubhashtx=tcp://127.0.0.1:'+str(self.port), '-zmqpubhashblock=tcp://127.0.0.1:'+str(self.port),
+             '-zmqpubrawmnlistdiff=tcp://127.0.0.1:'+str(self.port + 1)],
             [],
             [],
             []
@@ -59,15 +64,23 @@ class ZMQTest (BitcoinTestFramework):
 
         zmqHashes = []
         blockcount = 0
+        txcount = 0
         for x in range(0,n*2):
             msg = self.zmqSubSocket.recv_multipart()
             topic = msg[0]
             body = msg[1]
+            msgSequence = struct.unpack('<I', msg[-1])[-1]
             if topic == b"hashblock":
                 zmqHashes.append(bytes_to_hex_str(body))
-                msgSequence = struct.unpack('<I', msg[-1])[-1]
                 assert_equal(msgSequence, blockcount+1)
                 blockcount += 1
+            else:
+                # every topic counts on its own, without gaps
+                assert_equal(topic, b"hashtx")
+                assert_equal(msgSequence, txcount+1)
+                txcount += 1
+        assert_equal(blockcount, n)
+        assert_equal(txcount, n)
 
         for x in range(0,n):
             assert_equal(genhashes[x], zmqHashes[x]) #blockhash from generate must be equal to the hash received over zmq
@@ -88,6 +101,45 @@ class ZMQTest (BitcoinTestFramework):
 
         assert_equal(hashRPC, hashZMQ) #blockhash from generate must be equal to the hash received over zmq
 
+        self.test_mnlistdiff()
+
+    def recv_mnlistdiff(self, sequence, blockhash, undo):
+        msg = self.zmqMNListSocket.recv_multipart()
+        assert_equal(msg[0], b"rawmnlistdiff")
+        body = msg[1]
+        msgSequence = struct.unpack('<I', msg[-1])[-1]
+        assert_equal(msgSequence, sequence)
+        # the diff starts with the previous and the current block hash and is followed by the undo flag
+        assert_equal(bytes_to_hex_str(body[32:64][::-1]), blockhash)
+        assert_equal(body[-1], 1 if undo else 0)
+
+    def test_mnlistdiff(self):
+        self.log.info("Testing rawmnlistdiff...")
+        node = self.nodes[0]
+        while node.getblockcount() < 432: # DIP3 activation height on regtest
+            node.generate(10)
+        self.sync_all()
+
+        # blocks which don't change the masternode list are not published
+        bls = node.bls('generate')
+        fundsAddr = node.getnewaddress()
+        node.sendtoaddress(fundsAddr, 1000.001)
+        ownerAddr = node.getnewaddress()
+        protx_hash = node.protx('register_fund', node.getnewaddress(), '127.0.0.1:%d' % p2p_port(self.num_nodes),
+                                ownerAddr, bls['public'], ownerAddr, 0, node.getnewaddress(), fundsAddr)
+        blockhash = node.generate(1)[0]
+        self.sync_all()
+        assert_equal(node.getrawtransaction(protx_hash, 1)['blockhash'], blockhash)
+        self.recv_mnlistdiff(0, blockhash, False)
+
+        # disconnecting the block publishes the inverse diff, reconnecting it the diff again
+        prevhash = node.getblockheader(blockhash)['previousblockhash']
+        node.invalidateblock(blockhash)
+        self.recv_mnlistdiff(1, prevhash, True)
+        node.reconsiderblock(blockhash)
+        self.recv_mnlistdiff(2, blockhash, False)
+        assert_equal(node.getbestblockhash(), blockhash)
+
 
 if __name__ == '__main__':
     ZMQTest ().main ()